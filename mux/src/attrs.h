@@ -233,7 +233,8 @@
 #define A_CONFORMAT  242
 #define A_NAMEFORMAT 243
 #define A_DESCFORMAT 244
-// 245 - 249 unused
+#define A_CPUMAX     245 // CPU budget of one queue entry in milliseconds
+// 246 - 249 unused
 
 #ifdef REALITY_LVLS
 #define A_RLEVEL      250
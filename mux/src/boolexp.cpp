@@ -19,6 +19,12 @@
 
 static bool parsing_internal = false;
 
+// Set by the parser when the result depends on more than the lock text
+// itself (who is parsing it, or how large the database is at the moment).
+// Such locks are not kept in the compiled lock cache.
+//
+static bool parsing_volatile = false;
+
 /* ---------------------------------------------------------------------------
  * check_attr: indicate if attribute ATTR on player passes key when checked by
  * the object lockobj
@@ -26,11 +32,10 @@ static bool parsing_internal = false;
 
 static bool check_attr(dbref player, dbref lockobj, ATTR *attr, UTF8 *key)
 {
-    dbref aowner;
-    int aflags;
     bool bCheck = false;
 
-    UTF8 *buff = atr_pget(player, attr->number, &aowner, &aflags);
+    size_t nLen;
+    const UTF8 *buff = atr_pget_text_LEN(player, attr->number, &nLen);
 
     if (attr->number == A_LENTER)
     {
@@ -52,7 +57,6 @@ static bool check_attr(dbref player, dbref lockobj, ATTR *attr, UTF8 *key)
     {
         bCheck = false;
     }
-    free_lbuf(buff);
     return bCheck;
 }
 
@@ -66,7 +70,6 @@ bool eval_boolexp(dbref player, dbref thing, dbref from, BOOLEXP *b)
     dbref aowner, obj, source;
     int aflags;
     UTF8 *buff, *buff2, *bp;
-    UTF8 *key;
     ATTR *a;
     bool bCheck, c;
 
@@ -129,9 +132,7 @@ bool eval_boolexp(dbref player, dbref thing, dbref from, BOOLEXP *b)
             mudstate.lock_nest_lev--;
             return false;
         }
-        key = atr_get("boolexp.130", b->sub1->thing, A_LOCK, &aowner, &aflags);
-        c = eval_boolexp_atr(player, b->sub1->thing, from, key);
-        free_lbuf(key);
+        c = eval_boolexp_lock(player, player, b->sub1->thing, from, A_LOCK);
         mudstate.lock_nest_lev--;
         return c;
 
@@ -287,6 +288,126 @@ bool eval_boolexp_atr(dbref player, dbref thing, dbref from, UTF8 *key)
     return ret_value;
 }
 
+/* ---------------------------------------------------------------------------
+ * Compiled lock cache.
+ *
+ * Stored locks are parsed once per (object, lock attribute) and the tree is
+ * kept in mudstate.lock_htab until the attribute is written.  A tree may be
+ * in use by an evaluation which itself changes the lock (through an
+ * evaluation lock, for example), so entries count their users and a stale
+ * entry is only freed once the last one lets go.
+ */
+
+typedef struct lock_cache
+{
+    dbref    thing;
+    int      locknum;
+    BOOLEXP *b;
+    int      nRef;
+    bool     bStale;
+} LOCK_CACHE;
+
+static void lockcache_release(LOCK_CACHE *plc)
+{
+    plc->nRef--;
+    if (  plc->bStale
+       && 0 == plc->nRef)
+    {
+        free_boolexp(plc->b);
+        delete plc;
+    }
+}
+
+static void lockcache_drop(LOCK_CACHE *plc)
+{
+    int key[2] = { plc->thing, plc->locknum };
+    hashdeleteLEN(key, sizeof(key), &mudstate.lock_htab);
+    plc->bStale = true;
+    plc->nRef++;
+    lockcache_release(plc);
+}
+
+// An attribute on thing is about to change.
+//
+void lockcache_changed(dbref thing, int atr)
+{
+    if (mudstate.bfLockCache.IsSet(thing))
+    {
+        int key[2] = { thing, atr };
+        LOCK_CACHE *plc = (LOCK_CACHE *)hashfindLEN(key, sizeof(key), &mudstate.lock_htab);
+        if (nullptr != plc)
+        {
+            lockcache_drop(plc);
+        }
+    }
+}
+
+// Attribute names may have changed meaning.
+//
+void lockcache_flush(void)
+{
+    LOCK_CACHE *plc;
+    while (nullptr != (plc = (LOCK_CACHE *)hash_firstentry(&mudstate.lock_htab)))
+    {
+        lockcache_drop(plc);
+    }
+    mudstate.bfLockCache.ClearAll();
+}
+
+bool eval_boolexp_lock(dbref parser, dbref player, dbref thing, dbref from, int locknum)
+{
+    int key[2] = { thing, locknum };
+    LOCK_CACHE *plc = nullptr;
+    if (mudstate.bfLockCache.IsSet(thing))
+    {
+        plc = (LOCK_CACHE *)hashfindLEN(key, sizeof(key), &mudstate.lock_htab);
+    }
+
+    BOOLEXP *b;
+    if (nullptr != plc)
+    {
+        b = plc->b;
+    }
+    else
+    {
+        dbref aowner;
+        int   aflags;
+        UTF8 *text = atr_get("eval_boolexp_lock", thing, locknum, &aowner, &aflags);
+        parsing_volatile = false;
+        b = parse_boolexp(parser, text, true);
+        free_lbuf(text);
+
+        if (!parsing_volatile)
+        {
+            plc = new LOCK_CACHE;
+            plc->thing   = thing;
+            plc->locknum = locknum;
+            plc->b       = b;
+            plc->nRef    = 0;
+            plc->bStale  = false;
+            hashaddLEN(key, sizeof(key), plc, &mudstate.lock_htab);
+            mudstate.bfLockCache.Set(thing);
+        }
+    }
+
+    if (TRUE_BOOLEXP == b)
+    {
+        return true;
+    }
+
+    if (nullptr == plc)
+    {
+        bool bResult = eval_boolexp(player, thing, from, b);
+        free_boolexp(b);
+        return bResult;
+    }
+
+    plc->nRef++;
+    bool bResult = eval_boolexp(player, thing, from, b);
+    lockcache_release(plc);
+    return bResult;
+}
+
 // If the parser returns TRUE_BOOLEXP, you lose
 // TRUE_BOOLEXP cannot be typed in by the user; use @unlock instead
 //
@@ -341,6 +462,8 @@ static BOOLEXP *test_atr(UTF8 *s)
     ATTR *attrib = atr_str(buff);
     if (!attrib)
     {
+        parsing_volatile = true;
+
         // Only #1 can lock on numbers
         //
         if (!God(parse_player))
@@ -457,6 +580,7 @@ static BOOLEXP *parse_boolexp_L(void)
                 b->thing = mux_atol(&buf[1]);
                 if (!Good_dbref(b->thing))
                 {
+                    parsing_volatile = true;
                     free_lbuf(buf);
                     free_bool(b);
                     return TRUE_BOOLEXP;
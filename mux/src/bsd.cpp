@@ -21,6 +21,7 @@
 #include "attrs.h"
 #include "command.h"
 #include "file_c.h"
+#include "journal.h"
 #include "mathutil.h"
 #include "slave.h"
 
@@ -1325,14 +1326,10 @@ void shovechars(int nPorts, PortInfo aPorts[])
 
     HANDLE hCloseProc = CreateThread(nullptr, 0, ListenForCloseProc, nullptr, 0, nullptr);
 
-    CLinearTimeAbsolute ltaLastSlice;
-    ltaLastSlice.GetUTC();
-
     for (;;)
     {
         CLinearTimeAbsolute ltaCurrent;
         ltaCurrent.GetUTC();
-        update_quotas(ltaLastSlice, ltaCurrent);
 
         // Before processing a possible QUIT command, be sure to give the slave
         // a chance to report it's findings.
@@ -1410,9 +1407,6 @@ void shovechars(int nPorts, PortInfo aPorts[])
 
     mudstate.debug_cmd = T("< shovechars_select >");
 
-    CLinearTimeAbsolute ltaLastSlice;
-    ltaLastSlice.GetUTC();
-
 #ifdef HAVE_GETDTABLESIZE
     maxfds = getdtablesize();
 #else // HAVE_GETDTABLESIZE
@@ -1425,7 +1419,6 @@ void shovechars(int nPorts, PortInfo aPorts[])
     {
         CLinearTimeAbsolute ltaCurrent;
         ltaCurrent.GetUTC();
-        update_quotas(ltaLastSlice, ltaCurrent);
 
         // Check the scheduler.
         //
@@ -1655,6 +1648,7 @@ void shovechars(int nPorts, PortInfo aPorts[])
                         d1->flags &= ~DS_AUTODARK;
                     }
                     db[d->player].fs.word[FLAG_WORD1] &= ~DARK;
+                    db_dirty(d->player);
                 }
 
                 // Process received data.
@@ -2107,6 +2101,7 @@ void shutdownsock(DESC *d, int reason)
         d->player = 0;
         d->doing[0] = '\0';
         d->quota = mudconf.cmd_quota_max;
+        d->quota_time = d->connected_at;
         d->last_time = d->connected_at;
         d->input_tot = d->input_size;
         d->output_tot = 0;
@@ -2119,6 +2114,7 @@ void shutdownsock(DESC *d, int reason)
         // Cancel any scheduled processing on this descriptor.
         //
         scheduler.CancelTask(Task_ProcessCommand, d, 0);
+        desc_stop_timers(d);
 
 #if defined(WINDOWS_NETWORKING)
         // Don't close down the socket twice.
@@ -2381,6 +2377,9 @@ DESC *initializesock(SOCKET s, MUX_SOCKADDR *msa)
     d->height = 24;
     d->width = 78;
     d->quota = mudconf.cmd_quota_max;
+    d->quota_time = d->connected_at;
+    d->idle_task = nullptr;
+    d->keepalive_task = nullptr;
     d->program_data = nullptr;
     d->address = *msa;
     msa->ntop(d->addr, sizeof(d->addr));
@@ -4820,6 +4819,7 @@ static void DCL_CDECL sighandler(int sig)
             // between unamed attributes and named ones. We go with what we
             // got.
             //
+            journal_close();
             dump_database_internal(DUMP_I_RESTART);
             SYNC;
             CLOSE;
@@ -5308,6 +5308,7 @@ void process_windows_tcp(DWORD dwTimeout)
                     d1->flags &= ~DS_AUTODARK;
                 }
                 db[d->player].fs.word[FLAG_WORD1] &= ~DARK;
+                db_dirty(d->player);
             }
 
             // process the player's input
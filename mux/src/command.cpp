@@ -18,6 +18,7 @@
 #include "command.h"
 #include "comsys.h"
 #include "functions.h"
+#include "journal.h"
 #include "mguests.h"
 #include "mathutil.h"
 #include "powers.h"
@@ -113,6 +114,7 @@ static NAMETAB cset_sw[] =
 static NAMETAB dbck_sw[] =
 {
     {T("full"),            1,  CA_WIZARD,  DBCK_FULL},
+    {T("index"),           1,  CA_WIZARD,  DBCK_INDEX},
     {(UTF8 *) nullptr,     0,          0,  0}
 };
 
@@ -529,6 +531,14 @@ static NAMETAB teleport_sw[] =
     {(UTF8 *) nullptr,     0,          0,  0}
 };
 
+static NAMETAB latency_sw[] =
+{
+    {T("log"),             1,  CA_WIZARD,  LATENCY_LOG | SW_MULTIPLE},
+    {T("reset"),           1,  CA_WIZARD,  LATENCY_RESET | SW_MULTIPLE},
+    {T("screen"),          1,  CA_WIZARD,  LATENCY_SCREEN | SW_MULTIPLE},
+    {(UTF8 *) nullptr,     0,          0,  0}
+};
+
 static NAMETAB timecheck_sw[] =
 {
     {T("log"),             1,  CA_WIZARD,  TIMECHK_LOG | SW_MULTIPLE},
@@ -597,6 +607,7 @@ static CMDENT_NO_ARG command_table_no_arg[] =
     {T("@dbck"),       dbck_sw,    CA_WIZARD,   0,          CS_NO_ARGS, 0, do_dbck},
     {T("@dbclean"),    nullptr,    CA_GOD,      0,          CS_NO_ARGS, 0, do_dbclean},
     {T("@dump"),       dump_sw,    CA_WIZARD,   0,          CS_NO_ARGS, 0, do_dump},
+    {T("@latency"),    latency_sw, CA_WIZARD,   0,          CS_NO_ARGS, 0, do_latency},
     {T("@mark_all"),   markall_sw, CA_WIZARD,   MARK_SET,   CS_NO_ARGS, 0, do_markall},
     {T("@readcache"),  nullptr,    CA_WIZARD,   0,          CS_NO_ARGS, 0, do_readcache},
     {T("@restart"),    nullptr,    CA_NO_GUEST|CA_NO_SLAVE, 0, CS_NO_ARGS, 0, do_restart},
@@ -1279,6 +1290,429 @@ void process_hook_args(dbref executor, CMDENT *cmdp, UTF8* arg1, UTF8* arg2, UTF
 }
 
 
+/* ---------------------------------------------------------------------------
+ * Command latency.
+ *
+ * Each built-in command and each $-command attribute keeps a histogram of
+ * how long it took, in microseconds.  Buckets are log-linear: below
+ * LATENCY_SUB_COUNT microseconds every value has its own bucket, and above
+ * that each power of two is split into LATENCY_SUB_COUNT equal buckets, so a
+ * recorded value is never off by more than 1/LATENCY_SUB_COUNT.  Recording is
+ * a hash lookup and a few adds.
+ *
+ * Commands taking longer than slow_command_threshold are also written to a
+ * dedicated log (SlowLog) along with who ran them and from which attribute.
+ */
+
+#define LATENCY_SUB_BITS  3
+#define LATENCY_SUB_COUNT (1 << LATENCY_SUB_BITS)
+#define LATENCY_BUCKETS   ((33 - LATENCY_SUB_BITS) * LATENCY_SUB_COUNT)
+
+typedef struct cmd_latency
+{
+    UTF8   *pName;      // Command name, or nullptr for an attribute.
+    dbref   thing;
+    int     atr;
+    UINT32  nCount;
+    INT64   i64Total;   // Microseconds.
+    INT64   i64Max;     // Microseconds.
+    UINT32  aBuckets[LATENCY_BUCKETS];
+} CMD_LATENCY;
+
+static int latency_bucket(INT64 us)
+{
+    if (us < LATENCY_SUB_COUNT)
+    {
+        return (us < 0) ? 0 : static_cast<int>(us);
+    }
+
+    int iShift = 0;
+    while (  iShift < LATENCY_BUCKETS/LATENCY_SUB_COUNT - 2
+          && (static_cast<INT64>(LATENCY_SUB_COUNT) << (iShift + 1)) <= us)
+    {
+        iShift++;
+    }
+
+    int i = (iShift + 1) * LATENCY_SUB_COUNT
+          + static_cast<int>((us >> iShift) - LATENCY_SUB_COUNT);
+    return (i < LATENCY_BUCKETS) ? i : LATENCY_BUCKETS - 1;
+}
+
+// The largest value which falls into bucket i.
+//
+static INT64 latency_bucket_top(int i)
+{
+    if (i < LATENCY_SUB_COUNT)
+    {
+        return i;
+    }
+    int iShift = i / LATENCY_SUB_COUNT - 1;
+    INT64 i64Low = static_cast<INT64>(LATENCY_SUB_COUNT + i % LATENCY_SUB_COUNT) << iShift;
+    return i64Low + (static_cast<INT64>(1) << iShift) - 1;
+}
+
+static INT64 latency_percentile(CMD_LATENCY *pcl, int iPercent)
+{
+    UINT64 nTarget = (static_cast<UINT64>(pcl->nCount) * iPercent + 99) / 100;
+    UINT64 nSeen = 0;
+    for (int i = 0; i < LATENCY_BUCKETS; i++)
+    {
+        nSeen += pcl->aBuckets[i];
+        if (nTarget <= nSeen)
+        {
+            INT64 i64Top = latency_bucket_top(i);
+            return (i64Top < pcl->i64Max) ? i64Top : pcl->i64Max;
+        }
+    }
+    return pcl->i64Max;
+}
+
+// Built-in commands are keyed by name.  Attributes are keyed by
+// {-1, thing, atr}, which cannot collide with a name because 0xFF never
+// appears in UTF-8.
+//
+static CMD_LATENCY *latency_find(const UTF8 *pName, dbref thing, int atr)
+{
+    int aKey[3] = { -1, thing, atr };
+    const void *pKey;
+    size_t nKey;
+    if (nullptr != pName)
+    {
+        pKey = pName;
+        nKey = strlen(reinterpret_cast<const char *>(pName));
+    }
+    else
+    {
+        pKey = aKey;
+        nKey = sizeof(aKey);
+    }
+
+    CMD_LATENCY *pcl = (CMD_LATENCY *)hashfindLEN(pKey, nKey, &mudstate.latency_htab);
+    if (nullptr == pcl)
+    {
+        pcl = new CMD_LATENCY;
+        memset(pcl, 0, sizeof(CMD_LATENCY));
+        pcl->pName = (nullptr != pName) ? StringClone(pName) : nullptr;
+        pcl->thing = thing;
+        pcl->atr   = atr;
+        hashaddLEN(pKey, nKey, pcl, &mudstate.latency_htab);
+        if (nullptr == pName)
+        {
+            mudstate.bfLatency.Set(thing);
+        }
+    }
+    return pcl;
+}
+
+static void latency_delete(CMD_LATENCY *pcl)
+{
+    if (nullptr != pcl->pName)
+    {
+        hashdeleteLEN(pcl->pName, strlen(reinterpret_cast<char *>(pcl->pName)),
+            &mudstate.latency_htab);
+        MEMFREE(pcl->pName);
+    }
+    else
+    {
+        int aKey[3] = { -1, pcl->thing, pcl->atr };
+        hashdeleteLEN(aKey, sizeof(aKey), &mudstate.latency_htab);
+    }
+    delete pcl;
+}
+
+// The attribute thing/atr is being cleared, or all of thing's attributes
+// are (atr == 0).  Its histograms go with it, so that a recycled dbref or
+// attribute number starts with none.
+//
+void latency_forget(dbref thing, int atr)
+{
+    if (!mudstate.bfLatency.IsSet(thing))
+    {
+        return;
+    }
+
+    CMD_LATENCY *pcl;
+    if (0 != atr)
+    {
+        int aKey[3] = { -1, thing, atr };
+        pcl = (CMD_LATENCY *)hashfindLEN(aKey, sizeof(aKey), &mudstate.latency_htab);
+        if (nullptr != pcl)
+        {
+            latency_delete(pcl);
+        }
+        return;
+    }
+
+    mudstate.bfLatency.Clear(thing);
+    bool bFound;
+    do
+    {
+        bFound = false;
+        for (pcl = (CMD_LATENCY *)hash_firstentry(&mudstate.latency_htab);
+             nullptr != pcl;
+             pcl = (CMD_LATENCY *)hash_nextentry(&mudstate.latency_htab))
+        {
+            if (  nullptr == pcl->pName
+               && thing == pcl->thing)
+            {
+                latency_delete(pcl);
+                bFound = true;
+                break;
+            }
+        }
+    } while (bFound);
+}
+
+static void latency_record(CMD_LATENCY *pcl, INT64 us)
+{
+    pcl->nCount++;
+    pcl->i64Total += us;
+    if (pcl->i64Max < us)
+    {
+        pcl->i64Max = us;
+    }
+    pcl->aBuckets[latency_bucket(us)]++;
+}
+
+static const UTF8 *latency_name(CMD_LATENCY *pcl)
+{
+    if (nullptr != pcl->pName)
+    {
+        return pcl->pName;
+    }
+    ATTR *pattr = atr_num(pcl->atr);
+    return tprintf(T("#%d/%s"), pcl->thing, (nullptr != pattr) ? pattr->name : T("?"));
+}
+
+static void latency_start_log(void)
+{
+    static bool bStarted = false;
+    if (!bStarted)
+    {
+        bStarted = true;
+        SlowLog.StartLogging();
+        SlowLog.WriteString(T("# S time secs command executor enactor attribute text" ENDLINE));
+        SlowLog.WriteString(T("# H name count total_us max_us bucket_top_us:count..." ENDLINE));
+    }
+}
+
+static void latency_slow
+(
+    const UTF8 *pName,
+    dbref executor,
+    dbref enactor,
+    dbref thing,
+    int   atr,
+    CLinearTimeDelta ltd,
+    const UTF8 *pText
+)
+{
+    latency_start_log();
+
+    CLinearTimeAbsolute ltaNow;
+    ltaNow.GetLocal();
+    FIELDEDTIME ft;
+    ltaNow.ReturnFields(&ft);
+
+    const UTF8 *pAttr;
+    ATTR *pattr;
+    if (  Good_obj(thing)
+       && nullptr != (pattr = atr_num(atr)))
+    {
+        pAttr = tprintf(T("#%d/%s"), thing, pattr->name);
+    }
+    else
+    {
+        pAttr = T("-");
+    }
+
+    SlowLog.tinyprintf(T("S\t%d.%02d%02d:%02d%02d%02d\t%s\t%s\t#%d\t#%d\t%s\t%s" ENDLINE),
+        ft.iYear, ft.iMonth, ft.iDayOfMonth, ft.iHour, ft.iMinute, ft.iSecond,
+        ltd.ReturnSecondsString(6), pName, executor, enactor, pAttr,
+        (nullptr != pText) ? pText : T(""));
+}
+
+static void latency_command
+(
+    CMDENT *cmdp,
+    dbref executor,
+    dbref enactor,
+    const CLinearTimeAbsolute &ltaBegin
+)
+{
+    CLinearTimeAbsolute ltaEnd;
+    ltaEnd.GetUTC();
+    CLinearTimeDelta ltd = ltaEnd - ltaBegin;
+
+    latency_record(latency_find(cmdp->cmdname, NOTHING, 0), ltd.ReturnMicroseconds());
+
+    CLinearTimeDelta ltdZero;
+    ltdZero.Set100ns(0);
+    if (  ltdZero < mudconf.slow_cmdsecs
+       && mudconf.slow_cmdsecs < ltd)
+    {
+        latency_slow(cmdp->cmdname, executor, enactor, mudstate.run_src_thing,
+            mudstate.run_src_atr, ltd, mudstate.curr_cmd);
+    }
+}
+
+// A queue entry started by a $-command or ^-listen on thing/atr has finished.
+//
+void latency_attr
+(
+    dbref thing,
+    int   atr,
+    dbref executor,
+    dbref enactor,
+    CLinearTimeDelta ltd
+)
+{
+    latency_record(latency_find(nullptr, thing, atr), ltd.ReturnMicroseconds());
+
+    CLinearTimeDelta ltdZero;
+    ltdZero.Set100ns(0);
+    if (  ltdZero < mudconf.slow_cmdsecs
+       && mudconf.slow_cmdsecs < ltd)
+    {
+        ATTR *pattr = atr_num(atr);
+        latency_slow((nullptr != pattr) ? pattr->name : T("?"), executor,
+            enactor, thing, atr, ltd, nullptr);
+    }
+}
+
+static int DCL_CDECL latency_comp(const void *a, const void *b)
+{
+    CMD_LATENCY *pa = *(CMD_LATENCY **)a;
+    CMD_LATENCY *pb = *(CMD_LATENCY **)b;
+    if (pa->i64Total < pb->i64Total)
+    {
+        return 1;
+    }
+    else if (pa->i64Total > pb->i64Total)
+    {
+        return -1;
+    }
+    return 0;
+}
+
+static void latency_dump(CMD_LATENCY *pcl)
+{
+    UTF8 *buff = alloc_lbuf("latency_dump");
+    UTF8 *bufc = buff;
+    safe_tprintf_str(buff, &bufc, T("H\t%s\t%u\t%lld\t%lld"), latency_name(pcl),
+        pcl->nCount, pcl->i64Total, pcl->i64Max);
+    for (int i = 0; i < LATENCY_BUCKETS; i++)
+    {
+        if (0 != pcl->aBuckets[i])
+        {
+            safe_tprintf_str(buff, &bufc, T("\t%lld:%u"), latency_bucket_top(i),
+                pcl->aBuckets[i]);
+        }
+    }
+    *bufc = '\0';
+    SlowLog.WriteString(buff);
+    SlowLog.WriteString(T(ENDLINE));
+    free_lbuf(buff);
+}
+
+void do_latency(dbref executor, dbref caller, dbref enactor, int eval, int key)
+{
+    UNUSED_PARAMETER(caller);
+    UNUSED_PARAMETER(enactor);
+    UNUSED_PARAMETER(eval);
+
+    if (0 == key)
+    {
+        key = LATENCY_SCREEN;
+    }
+
+    int nEntries = 0;
+    CMD_LATENCY *pcl;
+    for (pcl = (CMD_LATENCY *)hash_firstentry(&mudstate.latency_htab);
+         nullptr != pcl;
+         pcl = (CMD_LATENCY *)hash_nextentry(&mudstate.latency_htab))
+    {
+        nEntries++;
+    }
+
+    if (key & (LATENCY_SCREEN|LATENCY_LOG))
+    {
+        CMD_LATENCY **apcl = nullptr;
+        if (0 < nEntries)
+        {
+            apcl = (CMD_LATENCY **)MEMALLOC(nEntries * sizeof(CMD_LATENCY *));
+            ISOUTOFMEMORY(apcl);
+        }
+
+        int i = 0;
+        for (pcl = (CMD_LATENCY *)hash_firstentry(&mudstate.latency_htab);
+             nullptr != pcl && i < nEntries;
+             pcl = (CMD_LATENCY *)hash_nextentry(&mudstate.latency_htab))
+        {
+            apcl[i++] = pcl;
+        }
+        if (0 < nEntries)
+        {
+            qsort(apcl, nEntries, sizeof(CMD_LATENCY *), latency_comp);
+        }
+
+        if (key & LATENCY_SCREEN)
+        {
+            notify(executor, T("Command                     Count     Mean      50%      90%      99%      Max"));
+            for (i = 0; i < nEntries; i++)
+            {
+                pcl = apcl[i];
+                UTF8 buff[MBUF_SIZE];
+                UTF8 *p = buff;
+                p += LeftJustifyString(p, 24, latency_name(pcl));             *p++ = ' ';
+                p += RightJustifyNumber(p, 8, pcl->nCount, ' ');               *p++ = ' ';
+                p += RightJustifyNumber(p, 8, pcl->i64Total / pcl->nCount, ' '); *p++ = ' ';
+                p += RightJustifyNumber(p, 8, latency_percentile(pcl, 50), ' '); *p++ = ' ';
+                p += RightJustifyNumber(p, 8, latency_percentile(pcl, 90), ' '); *p++ = ' ';
+                p += RightJustifyNumber(p, 8, latency_percentile(pcl, 99), ' '); *p++ = ' ';
+                p += RightJustifyNumber(p, 8, pcl->i64Max, ' ');               *p = '\0';
+                notify(executor, buff);
+            }
+            notify(executor, tprintf(T("%d entries.  Times are in microseconds."), nEntries));
+        }
+
+        if (key & LATENCY_LOG)
+        {
+            latency_start_log();
+            for (i = 0; i < nEntries; i++)
+            {
+                latency_dump(apcl[i]);
+            }
+            STARTLOG(LOG_ALWAYS, "WIZ", "LATENCY");
+            log_name(executor);
+            log_text(tprintf(T(" dumped %d command latency histograms."), nEntries));
+            ENDLOG;
+            if (!(key & LATENCY_SCREEN))
+            {
+                notify(executor, tprintf(T("Dumped %d histograms to the slow command log."), nEntries));
+            }
+        }
+
+        if (nullptr != apcl)
+        {
+            MEMFREE(apcl);
+        }
+    }
+
+    if (key & LATENCY_RESET)
+    {
+        while (nullptr != (pcl = (CMD_LATENCY *)hash_firstentry(&mudstate.latency_htab)))
+        {
+            latency_delete(pcl);
+        }
+        mudstate.bfLatency.ClearAll();
+        if (!(key & LATENCY_SCREEN))
+        {
+            notify(executor, T("Command latency histograms cleared."));
+        }
+    }
+}
+
 /* ---------------------------------------------------------------------------
  * process_cmdent: Perform indicated command with passed args.
  */
@@ -1994,8 +2428,11 @@ UTF8 *process_command
                 mudstate.debug_cmd = cmdsave;
                 return preserve_cmd;
             }
+            CLinearTimeAbsolute ltaBegin;
+            ltaBegin.GetUTC();
             process_cmdent(cmdp, nullptr, executor, caller, enactor,
                 eval, interactive, pCommand, pCommand, args, nargs);
+            latency_command(cmdp, executor, enactor, ltaBegin);
             if (mudstate.bStackLimitReached)
             {
                 STARTLOG(LOG_ALWAYS, T("CMD"), T("SPAM"));
@@ -2349,8 +2786,11 @@ UTF8 *process_command
                     arg++;
                 }
             }
+            CLinearTimeAbsolute ltaBegin;
+            ltaBegin.GetUTC();
             process_cmdent(cmdp, pSlash, executor, caller, enactor, eval,
                 interactive, arg, pCommand, args, nargs);
+            latency_command(cmdp, executor, enactor, ltaBegin);
             if (mudstate.bStackLimitReached)
             {
                 STARTLOG(LOG_ALWAYS, T("CMD"), T("SPAM"));
@@ -2627,9 +3067,8 @@ UTF8 *process_command
                         mudstate.debug_cmd = cmdsave;
                         return preserve_cmd;
                     }
-                    succ |= list_check(Contents(zone_loc), executor,
-                               AMATCH_CMD, LowerCaseCommand, preserve_cmd,
-                               true);
+                    succ |= list_check_index(zone_loc, executor,
+                               LowerCaseCommand, preserve_cmd, true);
 
                     // end of parent room checks.
                     //
@@ -2669,8 +3108,8 @@ UTF8 *process_command
         if (  Good_obj(mudconf.master_room)
            && Has_contents(mudconf.master_room))
         {
-            succ |= list_check(Contents(mudconf.master_room), executor,
-                AMATCH_CMD, LowerCaseCommand, preserve_cmd, false);
+            succ |= list_check_index(mudconf.master_room, executor,
+                LowerCaseCommand, preserve_cmd, false);
 
             if (!No_Command(mudconf.master_room))
             {
@@ -3607,20 +4046,17 @@ static void list_options(dbref player)
            tprintf(T("The head of the object freelist is #%d."),
                mudstate.freelist));
 
-    mux_sprintf(buff, MBUF_SIZE, T("Intervals: Dump...%d  Clean...%d  Idlecheck...%d"),
-        mudconf.dump_interval, mudconf.check_interval,
-        mudconf.idle_interval);
+    mux_sprintf(buff, MBUF_SIZE, T("Intervals: Dump...%d  Clean...%d"),
+        mudconf.dump_interval, mudconf.check_interval);
     raw_notify(player, buff);
 
     CLinearTimeDelta ltdDump = mudstate.dump_counter - ltaNow;
     CLinearTimeDelta ltdCheck = mudstate.check_counter - ltaNow;
-    CLinearTimeDelta ltdIdle = mudstate.idle_counter - ltaNow;
 
     long lDump  = ltdDump.ReturnSeconds();
     long lCheck = ltdCheck.ReturnSeconds();
-    long lIdle  = ltdIdle.ReturnSeconds();
-    mux_sprintf(buff, MBUF_SIZE, T("Timers: Dump...%ld  Clean...%ld  Idlecheck...%ld"),
-        lDump, lCheck, lIdle);
+    mux_sprintf(buff, MBUF_SIZE, T("Timers: Dump...%ld  Clean...%ld"),
+        lDump, lCheck);
     raw_notify(player, buff);
 
     mux_sprintf(buff, MBUF_SIZE, T("Timeouts: Idle...%d  Connect...%d  Tries...%d"),
@@ -3776,6 +4212,14 @@ static void list_hashstats(dbref player)
     list_hashstat(player, T("Net Descr."), &mudstate.desc_htab);
     list_hashstat(player, T("Fwd. lists"), &mudstate.fwdlist_htab);
     list_hashstat(player, T("Excl. $-cmds"), &mudstate.parent_htab);
+    list_hashstat(player, T("$-cmd Words"), &mudstate.cmd_word_htab);
+    list_hashstat(player, T("Room $-cmds"), &mudstate.cmd_index_htab);
+    list_hashstat(player, T("Lock Trees"), &mudstate.lock_htab);
+    list_hashstat(player, T("Hearer Lists"), &mudstate.hear_list_htab);
+    list_hashstat(player, T("Exit Indexes"), &mudstate.exit_index_htab);
+    list_hashstat(player, T("Exit Aliases"), &mudstate.exit_alias_htab);
+    list_hashstat(player, T("Name Prefixes"), &mudstate.name_index_htab);
+    list_hashstat(player, T("Cmd Latency"), &mudstate.latency_htab);
     list_hashstat(player, T("Mail Messages"), &mudstate.mail_htab);
     list_hashstat(player, T("Channel Names"), &mudstate.channel_htab);
 #if !defined(MEMORY_BASED)
@@ -3807,6 +4251,18 @@ static void list_db_stats(dbref player)
     raw_notify(player, tprintf(T("I/O        %12d%12d"), cs_dbwrites, cs_dbreads));
     raw_notify(player, tprintf(T("Cache Hits %12d%12d"), cs_whits, cs_rhits));
 #endif // MEMORY_BASED
+    if (mudconf.journal)
+    {
+        raw_notify(player, T("\nJournal        Records       Bytes     Commits    Replayed"));
+        raw_notify(player, tprintf(T("           %12llu%12llu%12llu%12llu"), journal_records,
+            journal_bytes, journal_commits, journal_replayed));
+    }
+    if (0 < mudconf.dump_deltas)
+    {
+        raw_notify(player, T("\nCheckpoint  Generation       Delta"));
+        raw_notify(player, tprintf(T("           %12d%12d"), mudstate.checkpoint_base,
+            mudstate.checkpoint_delta));
+    }
 }
 
 // ---------------------------------------------------------------------------
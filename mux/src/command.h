@@ -84,6 +84,7 @@ CMD_TWO_ARG(do_prog);           /* Interactive input */
 CMD_ONE_ARG(do_quitprog);       /* Quits @prog */
 CMD_TWO_ARG(do_kill);           /* Kill something */
 CMD_ONE_ARG(do_last);           /* Get recent login info */
+CMD_NO_ARG(do_latency);         // Report command latency histograms
 CMD_NO_ARG(do_leave);           /* Leave the current object */
 CMD_TWO_ARG(do_link);           /* Set home, dropto, or dest */
 CMD_ONE_ARG(do_list);           /* List contents of internal tables */
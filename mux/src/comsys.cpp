@@ -1521,6 +1521,16 @@ void SendChannelMessage
     bool bSpoof = ((ch->type & CHANNEL_SPOOF) != 0);
     ch->num_messages++;
 
+    // Parse each form of the message once rather than once per listener.
+    //
+    mux_string *sMsgNormal = new mux_string(msgNormal);
+    mux_string *sMsgNoComtitle = nullptr;
+    if (  !bSpoof
+       && nullptr != msgNoComtitle)
+    {
+        sMsgNoComtitle = new mux_string(msgNoComtitle);
+    }
+
     struct comuser *user;
     for (user = ch->on_users; user; user = user->on_next)
     {
@@ -1528,17 +1538,21 @@ void SendChannelMessage
            && test_receive_access(user->who, ch))
         {
             if (  user->ComTitleStatus
-               || bSpoof
-               || msgNoComtitle == nullptr)
+               || nullptr == sMsgNoComtitle)
             {
-                notify_comsys(user->who, executor, msgNormal);
+                notify_comsys(user->who, executor, *sMsgNormal);
             }
             else
             {
-                notify_comsys(user->who, executor, msgNoComtitle);
+                notify_comsys(user->who, executor, *sMsgNoComtitle);
             }
         }
     }
+    delete sMsgNormal;
+    if (nullptr != sMsgNoComtitle)
+    {
+        delete sMsgNoComtitle;
+    }
 
     // Handle logging.
     //
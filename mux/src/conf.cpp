@@ -50,12 +50,14 @@ void cf_init(void)
     mudconf.indb = StringClone(T("netmux.db"));
     mudconf.outdb = StringClone(T(""));
     mudconf.crashdb = StringClone(T(""));
+    mudconf.journal_db = StringClone(T(""));
     mudconf.game_dir = StringClone(T(""));
     mudconf.game_pag = StringClone(T(""));
     mudconf.mail_db   = StringClone(T("mail.db"));
     mudconf.comsys_db = StringClone(T("comsys.db"));
 
     mudconf.compress_db = false;
+    mudconf.dump_snapshot = false;
     mudconf.compress = StringClone(T("gzip"));
     mudconf.uncompress = StringClone(T("gzip -d"));
     mudconf.status_file = StringClone(T("shutdown.status"));
@@ -145,6 +147,7 @@ void cf_init(void)
     mudconf.paranoid_alloc = false;
     mudconf.sig_action = SA_DFLT;
     mudconf.max_players = -1;
+    mudconf.dump_deltas = 0;
     mudconf.dump_interval = 3600;
     mudconf.check_interval = 600;
     mudconf.events_daily_hour = 7;
@@ -193,6 +196,7 @@ void cf_init(void)
     mudconf.mail_expiration = 14;
     mudconf.queuemax = 100;
     mudconf.queue_chunk = 10;
+    mudconf.queue_wizard_weight = 4;
     mudconf.active_q_chunk  = 10;
     mudconf.sacfactor       = 5;
     mudconf.sacadjust       = -1;
@@ -267,7 +271,11 @@ void cf_init(void)
     mudconf.cmd_quota_incr = 1;
     mudconf.rpt_cmdsecs.SetSeconds(120);
     mudconf.max_cmdsecs.SetSeconds(60);
+    mudconf.slow_cmdsecs.SetSeconds(1);
+    mudconf.queue_cpu_limit = 0;
     mudconf.cache_tick_period.SetSeconds(30);
+    mudconf.journal = false;
+    mudconf.journal_commit_period.SetSeconds(1);
     mudconf.control_flags = 0xffffffff; // Everything for now...
     mudconf.log_options = LOG_ALWAYS | LOG_BUGS | LOG_SECURITY |
         LOG_NET | LOG_LOGIN | LOG_DBSAVES | LOG_CONFIGMODS |
@@ -321,9 +329,15 @@ void cf_init(void)
     mudstate.asserting = 0;
     mudstate.logging = 0;
     mudstate.epoch = 0;
+    mudstate.checkpoint_base = 0;
+    mudstate.checkpoint_delta = 0;
     mudstate.generation = 0;
     mudstate.curr_executor = NOTHING;
     mudstate.curr_enactor = NOTHING;
+    mudstate.que_src_thing = NOTHING;
+    mudstate.que_src_atr = 0;
+    mudstate.run_src_thing = NOTHING;
+    mudstate.run_src_atr = 0;
     mudstate.shutdown_flag  = false;
     mudstate.attr_next = A_USER_START;
     mudstate.debug_cmd = T("< init >");
@@ -758,6 +772,15 @@ static CF_HAND(cf_string)
         }
         *p = '\0';
         Log.SetPrefix(buff);
+
+        // The slow command log shares the prefix.
+        //
+        if (26 < nLen)
+        {
+            nLen = 26;
+        }
+        memcpy(buff + nLen, "-slow", sizeof("-slow"));
+        SlowLog.SetPrefix(buff);
         free_sbuf(buff);
     }
     return retval;
@@ -1796,9 +1819,11 @@ static CONFPARM conftable[] =
     {T("dig_cost"),                  cf_int,         CA_GOD,    CA_PUBLIC,   &mudconf.digcost,                nullptr,            0},
     {T("down_file"),                 cf_string_dyn,  CA_STATIC, CA_GOD,      (int *)&mudconf.down_file,       nullptr, SIZEOF_PATHNAME},
     {T("down_motd_message"),         cf_string,      CA_GOD,    CA_WIZARD,   (int *)mudconf.downmotd_msg,     nullptr,    GBUF_SIZE},
+    {T("dump_deltas"),               cf_int,         CA_STATIC, CA_WIZARD,   &mudconf.dump_deltas,            nullptr,            0},
     {T("dump_interval"),             cf_int,         CA_GOD,    CA_WIZARD,   &mudconf.dump_interval,          nullptr,            0},
     {T("dump_message"),              cf_string,      CA_GOD,    CA_WIZARD,   (int *)mudconf.dump_msg,         nullptr,          256},
     {T("dump_offset"),               cf_int,         CA_GOD,    CA_WIZARD,   &mudconf.dump_offset,            nullptr,            0},
+    {T("dump_snapshot"),             cf_bool,        CA_GOD,    CA_WIZARD,   (int *)&mudconf.dump_snapshot,   nullptr,            0},
     {T("earn_limit"),                cf_int,         CA_GOD,    CA_PUBLIC,   &mudconf.paylimit,               nullptr,            0},
     {T("eval_comtitle"),             cf_bool,        CA_GOD,    CA_PUBLIC,   (int *)&mudconf.eval_comtitle,   nullptr,            0},
     {T("events_daily_hour"),         cf_int,         CA_GOD,    CA_PUBLIC,   &mudconf.events_daily_hour,      nullptr,            0},
@@ -1854,6 +1879,9 @@ static CONFPARM conftable[] =
     {T("initial_size"),              cf_int,         CA_STATIC, CA_WIZARD,   &mudconf.init_size,              nullptr,            0},
     {T("input_database"),            cf_string_dyn,  CA_STATIC, CA_GOD,      (int *)&mudconf.indb,            nullptr, SIZEOF_PATHNAME},
     {T("ip_address"),                cf_string_dyn,  CA_STATIC, CA_GOD,      (int *)&mudconf.ip_address,      nullptr,    LBUF_SIZE},
+    {T("journal"),                   cf_bool,        CA_STATIC, CA_GOD,      (int *)&mudconf.journal,         nullptr,            0},
+    {T("journal_commit_period"),     cf_seconds,     CA_GOD,    CA_WIZARD,   (int *)&mudconf.journal_commit_period, nullptr,      0},
+    {T("journal_database"),          cf_string_dyn,  CA_STATIC, CA_GOD,      (int *)&mudconf.journal_db,      nullptr, SIZEOF_PATHNAME},
     {T("keepalive_interval"),        cf_int,         CA_GOD,    CA_WIZARD,   &mudconf.keepalive_interval,     nullptr,            0},
     {T("kill_guarantee_cost"),       cf_int,         CA_GOD,    CA_PUBLIC,   &mudconf.killguarantee,          nullptr,            0},
     {T("kill_max_cost"),             cf_int,         CA_GOD,    CA_PUBLIC,   &mudconf.killmax,                nullptr,            0},
@@ -1921,7 +1949,9 @@ static CONFPARM conftable[] =
     {T("public_flags"),              cf_bool,        CA_GOD,    CA_PUBLIC,   (int *)&mudconf.pub_flags,       nullptr,            0},
     {T("pueblo_message"),            cf_string,      CA_GOD,    CA_WIZARD,   (int *)mudconf.pueblo_msg,       nullptr,    GBUF_SIZE},
     {T("queue_active_chunk"),        cf_int,         CA_GOD,    CA_PUBLIC,   &mudconf.active_q_chunk,         nullptr,            0},
+    {T("queue_cpu_limit"),           cf_int,         CA_GOD,    CA_WIZARD,   &mudconf.queue_cpu_limit,        nullptr,            0},
     {T("queue_idle_chunk"),          cf_int,         CA_GOD,    CA_PUBLIC,   &mudconf.queue_chunk,            nullptr,            0},
+    {T("queue_wizard_weight"),       cf_int,         CA_GOD,    CA_PUBLIC,   &mudconf.queue_wizard_weight,    nullptr,            0},
     {T("quiet_look"),                cf_bool,        CA_GOD,    CA_PUBLIC,   (int *)&mudconf.quiet_look,      nullptr,            0},
     {T("quiet_whisper"),             cf_bool,        CA_GOD,    CA_PUBLIC,   (int *)&mudconf.quiet_whisper,   nullptr,            0},
     {T("quit_file"),                 cf_string_dyn,  CA_STATIC, CA_GOD,      (int *)&mudconf.quit_file,       nullptr, SIZEOF_PATHNAME},
@@ -1953,6 +1983,7 @@ static CONFPARM conftable[] =
     {T("signal_action"),             cf_option,      CA_STATIC, CA_GOD,      &mudconf.sig_action,             sigactions_nametab, 0},
     {T("site_chars"),                cf_int,         CA_GOD,    CA_WIZARD,   (int *)&mudconf.site_chars,      nullptr,            0},
     {T("sitemon_site"),              cf_site,        CA_GOD,    CA_DISABLED, (int *)&mudstate.access_list,    nullptr,   HC_SITEMON},
+    {T("slow_command_threshold"),    cf_seconds,     CA_GOD,    CA_WIZARD,   (int *)&mudconf.slow_cmdsecs,    nullptr,            0},
     {T("space_compress"),            cf_bool,        CA_GOD,    CA_PUBLIC,   (int *)&mudconf.space_compress,  nullptr,            0},
 #ifdef UNIX_SSL
     {T("ssl_certificate_file"),      cf_string,      CA_STATIC, CA_DISABLED, (int *)mudconf.ssl_certificate_file,nullptr,       128},
@@ -2195,12 +2226,30 @@ void do_admin
     UNUSED_PARAMETER(cargs);
     UNUSED_PARAMETER(ncargs);
 
+    int idle_timeout = mudconf.idle_timeout;
+    int conn_timeout = mudconf.conn_timeout;
+    int parent_nest_lim = mudconf.parent_nest_lim;
     int i = cf_set(kw, value, executor);
     if ((i >= 0) && !Quiet(executor))
     {
         notify(executor, T("Set."));
     }
     ValidateConfigurationDbrefs();
+
+    // Descriptors watch their own timeouts.
+    //
+    if (  idle_timeout != mudconf.idle_timeout
+       || conn_timeout != mudconf.conn_timeout)
+    {
+        desc_recheck_idle_all();
+    }
+
+    // Inherited attribute lookups depend on how deep they may look.
+    //
+    if (parent_nest_lim != mudconf.parent_nest_lim)
+    {
+        atr_resolve_flush();
+    }
 }
 
 // ---------------------------------------------------------------------------
@@ -2215,6 +2264,7 @@ static struct
 {
     { &mudconf.outdb,    T(".out") },
     { &mudconf.crashdb,  T(".CRASH") },
+    { &mudconf.journal_db, T(".jrnl") },
     { &mudconf.game_dir, T(".dir") },
     { &mudconf.game_pag, T(".pag") },
     { 0, 0 }
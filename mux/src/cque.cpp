@@ -77,14 +77,416 @@ static int add_to(dbref executor, int am, int attrnum)
     return num;
 }
 
-// This Task assumes that pEntry is already unlinked from any lists it may
-// have been related to.
+// ---------------------------------------------------------------------------
+// Queue index: Every scheduled queue entry is linked into a list on its
+// executor, a list on its executor's owner, and while it waits on a
+// semaphore, the wait list for that semaphore attribute.  Together with the
+// counts of each kind of entry, this lets @halt, @drain, @notify, and @ps
+// with a target visit only the entries they concern.
+//
+#define QUE_NONE      (-1)
+#define QUE_WAIT      0
+#define QUE_SEMAPHORE 1
+#define QUE_SQL       2
+#define NUM_QUE_KINDS 3
+
+static int que_count[NUM_QUE_KINDS];
+
+// Find the wait list for one attribute of a semaphore object.
+//
+static SEMWAIT *que_waiters(dbref sem, int attr)
+{
+    for (SEMWAIT *pw = db[sem].queue_semaphore; nullptr != pw; pw = pw->pNext)
+    {
+        if (pw->attr == attr)
+        {
+            return pw;
+        }
+    }
+    return nullptr;
+}
+
+static void que_link_semaphore(BQUE *point)
+{
+    dbref sem = point->u.s.sem;
+    SEMWAIT *pw = que_waiters(sem, point->u.s.attr);
+    if (nullptr == pw)
+    {
+        pw = (SEMWAIT *)MEMALLOC(sizeof(SEMWAIT));
+        ISOUTOFMEMORY(pw);
+        pw->attr = point->u.s.attr;
+        pw->pUntimedHead = nullptr;
+        pw->pUntimedTail = nullptr;
+        pw->pTimedHead = nullptr;
+        pw->pTimedTail = nullptr;
+        pw->pNext = db[sem].queue_semaphore;
+        db[sem].queue_semaphore = pw;
+    }
+    point->pWaiters = pw;
+
+    BQUE **ppHead;
+    BQUE **ppTail;
+    BQUE *pAfter;
+    if (point->IsTimed)
+    {
+        // Timeouts are usually queued in order, so the search from the tail
+        // is short.
+        //
+        ppHead = &pw->pTimedHead;
+        ppTail = &pw->pTimedTail;
+        pAfter = pw->pTimedTail;
+        while (  nullptr != pAfter
+              && point->waittime < pAfter->waittime)
+        {
+            pAfter = pAfter->pSemaphorePrev;
+        }
+    }
+    else
+    {
+        ppHead = &pw->pUntimedHead;
+        ppTail = &pw->pUntimedTail;
+        pAfter = pw->pUntimedTail;
+    }
+
+    point->pSemaphorePrev = pAfter;
+    if (nullptr != pAfter)
+    {
+        point->pSemaphoreNext = pAfter->pSemaphoreNext;
+        pAfter->pSemaphoreNext = point;
+    }
+    else
+    {
+        point->pSemaphoreNext = *ppHead;
+        *ppHead = point;
+    }
+    if (nullptr != point->pSemaphoreNext)
+    {
+        point->pSemaphoreNext->pSemaphorePrev = point;
+    }
+    else
+    {
+        *ppTail = point;
+    }
+}
+
+static void que_unlink_semaphore(BQUE *point)
+{
+    SEMWAIT *pw = point->pWaiters;
+    BQUE **ppHead = point->IsTimed ? &pw->pTimedHead : &pw->pUntimedHead;
+    BQUE **ppTail = point->IsTimed ? &pw->pTimedTail : &pw->pUntimedTail;
+    if (nullptr != point->pSemaphorePrev)
+    {
+        point->pSemaphorePrev->pSemaphoreNext = point->pSemaphoreNext;
+    }
+    else
+    {
+        *ppHead = point->pSemaphoreNext;
+    }
+    if (nullptr != point->pSemaphoreNext)
+    {
+        point->pSemaphoreNext->pSemaphorePrev = point->pSemaphorePrev;
+    }
+    else
+    {
+        *ppTail = point->pSemaphorePrev;
+    }
+    point->pWaiters = nullptr;
+
+    if (  nullptr == pw->pUntimedHead
+       && nullptr == pw->pTimedHead)
+    {
+        // Nothing is waiting on this attribute anymore.
+        //
+        SEMWAIT **ppw = &db[point->u.s.sem].queue_semaphore;
+        while (*ppw != pw)
+        {
+            ppw = &(*ppw)->pNext;
+        }
+        *ppw = pw->pNext;
+        MEMFREE(pw);
+    }
+}
+
+static void que_link_owner(BQUE *point, dbref owner)
+{
+    BQUE **ppHead = &db[owner].queue_owner;
+    point->owner = owner;
+    point->pOwnerPrev = nullptr;
+    point->pOwnerNext = *ppHead;
+    if (nullptr != *ppHead)
+    {
+        (*ppHead)->pOwnerPrev = point;
+    }
+    *ppHead = point;
+}
+
+static void que_unlink_owner(BQUE *point)
+{
+    if (nullptr != point->pOwnerPrev)
+    {
+        point->pOwnerPrev->pOwnerNext = point->pOwnerNext;
+    }
+    else
+    {
+        db[point->owner].queue_owner = point->pOwnerNext;
+    }
+    if (nullptr != point->pOwnerNext)
+    {
+        point->pOwnerNext->pOwnerPrev = point->pOwnerPrev;
+    }
+}
+
+// que_index: Record a newly-scheduled entry.
+//
+static void que_index(BQUE *point, PTASK_RECORD pTask, int iKind)
+{
+    if (nullptr == pTask)
+    {
+        return;
+    }
+    point->pTask = pTask;
+    point->iKind = iKind;
+    que_count[iKind]++;
+
+    BQUE **ppHead = &db[point->executor].queue_executor;
+    point->pExecutorPrev = nullptr;
+    point->pExecutorNext = *ppHead;
+    if (nullptr != *ppHead)
+    {
+        (*ppHead)->pExecutorPrev = point;
+    }
+    *ppHead = point;
+
+    que_link_owner(point, Owner(point->executor));
+    if (QUE_SEMAPHORE == iKind)
+    {
+        que_link_semaphore(point);
+    }
+}
+
+// que_unindex: Forget an entry which is about to run or be discarded.
+//
+static void que_unindex(BQUE *point)
+{
+    if (QUE_NONE == point->iKind)
+    {
+        return;
+    }
+
+    if (nullptr != point->pExecutorPrev)
+    {
+        point->pExecutorPrev->pExecutorNext = point->pExecutorNext;
+    }
+    else
+    {
+        db[point->executor].queue_executor = point->pExecutorNext;
+    }
+    if (nullptr != point->pExecutorNext)
+    {
+        point->pExecutorNext->pExecutorPrev = point->pExecutorPrev;
+    }
+
+    que_unlink_owner(point);
+    if (QUE_SEMAPHORE == point->iKind)
+    {
+        que_unlink_semaphore(point);
+    }
+    que_count[point->iKind]--;
+    point->iKind = QUE_NONE;
+    point->pTask = nullptr;
+}
+
+// que_rekind: An entry has moved from one queue to another.
+//
+static void que_rekind(BQUE *point, int iKind)
+{
+    if (QUE_NONE == point->iKind)
+    {
+        return;
+    }
+
+    if (QUE_SEMAPHORE == point->iKind)
+    {
+        que_unlink_semaphore(point);
+    }
+    que_count[point->iKind]--;
+    point->iKind = iKind;
+    que_count[iKind]++;
+    if (QUE_SEMAPHORE == iKind)
+    {
+        que_link_semaphore(point);
+    }
+}
+
+// que_weight: The scheduler shares PRIORITY_PLAYER and PRIORITY_OBJECT among
+// owners (deficit round-robin).  Each turn, an owner may run as many entries
+// as its weight.
+//
+static int que_weight(dbref owner)
+{
+    int iWeight = 1;
+    if (Wizard(owner))
+    {
+        iWeight = mudconf.queue_wizard_weight;
+    }
+    return (iWeight < 1) ? 1 : iWeight;
+}
+
+// que_rekey: Move the entries of an object which has changed owners.  This
+// is called from s_Owner() only when the object has entries.
+//
+void que_rekey(dbref executor)
+{
+    dbref owner = Owner(executor);
+    int iWeight = que_weight(owner);
+    for (BQUE *point = db[executor].queue_executor; nullptr != point; point = point->pExecutorNext)
+    {
+        if (point->owner != owner)
+        {
+            que_unlink_owner(point);
+            que_link_owner(point, owner);
+            scheduler.RegroupTask(point->pTask, owner, iWeight);
+        }
+    }
+}
+
+// que_reweight: The weight of an owner may have changed.
+//
+void que_reweight(dbref owner)
+{
+    if (!Good_dbref(owner))
+    {
+        return;
+    }
+    int iWeight = que_weight(owner);
+    for (BQUE *point = db[owner].queue_owner; nullptr != point; point = point->pOwnerNext)
+    {
+        scheduler.RegroupTask(point->pTask, owner, iWeight);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// que_want: Do we want this queue entry?
+//
+static bool que_want(BQUE *entry, dbref ptarg, dbref otarg)
+{
+    if (  ptarg != NOTHING
+       && ptarg != Owner(entry->executor))
+    {
+        return false;
+    }
+    return (  otarg == NOTHING
+           || otarg == entry->executor);
+}
+
+// que_gather: Collect the tasks of entries that match (ptarg, otarg) from
+// the index.  Either ptarg or otarg must be given.  Going and garbage
+// objects are looked up, too, so that their entries can be removed before
+// the dbref is reused.
+//
+static int que_gather(dbref ptarg, dbref otarg, PTASK_RECORD **paTasks)
+{
+    BQUE *pHead = nullptr;
+    bool bExecutor = (NOTHING != otarg);
+    if (bExecutor)
+    {
+        if (Good_dbref(otarg))
+        {
+            pHead = db[otarg].queue_executor;
+        }
+    }
+    else if (Good_dbref(ptarg))
+    {
+        pHead = db[ptarg].queue_owner;
+    }
+
+    int nAlloc = 0;
+    BQUE *point;
+    for (point = pHead; nullptr != point; point = bExecutor ? point->pExecutorNext : point->pOwnerNext)
+    {
+        nAlloc++;
+    }
+
+    *paTasks = nullptr;
+    if (0 == nAlloc)
+    {
+        return 0;
+    }
+    PTASK_RECORD *aTasks = (PTASK_RECORD *)MEMALLOC(nAlloc * sizeof(PTASK_RECORD));
+    ISOUTOFMEMORY(aTasks);
+
+    int nTasks = 0;
+    for (point = pHead; nullptr != point; point = bExecutor ? point->pExecutorNext : point->pOwnerNext)
+    {
+        if (que_want(point, ptarg, otarg))
+        {
+            aTasks[nTasks++] = point->pTask;
+        }
+    }
+    *paTasks = aTasks;
+    return nTasks;
+}
+
+// ---------------------------------------------------------------------------
+// que_cpu_max: Return the CpuMax of an object in milliseconds, or 0 if it
+// has none.  The value is cached in the object until CpuMax changes.
+//
+static int que_cpu_max(dbref thing)
+{
+    if (db[thing].cpu_max < 0)
+    {
+        int m = 0;
+        const UTF8 *cp = atr_get_raw(thing, A_CPUMAX);
+        if (cp && *cp)
+        {
+            dbref aowner;
+            int   aflags;
+            m = mux_atol(atr_decode_flags_owner(cp, &aowner, &aflags));
+            if (m < 0)
+            {
+                m = 0;
+            }
+        }
+        db[thing].cpu_max = m;
+    }
+    return db[thing].cpu_max;
+}
+
+// que_cpu_budget: Return the CPU time a single queue entry of executor may
+// use.  The executor's CpuMax wins over its owner's CpuMax which wins over
+// queue_cpu_limit.  All three are in milliseconds.  A zero budget means only
+// lag_limit applies.
+//
+static CLinearTimeDelta que_cpu_budget(dbref executor)
+{
+    int m = que_cpu_max(executor);
+    if (  0 == m
+       && Good_obj(Owner(executor)))
+    {
+        m = que_cpu_max(Owner(executor));
+    }
+    if (0 == m)
+    {
+        m = mudconf.queue_cpu_limit;
+    }
+
+    CLinearTimeDelta ltd;
+    if (0 < m)
+    {
+        ltd.SetMilliseconds(m);
+    }
+    return ltd;
+}
+
+// This Task assumes that pEntry is already unlinked from the scheduler. It
+// is taken out of the queue index here.
 //
 static void Task_RunQueueEntry(void *pEntry, int iUnused)
 {
     UNUSED_PARAMETER(iUnused);
 
     BQUE *point = (BQUE *)pEntry;
+    que_unindex(point);
     dbref executor = point->executor;
 
     if (  Good_obj(executor)
@@ -128,6 +530,21 @@ static void Task_RunQueueEntry(void *pEntry, int iUnused)
             mux_assert(mudstate.poutobj == NOTHING);
             mux_assert(!mudstate.pout);
 
+            // The CPU budget covers the whole entry, so each command is only
+            // given what the earlier ones left over.
+            //
+            CLinearTimeDelta ltdZero;
+            ltdZero.Set100ns(0);
+            CLinearTimeDelta ltdBudget = que_cpu_budget(executor);
+            CLinearTimeDelta ltdEntryUsage = ltdZero;
+
+            // Wall time of the entry, charged to the $-command which queued
+            // it (if any).
+            //
+            CLinearTimeDelta ltdEntryElapsed = ltdZero;
+            mudstate.run_src_thing = point->src_thing;
+            mudstate.run_src_atr   = point->src_atr;
+
             break_called = false;
             while (  command
                   && !break_called)
@@ -160,9 +577,26 @@ static void Task_RunQueueEntry(void *pEntry, int iUnused)
                         mudstate.poutobj = NOTHING;
                     }
 
+                    CLinearTimeDelta ltdAlarm = mudconf.max_cmdsecs;
+                    bool bBudgeted = false;
+                    if (ltdZero < ltdBudget)
+                    {
+                        CLinearTimeDelta ltdLeft = ltdBudget - ltdEntryUsage;
+                        if (ltdLeft < ltdAlarm)
+                        {
+                            // A zero period would turn the alarm off, so
+                            // always give the command at least a millisecond.
+                            //
+                            CLinearTimeDelta ltdMinimum;
+                            ltdMinimum.SetMilliseconds(1);
+                            ltdAlarm = (ltdLeft < ltdMinimum) ? ltdMinimum : ltdLeft;
+                            bBudgeted = true;
+                        }
+                    }
+
                     CLinearTimeAbsolute ltaBegin;
                     ltaBegin.GetUTC();
-                    alarm_clock.set(mudconf.max_cmdsecs);
+                    alarm_clock.set(ltdAlarm);
                     CLinearTimeDelta ltdUsageBegin = GetProcessorUsage();
 
                     UTF8 *log_cmdbuf = process_command(executor, point->caller,
@@ -171,7 +605,31 @@ static void Task_RunQueueEntry(void *pEntry, int iUnused)
 
                     CLinearTimeAbsolute ltaEnd;
                     ltaEnd.GetUTC();
-                    if (alarm_clock.alarmed)
+                    if (  alarm_clock.alarmed
+                       && bBudgeted)
+                    {
+                        // The entry ran out of budget.  Stop the rest of it,
+                        // but leave the object and its queue alone.
+                        //
+                        break_called = true;
+                        dbref owner = Owner(executor);
+                        if (Good_obj(owner))
+                        {
+                            notify(owner, tprintf(T("GAME: Queue entry of %s(#%d) exceeded its CPU budget of %ldms and was stopped."),
+                                PureName(executor), executor, ltdBudget.ReturnMilliseconds()));
+                        }
+
+                        STARTLOG(LOG_PROBLEMS, "CMD", "CPU");
+                        log_name_and_loc(executor);
+                        UTF8 *logbuf = alloc_lbuf("do_top.LOG.budget");
+                        mux_sprintf(logbuf, LBUF_SIZE, T(" queue entry exceeded CPU budget of %ldms (enactor #%d): "),
+                            ltdBudget.ReturnMilliseconds(), point->enactor);
+                        log_text(logbuf);
+                        free_lbuf(logbuf);
+                        log_text(log_cmdbuf);
+                        ENDLOG;
+                    }
+                    else if (alarm_clock.alarmed)
                     {
                         notify(executor, T("GAME: Expensive activity abbreviated."));
                         s_Flags(point->enactor, FLAG_WORD1, Flags(point->enactor) | HALT);
@@ -183,9 +641,15 @@ static void Task_RunQueueEntry(void *pEntry, int iUnused)
 
                     CLinearTimeDelta ltdUsageEnd = GetProcessorUsage();
                     CLinearTimeDelta ltd = ltdUsageEnd - ltdUsageBegin;
+                    ltdEntryUsage += ltd;
                     db[executor].cpu_time_used += ltd;
+                    if (Good_obj(Owner(executor)))
+                    {
+                        db[Owner(executor)].queue_cpu_time += ltd;
+                    }
 
                     ltd = ltaEnd - ltaBegin;
+                    ltdEntryElapsed += ltd;
                     if (mudconf.rpt_cmdsecs < ltd)
                     {
                         STARTLOG(LOG_PROBLEMS, "CMD", "CPU");
@@ -226,6 +690,14 @@ static void Task_RunQueueEntry(void *pEntry, int iUnused)
             mudstate.pipe_nest_lev = 0;
             mudstate.inpipe = false;
             mudstate.poutobj = NOTHING;
+
+            if (Good_obj(point->src_thing))
+            {
+                latency_attr(point->src_thing, point->src_atr, executor,
+                    point->enactor, ltdEntryElapsed);
+            }
+            mudstate.run_src_thing = NOTHING;
+            mudstate.run_src_atr   = 0;
         }
     }
 
@@ -258,20 +730,6 @@ static void Task_RunQueueEntry(void *pEntry, int iUnused)
     free_qentry(point);
 }
 
-// ---------------------------------------------------------------------------
-// que_want: Do we want this queue entry?
-//
-static bool que_want(BQUE *entry, dbref ptarg, dbref otarg)
-{
-    if (  ptarg != NOTHING
-       && ptarg != Owner(entry->executor))
-    {
-        return false;
-    }
-    return (  otarg == NOTHING
-           || otarg == entry->executor);
-}
-
 static void Task_SemaphoreTimeout(void *pExpired, int iUnused)
 {
     UNUSED_PARAMETER(iUnused);
@@ -279,6 +737,7 @@ static void Task_SemaphoreTimeout(void *pExpired, int iUnused)
     // A semaphore has timed out.
     //
     BQUE *point = (BQUE *)pExpired;
+    que_unindex(point);
     add_to(point->u.s.sem, -1, point->u.s.attr);
     point->u.s.sem = NOTHING;
     Task_RunQueueEntry(point, 0);
@@ -300,6 +759,49 @@ static int   Halt_Entries;
 static dbref Halt_Player_Run;
 static dbref Halt_Entries_Run;
 
+// Discard a queue entry that has been halted. The caller removes its task.
+//
+static void HaltQueueEntry(BQUE *point)
+{
+    // Accounting for pennies and queue quota.
+    //
+    dbref dbOwner = point->executor;
+    if (!isPlayer(dbOwner))
+    {
+        dbOwner = Owner(dbOwner);
+    }
+    if (dbOwner != Halt_Player_Run)
+    {
+        if (Halt_Player_Run != NOTHING)
+        {
+            giveto(Halt_Player_Run, mudconf.waitcost * Halt_Entries_Run);
+            a_Queue(Halt_Player_Run, -Halt_Entries_Run);
+        }
+        Halt_Player_Run = dbOwner;
+        Halt_Entries_Run = 0;
+    }
+    Halt_Entries++;
+    Halt_Entries_Run++;
+    if (QUE_SEMAPHORE == point->iKind)
+    {
+        add_to(point->u.s.sem, -1, point->u.s.attr);
+    }
+    que_unindex(point);
+
+    for (int i = 0; i < MAX_GLOBAL_REGS; i++)
+    {
+        if (point->scr[i])
+        {
+            RegRelease(point->scr[i]);
+            point->scr[i] = nullptr;
+        }
+    }
+
+    MEMFREE(point->text);
+    point->text = nullptr;
+    free_qentry(point);
+}
+
 static int CallBack_HaltQueue(PTASK_RECORD p)
 {
     if (  p->fpTask == Task_RunQueueEntry
@@ -311,42 +813,7 @@ static int CallBack_HaltQueue(PTASK_RECORD p)
         BQUE *point = (BQUE *)(p->arg_voidptr);
         if (que_want(point, Halt_Player_Target, Halt_Object_Target))
         {
-            // Accounting for pennies and queue quota.
-            //
-            dbref dbOwner = point->executor;
-            if (!isPlayer(dbOwner))
-            {
-                dbOwner = Owner(dbOwner);
-            }
-            if (dbOwner != Halt_Player_Run)
-            {
-                if (Halt_Player_Run != NOTHING)
-                {
-                    giveto(Halt_Player_Run, mudconf.waitcost * Halt_Entries_Run);
-                    a_Queue(Halt_Player_Run, -Halt_Entries_Run);
-                }
-                Halt_Player_Run = dbOwner;
-                Halt_Entries_Run = 0;
-            }
-            Halt_Entries++;
-            Halt_Entries_Run++;
-            if (p->fpTask == Task_SemaphoreTimeout)
-            {
-                add_to(point->u.s.sem, -1, point->u.s.attr);
-            }
-
-            for (int i = 0; i < MAX_GLOBAL_REGS; i++)
-            {
-                if (point->scr[i])
-                {
-                    RegRelease(point->scr[i]);
-                    point->scr[i] = nullptr;
-                }
-            }
-
-            MEMFREE(point->text);
-            point->text = nullptr;
-            free_qentry(point);
+            HaltQueueEntry(point);
             return IU_REMOVE_TASK;
         }
     }
@@ -373,7 +840,28 @@ int halt_que(dbref executor, dbref object)
 
     // Process @wait, timed semaphores, and untimed semaphores.
     //
-    scheduler.TraverseUnordered(CallBack_HaltQueue);
+    if (  NOTHING == executor
+       && NOTHING == object)
+    {
+        scheduler.TraverseUnordered(CallBack_HaltQueue);
+    }
+    else
+    {
+        PTASK_RECORD *aTasks;
+        int nTasks = que_gather(executor, object, &aTasks);
+        for (int i = 0; i < nTasks; i++)
+        {
+            PTASK_RECORD p = aTasks[i];
+            HaltQueueEntry((BQUE *)(p->arg_voidptr));
+            scheduler.RemoveTask(p);
+        }
+
+        if (nullptr != aTasks)
+        {
+            MEMFREE(aTasks);
+            aTasks = nullptr;
+        }
+    }
 
     if (Halt_Player_Run != NOTHING)
     {
@@ -459,110 +947,48 @@ void do_halt(dbref executor, dbref caller, dbref enactor, int eval, int key, UTF
     notify(Owner(executor), tprintf(T("%d queue entr%s removed."), numhalted, numhalted == 1 ? "y" : "ies"));
 }
 
-static int Notify_Key;
-static int Notify_Num_Done;
-static int Notify_Num_Max;
-static int Notify_Sem;
-static int Notify_Attr;
-
-// NFY_DRAIN or NFY_NFYALL
+// Allow a semaphore entry to run. The priority may have been
+// PRIORITY_SUSPEND, so we need to change it.
 //
-static int CallBack_NotifySemaphoreDrainOrAll(PTASK_RECORD p)
+static void NotifyQueueEntry(PTASK_RECORD p)
 {
-    if (p->fpTask == Task_SemaphoreTimeout)
+    BQUE *point = (BQUE *)(p->arg_voidptr);
+    if (isPlayer(point->enactor))
     {
-        // This represents a semaphore.
-        //
-        BQUE *point = (BQUE *)(p->arg_voidptr);
-        if (  point->u.s.sem == Notify_Sem
-           && (  point->u.s.attr == Notify_Attr
-              || !Notify_Attr))
-        {
-            Notify_Num_Done++;
-            if (NFY_DRAIN == (Notify_Key & NFY_MASK))
-            {
-                // Discard the command
-                //
-                giveto(point->executor, mudconf.waitcost);
-                a_Queue(Owner(point->executor), -1);
-
-                for (int i = 0; i < MAX_GLOBAL_REGS; i++)
-                {
-                    if (point->scr[i])
-                    {
-                        RegRelease(point->scr[i]);
-                        point->scr[i] = nullptr;
-                    }
-                }
-
-                MEMFREE(point->text);
-                point->text = nullptr;
-                free_qentry(point);
-
-                return IU_REMOVE_TASK;
-            }
-            else
-            {
-                // Allow the command to run. The priority may have been
-                // PRIORITY_SUSPEND, so we need to change it.
-                //
-                if (isPlayer(point->enactor))
-                {
-                    p->iPriority = PRIORITY_PLAYER;
-                }
-                else
-                {
-                    p->iPriority = PRIORITY_OBJECT;
-                }
-                p->ltaWhen.GetUTC();
-                p->fpTask = Task_RunQueueEntry;
-                return IU_UPDATE_TASK;
-            }
-        }
+        p->iPriority = PRIORITY_PLAYER;
     }
-    return IU_NEXT_TASK;
+    else
+    {
+        p->iPriority = PRIORITY_OBJECT;
+    }
+    p->ltaWhen.GetUTC();
+    p->fpTask = Task_RunQueueEntry;
+    que_rekind(point, QUE_WAIT);
+    scheduler.UpdateTask(p);
 }
 
-// NFY_NFY
+// Discard a semaphore entry.
 //
-static int CallBack_NotifySemaphoreFirst(PTASK_RECORD p)
+static void DrainQueueEntry(PTASK_RECORD p)
 {
-    // If we've notified enough, exit.
-    //
-    if (  NFY_NFY == (Notify_Key & NFY_MASK)
-       && Notify_Num_Done >= Notify_Num_Max)
-    {
-        return IU_DONE;
-    }
+    BQUE *point = (BQUE *)(p->arg_voidptr);
+    giveto(point->executor, mudconf.waitcost);
+    a_Queue(Owner(point->executor), -1);
+    que_unindex(point);
 
-    if (p->fpTask == Task_SemaphoreTimeout)
+    for (int i = 0; i < MAX_GLOBAL_REGS; i++)
     {
-        // This represents a semaphore.
-        //
-        BQUE *point = (BQUE *)(p->arg_voidptr);
-        if (  point->u.s.sem == Notify_Sem
-           && (  point->u.s.attr == Notify_Attr
-              || !Notify_Attr))
+        if (point->scr[i])
         {
-            Notify_Num_Done++;
-
-            // Allow the command to run. The priority may have been
-            // PRIORITY_SUSPEND, so we need to change it.
-            //
-            if (isPlayer(point->enactor))
-            {
-                p->iPriority = PRIORITY_PLAYER;
-            }
-            else
-            {
-                p->iPriority = PRIORITY_OBJECT;
-            }
-            p->ltaWhen.GetUTC();
-            p->fpTask = Task_RunQueueEntry;
-            return IU_UPDATE_TASK;
+            RegRelease(point->scr[i]);
+            point->scr[i] = nullptr;
         }
     }
-    return IU_NEXT_TASK;
+
+    MEMFREE(point->text);
+    point->text = nullptr;
+    free_qentry(point);
+    scheduler.RemoveTask(p);
 }
 
 // ---------------------------------------------------------------------------
@@ -580,20 +1006,43 @@ int nfy_que(dbref sem, int attr, int key, int count)
         free_lbuf(str);
     }
 
-    Notify_Num_Done = 0;
-    if (0 < cSemaphore)
+    // Entries are released from the front of the wait lists. An attr of
+    // zero means every attribute of the semaphore.  A garbage semaphore is
+    // still drained.
+    //
+    int nDone = 0;
+    if (  0 < cSemaphore
+       && Good_dbref(sem))
     {
-        Notify_Key     = key;
-        Notify_Sem     = sem;
-        Notify_Attr    = attr;
-        Notify_Num_Max = count;
-        if (NFY_NFY == (key & NFY_MASK))
-        {
-            scheduler.TraverseOrdered(CallBack_NotifySemaphoreFirst);
-        }
-        else
+        for (;;)
         {
-            scheduler.TraverseUnordered(CallBack_NotifySemaphoreDrainOrAll);
+            if (  NFY_NFY == (key & NFY_MASK)
+               && count <= nDone)
+            {
+                break;
+            }
+
+            SEMWAIT *pw = attr ? que_waiters(sem, attr) : db[sem].queue_semaphore;
+            if (nullptr == pw)
+            {
+                break;
+            }
+
+            BQUE *point = pw->pUntimedHead;
+            if (nullptr == point)
+            {
+                point = pw->pTimedHead;
+            }
+
+            if (NFY_DRAIN == (key & NFY_MASK))
+            {
+                DrainQueueEntry(point->pTask);
+            }
+            else
+            {
+                NotifyQueueEntry(point->pTask);
+            }
+            nDone++;
         }
     }
 
@@ -608,7 +1057,7 @@ int nfy_que(dbref sem, int attr, int key, int count)
         atr_clr(sem, attr);
     }
 
-    return Notify_Num_Done;
+    return nDone;
 }
 
 // ---------------------------------------------------------------------------
@@ -854,17 +1303,22 @@ static BQUE *setup_que
     tmp->IsTimed = false;
     tmp->u.s.sem = NOTHING;
     tmp->u.s.attr = 0;
+    tmp->src_thing = mudstate.que_src_thing;
+    tmp->src_atr = mudstate.que_src_atr;
     tmp->enactor = enactor;
     tmp->caller = caller;
     tmp->eval = eval;
     tmp->nargs = nargs;
+    tmp->pTask = nullptr;
+    tmp->iKind = QUE_NONE;
     return tmp;
 }
 
 // ---------------------------------------------------------------------------
-// wait_que: Add commands to the wait or semaphore queues.
+// wait_que: Add commands to the wait or semaphore queues. Returns false if
+// nothing was queued.
 //
-void wait_que
+bool wait_que
 (
     dbref    executor,
     dbref    caller,
@@ -882,7 +1336,7 @@ void wait_que
 {
     if (!(mudconf.control_flags & CF_INTERP))
     {
-        return;
+        return false;
     }
 
     BQUE *tmp = setup_que(executor, caller, enactor, eval,
@@ -892,7 +1346,7 @@ void wait_que
 
     if (!tmp)
     {
-        return;
+        return false;
     }
 
     int iPriority;
@@ -910,6 +1364,10 @@ void wait_que
     tmp->u.s.sem = sem;
     tmp->u.s.attr = attr;
 
+    dbref owner = Owner(executor);
+    int iWeight = que_weight(owner);
+
+    PTASK_RECORD pTask;
     if (sem == NOTHING)
     {
         // Not a semaphore, so let it run it immediately or put it on
@@ -917,12 +1375,15 @@ void wait_que
         //
         if (tmp->IsTimed)
         {
-            scheduler.DeferTask(tmp->waittime, iPriority, Task_RunQueueEntry, tmp, 0);
+            pTask = scheduler.DeferTask(tmp->waittime, iPriority, Task_RunQueueEntry, tmp, 0,
+                owner, iWeight);
         }
         else
         {
-            scheduler.DeferImmediateTask(iPriority, Task_RunQueueEntry, tmp, 0);
+            pTask = scheduler.DeferImmediateTask(iPriority, Task_RunQueueEntry, tmp, 0,
+                owner, iWeight);
         }
+        que_index(tmp, pTask, QUE_WAIT);
     }
     else
     {
@@ -934,8 +1395,11 @@ void wait_que
             //
             iPriority = PRIORITY_SUSPEND;
         }
-        scheduler.DeferTask(tmp->waittime, iPriority, Task_SemaphoreTimeout, tmp, 0);
+        pTask = scheduler.DeferTask(tmp->waittime, iPriority, Task_SemaphoreTimeout, tmp, 0,
+            owner, iWeight);
+        que_index(tmp, pTask, QUE_SEMAPHORE);
     }
+    return (nullptr != pTask);
 }
 
 #if defined(STUB_SLAVE)
@@ -960,6 +1424,7 @@ static int CallBack_QueryComplete(PTASK_RECORD p)
             p->iPriority = PRIORITY_OBJECT;
             p->ltaWhen.GetUTC();
             p->fpTask    = Task_RunQueueEntry;
+            que_rekind(point, QUE_WAIT);
 
             point->u.s.sem    = NOTHING;
             point->u.s.attr   = 0;
@@ -1041,7 +1506,10 @@ void sql_que
 
     tmp->u.hQuery = hQuery;
 
-    scheduler.DeferTask(tmp->waittime, PRIORITY_SUSPEND, Task_SQLTimeout, tmp, 0);
+    dbref owner = Owner(executor);
+    PTASK_RECORD pTask = scheduler.DeferTask(tmp->waittime, PRIORITY_SUSPEND, Task_SQLTimeout, tmp, 0,
+        owner, que_weight(owner));
+    que_index(tmp, pTask, QUE_SQL);
     MUX_RESULT mr = mudstate.pIQueryControl->Query(hQuery, dbname, query);
     if (MUX_FAILED(mr))
     {
@@ -1155,7 +1623,8 @@ void do_wait
             }
         }
 
-        int num = add_to(thing, 1, atr);
+        dbref sem = thing;
+        int num = add_to(sem, 1, atr);
         if (num <= 0)
         {
             // Thing over-notified, run the command immediately.
@@ -1163,10 +1632,15 @@ void do_wait
             thing = NOTHING;
             bTimed = false;
         }
-        wait_que(executor, caller, enactor, eval, bTimed, ltaWhen, thing, atr,
+        if (!wait_que(executor, caller, enactor, eval, bTimed, ltaWhen, thing, atr,
             cmd,
             ncargs, cargs,
-            mudstate.global_regs);
+            mudstate.global_regs))
+        {
+            // Nothing is waiting, so the count must not say otherwise.
+            //
+            add_to(sem, -1, atr);
+        }
     }
 }
 
@@ -1235,9 +1709,7 @@ void do_query
 
 static CLinearTimeAbsolute Show_lsaNow;
 static int Total_SystemTasks;
-static int Total_RunQueueEntry;
 static int Shown_RunQueueEntry;
-static int Total_SemaphoreTimeout;
 static int Shown_SemaphoreTimeout;
 static dbref Show_Player_Target;
 static dbref Show_Object_Target;
@@ -1245,8 +1717,7 @@ static int Show_Key;
 static dbref Show_Player;
 static int Show_bFirstLine;
 
-int Total_SQLTimeout;
-int Shown_SQLTimeout;
+static int Shown_SQLTimeout;
 
 static int CallBack_ShowDispatches(PTASK_RECORD p)
 {
@@ -1260,17 +1731,23 @@ static int CallBack_ShowDispatches(PTASK_RECORD p)
     {
         notify(Show_Player, tprintf(T("[%d]auto-@dbck"), ltd.ReturnSeconds()));
     }
-    else if (p->fpTask == dispatch_IdleCheck)
+    else if (p->fpTask == Task_IdleCheck)
     {
-        notify(Show_Player, tprintf(T("[%d]Check for idle players"), ltd.ReturnSeconds()));
+        notify(Show_Player, tprintf(T("[%d]Check for idle descriptor %u"), ltd.ReturnSeconds(),
+            ((DESC *)p->arg_voidptr)->descriptor));
     }
     else if (p->fpTask == dispatch_CheckEvents)
     {
         notify(Show_Player, tprintf(T("[%d]Test for @daily time"), ltd.ReturnSeconds()));
     }
-    else if (p->fpTask == dispatch_KeepAlive)
+    else if (p->fpTask == Task_KeepAlive)
     {
-        notify(Show_Player, tprintf(T("[%d]Keep Alive"), ltd.ReturnSeconds()));
+        notify(Show_Player, tprintf(T("[%d]Keep Alive descriptor %u"), ltd.ReturnSeconds(),
+            ((DESC *)p->arg_voidptr)->descriptor));
+    }
+    else if (p->fpTask == dispatch_JournalCommit)
+    {
+        notify(Show_Player, tprintf(T("[%d]Journal commit"), ltd.ReturnSeconds()));
     }
 #ifndef MEMORY_BASED
     else if (p->fpTask == dispatch_CacheTick)
@@ -1349,7 +1826,6 @@ static int CallBack_ShowWait(PTASK_RECORD p)
         return IU_NEXT_TASK;
     }
 
-    Total_RunQueueEntry++;
     BQUE *tmp = (BQUE *)(p->arg_voidptr);
     if (que_want(tmp, Show_Player_Target, Show_Object_Target))
     {
@@ -1375,7 +1851,6 @@ static int CallBack_ShowSemaphore(PTASK_RECORD p)
         return IU_NEXT_TASK;
     }
 
-    Total_SemaphoreTimeout++;
     BQUE *tmp = (BQUE *)(p->arg_voidptr);
     if (que_want(tmp, Show_Player_Target, Show_Object_Target))
     {
@@ -1394,14 +1869,13 @@ static int CallBack_ShowSemaphore(PTASK_RECORD p)
     return IU_NEXT_TASK;
 }
 
-int CallBack_ShowSQLQueries(PTASK_RECORD p)
+static int CallBack_ShowSQLQueries(PTASK_RECORD p)
 {
     if (p->fpTask != Task_SQLTimeout)
     {
         return IU_NEXT_TASK;
     }
 
-    Total_SQLTimeout++;
     BQUE *tmp = (BQUE *)(p->arg_voidptr);
     if (que_want(tmp, Show_Player_Target, Show_Object_Target))
     {
@@ -1420,6 +1894,19 @@ int CallBack_ShowSQLQueries(PTASK_RECORD p)
     return IU_NEXT_TASK;
 }
 
+// Queued entries, share weight, and CPU spent running queued commands for
+// the owner.
+//
+static void ShowPsOwner(dbref owner)
+{
+    UTF8 *bufp = alloc_mbuf("ShowPsOwner");
+    mux_sprintf(bufp, MBUF_SIZE, T("Owner: %s(#%d)  Queued...%d  Weight...%d  CPU...%ldms"),
+        PureName(owner), owner, a_Queue(owner, 0), que_weight(owner),
+        db[owner].queue_cpu_time.ReturnMilliseconds());
+    notify(Show_Player, bufp);
+    free_mbuf(bufp);
+}
+
 // ---------------------------------------------------------------------------
 // do_ps: tell executor what commands they have pending in the queue
 //
@@ -1492,35 +1979,67 @@ void do_ps(dbref executor, dbref caller, dbref enactor, int eval, int key, UTF8
 
     Show_lsaNow.GetUTC();
     Total_SystemTasks = 0;
-    Total_RunQueueEntry = 0;
     Shown_RunQueueEntry = 0;
-    Total_SemaphoreTimeout = 0;
     Shown_SemaphoreTimeout = 0;
-    Total_SQLTimeout = 0;
     Shown_SQLTimeout = 0;
     Show_Player_Target = executor_targ;
     Show_Object_Target = obj_targ;
     Show_Key = key;
     Show_Player = executor;
-    Show_bFirstLine = true;
-    scheduler.TraverseOrdered(CallBack_ShowWait);
-    Show_bFirstLine = true;
-    scheduler.TraverseOrdered(CallBack_ShowSemaphore);
-    Show_bFirstLine = true;
-    scheduler.TraverseOrdered(CallBack_ShowSQLQueries);
+    if (  NOTHING == executor_targ
+       && NOTHING == obj_targ)
+    {
+        Show_bFirstLine = true;
+        scheduler.TraverseOrdered(CallBack_ShowWait);
+        Show_bFirstLine = true;
+        scheduler.TraverseOrdered(CallBack_ShowSemaphore);
+        Show_bFirstLine = true;
+        scheduler.TraverseOrdered(CallBack_ShowSQLQueries);
+    }
+    else
+    {
+        // Only the target's entries are visited, in the same order.
+        //
+        PTASK_RECORD *aTasks;
+        int nTasks = que_gather(executor_targ, obj_targ, &aTasks);
+        scheduler.SortTasks(aTasks, nTasks);
+
+        int i;
+        Show_bFirstLine = true;
+        for (i = 0; i < nTasks; i++)
+        {
+            CallBack_ShowWait(aTasks[i]);
+        }
+        Show_bFirstLine = true;
+        for (i = 0; i < nTasks; i++)
+        {
+            CallBack_ShowSemaphore(aTasks[i]);
+        }
+        Show_bFirstLine = true;
+        for (i = 0; i < nTasks; i++)
+        {
+            CallBack_ShowSQLQueries(aTasks[i]);
+        }
+
+        if (nullptr != aTasks)
+        {
+            MEMFREE(aTasks);
+            aTasks = nullptr;
+        }
+    }
     if (Wizard(executor))
     {
         notify(executor, T("----- System Queue -----"));
-        scheduler.TraverseOrdered(CallBack_ShowDispatches);
+        scheduler.TraverseOrdered(CallBack_ShowDispatches, PRIORITY_SYSTEM);
     }
 
     // Display stats.
     //
     bufp = alloc_mbuf("do_ps");
     mux_sprintf(bufp, MBUF_SIZE, T("Totals: Wait Queue...%d/%d  Semaphores...%d/%d  SQL %d/%d"),
-        Shown_RunQueueEntry, Total_RunQueueEntry,
-        Shown_SemaphoreTimeout, Total_SemaphoreTimeout,
-        Shown_SQLTimeout, Total_SQLTimeout);
+        Shown_RunQueueEntry, que_count[QUE_WAIT],
+        Shown_SemaphoreTimeout, que_count[QUE_SEMAPHORE],
+        Shown_SQLTimeout, que_count[QUE_SQL]);
     notify(executor, bufp);
     if (Wizard(executor))
     {
@@ -1528,6 +2047,31 @@ void do_ps(dbref executor, dbref caller, dbref enactor, int eval, int key, UTF8
         notify(executor, bufp);
     }
     free_mbuf(bufp);
+
+    if (PS_SUMM == key)
+    {
+        if (NOTHING != obj_targ)
+        {
+            ShowPsOwner(Owner(obj_targ));
+        }
+        else if (NOTHING != executor_targ)
+        {
+            ShowPsOwner(executor_targ);
+        }
+        else
+        {
+            dbref owner;
+            DO_WHOLE_DB(owner)
+            {
+                if (  isPlayer(owner)
+                   && (  nullptr != db[owner].queue_owner
+                      || 0 != db[owner].queue_cpu_time.Return100ns()))
+                {
+                    ShowPsOwner(owner);
+                }
+            }
+        }
+    }
 }
 
 static CLinearTimeDelta ltdWarp;
@@ -86,8 +86,8 @@ static void open_exit(dbref player, dbref loc, UTF8 *direction, UTF8 *linkto)
     // Initialize everything and link it in.
     //
     s_Exits(exit, loc);
-    s_Next(exit, Exits(loc));
-    s_Exits(loc, exit);
+    s_Exits(loc, insert_first(Exits(loc), exit));
+    exitindex_drop(loc);
     local_data_create(exit);
     ServerEventsSinkNode *p = g_pServerEventsSinkListHead;
     while (nullptr != p)
@@ -231,6 +231,7 @@ static void link_exit(dbref player, dbref exit, dbref dest)
         s_Owner(exit, Owner(player));
         db[exit].fs.word[FLAG_WORD1] &= ~(INHERIT | WIZARD);
         db[exit].fs.word[FLAG_WORD1] |= HALT;
+        db_dirty(exit);
     }
 
     // Link has been validated and paid for, do it and tell the player
@@ -503,6 +504,7 @@ void do_parent
     }
 
     s_Parent(thing, parent);
+    cmdindex_touch(thing);
 
     // Now that parent is set, handle zero, one, or two @aparent notifications
     // as necessary.
@@ -911,6 +913,7 @@ void do_clone
 
         s_Exits(loc, insert_first(Exits(loc), clone));
         s_Exits(clone, loc);
+        exitindex_drop(loc);
         s_Location(clone, NOTHING);
         if (Location(thing) != NOTHING)
         {
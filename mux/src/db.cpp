@@ -25,6 +25,10 @@
 #include "command.h"
 #include "comsys.h"
 #include "interface.h"
+#include "journal.h"
+#ifdef REALITY_LVLS
+#include "levels.h"
+#endif // REALITY_LVLS
 #include "mathutil.h"
 #include "powers.h"
 #include "vattr.h"
@@ -33,7 +37,7 @@
 #define O_ACCMODE   (O_RDONLY|O_WRONLY|O_RDWR)
 #endif // O_ACCMODE
 
-OBJ *db = nullptr;
+CObjectTable db = { nullptr, 0 };
 
 typedef struct atrcount ATRCOUNT;
 struct atrcount
@@ -87,6 +91,7 @@ ATTR AttrTable[] =
     {T("Comon"),       A_COMON,    AF_ODARK | AF_NOPROG},
     {T("ConFormat"),   A_CONFORMAT, AF_ODARK | AF_NOPROG},
     {T("Cost"),        A_COST,     AF_ODARK | AF_NOPROG},
+    {T("CpuMax"),      A_CPUMAX,   AF_MDARK | AF_WIZARD | AF_NOPROG},
     {T("Created"),     A_CREATED,  AF_ODARK | AF_NOPROG | AF_NOCMD | AF_NOCLONE | AF_CONST | AF_NODECOMP},
     {T("Daily"),       A_DAILY,    AF_ODARK | AF_NOPROG},
     {T("Desc"),        A_DESC,     AF_VISUAL | AF_NOPROG},
@@ -779,6 +784,8 @@ void free_Names(OBJ *p)
 
 void s_Name(dbref thing, const UTF8 *s)
 {
+    exitindex_touch(thing);
+    name_index_rename(thing, s);
     free_Names(&db[thing]);
     atr_add_raw(thing, A_NAME, s);
 #ifndef MEMORY_BASED
@@ -915,9 +922,15 @@ void do_attribute
             sp = mux_strtok_parse(&tts);
         }
 
-        if (success && !Quiet(executor))
+        if (success)
         {
-            notify(executor, T("Attribute access changed."));
+            journal_attr_name(va);
+            db_vattrs_dirty = true;
+            atr_resolve_flush();
+            if (!Quiet(executor))
+            {
+                notify(executor, T("Attribute access changed."));
+            }
         }
         break;
 
@@ -949,6 +962,7 @@ void do_attribute
             }
             else
             {
+                lockcache_flush();
                 notify(executor, T("Attribute renamed."));
             }
         }
@@ -959,6 +973,8 @@ void do_attribute
         // Remove the attribute.
         //
         vattr_delete_LEN(pName, nName);
+        atr_resolve_flush();
+        lockcache_flush();
         notify(executor, T("Attribute deleted."));
         break;
     }
@@ -1027,6 +1043,8 @@ void do_fixdb
     case FIXDB_LOC:
 
         s_Location(thing, res);
+        cmdindex_drop_all();
+        hearlist_drop_all();
         if (!Quiet(executor))
             notify(executor, tprintf(T("Location set to #%d"), res));
         break;
@@ -1034,6 +1052,9 @@ void do_fixdb
     case FIXDB_CON:
 
         s_Contents(thing, res);
+        db_link_lists();
+        cmdindex_drop_all();
+        hearlist_drop_all();
         if (!Quiet(executor))
             notify(executor, tprintf(T("Contents set to #%d"), res));
         break;
@@ -1041,6 +1062,8 @@ void do_fixdb
     case FIXDB_EXITS:
 
         s_Exits(thing, res);
+        db_link_lists();
+        exitindex_drop_all();
         if (!Quiet(executor))
             notify(executor, tprintf(T("Exits set to #%d"), res));
         break;
@@ -1048,6 +1071,10 @@ void do_fixdb
     case FIXDB_NEXT:
 
         s_Next(thing, res);
+        db_link_lists();
+        cmdindex_drop_all();
+        hearlist_drop_all();
+        exitindex_drop_all();
         if (!Quiet(executor))
             notify(executor, tprintf(T("Next set to #%d"), res));
         break;
@@ -2024,13 +2051,82 @@ static void atr_decode_LEN(const UTF8 *iattr, size_t nLen, UTF8 *oattr,
     }
 }
 
+/* ---------------------------------------------------------------------------
+ * Inherited attribute resolution cache.
+ *
+ * Maps (object, attribute) to the ancestor that supplies the attribute (or
+ * NOTHING when none does), so that repeated inherited fetches cost a single
+ * attribute lookup instead of one per level of the parent chain.
+ *
+ * An entry is good as long as both generations it was filled under are
+ * current.  The global generation moves whenever the shape of any chain or
+ * the meaning of AF_PRIVATE changes: a parent is set, an object's
+ * attributes are freed, an attribute definition changes, or the parent
+ * nesting limit changes.  The per-attribute generation moves when that
+ * attribute is set or cleared on an object that lies on some cached chain
+ * (bfAttrResolve), since that can make the attribute appear, disappear, or
+ * become no_inherit part way along the chain.
+ */
+
+#define ATR_RESOLVE_SIZE    4096
+#define ATR_RESOLVE_GENS    1024
+
+typedef struct
+{
+    dbref        thing;
+    int          atr;
+    dbref        ancestor;
+    unsigned int gen;
+    unsigned int atr_gen;
+} ATR_RESOLVE;
+
+static ATR_RESOLVE  atr_resolve_cache[ATR_RESOLVE_SIZE];
+static unsigned int atr_resolve_gen = 1;
+static unsigned int atr_resolve_atr_gen[ATR_RESOLVE_GENS];
+
+static inline ATR_RESOLVE *atr_resolve_slot(dbref thing, int atr)
+{
+    UINT32 h = static_cast<UINT32>(thing) * 2654435761U
+             ^ static_cast<UINT32>(atr) * 40503U;
+    return &atr_resolve_cache[(h ^ (h >> 16)) & (ATR_RESOLVE_SIZE - 1)];
+}
+
+void atr_resolve_flush(void)
+{
+    atr_resolve_gen++;
+    if (0 == atr_resolve_gen)
+    {
+        // Generation zero marks an empty slot.
+        //
+        memset(atr_resolve_cache, 0, sizeof(atr_resolve_cache));
+        atr_resolve_gen = 1;
+    }
+}
+
+static void atr_resolve_changed(dbref thing, int atr)
+{
+    if (mudstate.bfAttrResolve.IsSet(thing))
+    {
+        atr_resolve_atr_gen[atr & (ATR_RESOLVE_GENS - 1)]++;
+    }
+}
+
 /* ---------------------------------------------------------------------------
  * atr_clr: clear an attribute in the list.
  */
 
 void atr_clr(dbref thing, int atr)
 {
+    journal_attr_clr(thing, atr);
+    cmdcache_changed(thing, atr, nullptr);
+    atr_resolve_changed(thing, atr);
+    lockcache_changed(thing, atr);
+    latency_forget(thing, atr);
+
 #ifdef MEMORY_BASED
+    // Attribute values are part of the checkpoint.
+    //
+    db_dirty(thing);
 
     if (  !db[thing].nALUsed
        || !db[thing].pALHead)
@@ -2084,16 +2180,19 @@ void atr_clr(dbref thing, int atr)
     case A_STARTUP:
 
         db[thing].fs.word[FLAG_WORD1] &= ~HAS_STARTUP;
+        db_dirty(thing);
         break;
 
     case A_DAILY:
 
         db[thing].fs.word[FLAG_WORD2] &= ~HAS_DAILY;
+        db_dirty(thing);
         break;
 
     case A_FORWARDLIST:
 
         db[thing].fs.word[FLAG_WORD2] &= ~HAS_FWDLIST;
+        db_dirty(thing);
         if (!mudstate.bStandAlone)
         {
             // We should clear the hashtable, too.
@@ -2105,6 +2204,8 @@ void atr_clr(dbref thing, int atr)
     case A_LISTEN:
 
         db[thing].fs.word[FLAG_WORD2] &= ~HAS_LISTEN;
+        db_dirty(thing);
+        hearlist_touch(thing);
         break;
 
     case A_TIMEOUT:
@@ -2117,6 +2218,18 @@ void atr_clr(dbref thing, int atr)
         pcache_reload(thing);
         break;
 
+    case A_CPUMAX:
+
+        db[thing].cpu_max = -1;
+        break;
+
+#ifdef REALITY_LVLS
+    case A_RLEVEL:
+
+        rlevel_changed(thing, nullptr);
+        break;
+#endif // REALITY_LVLS
+
     default:
 
         // Since this could overwrite an existing ^-Command or $-Command, we
@@ -2141,7 +2254,19 @@ void atr_add_raw_LEN(dbref thing, int atr, const UTF8 *szValue, size_t nValue)
         return;
     }
 
+#ifndef MEMORY_BASED
+    if (nValue > LBUF_SIZE-1)
+    {
+        nValue = LBUF_SIZE-1;
+    }
+#endif // !MEMORY_BASED
+    journal_attr_set(thing, atr, szValue, nValue);
+    cmdcache_changed(thing, atr, szValue);
+    atr_resolve_changed(thing, atr);
+    lockcache_changed(thing, atr);
+
 #ifdef MEMORY_BASED
+    db_dirty(thing);
     ATRLIST *list = db[thing].pALHead;
     UTF8 *text = StringCloneLen(szValue, nValue);
 
@@ -2247,11 +2372,6 @@ FoundAttribute:
 
 #else // MEMORY_BASED
 
-    if (nValue > LBUF_SIZE-1)
-    {
-        nValue = LBUF_SIZE-1;
-    }
-
     Aname okey;
     makekey(thing, atr, &okey);
     if (atr == A_LIST)
@@ -2275,21 +2395,26 @@ FoundAttribute:
     case A_STARTUP:
 
         db[thing].fs.word[FLAG_WORD1] |= HAS_STARTUP;
+        db_dirty(thing);
         break;
 
     case A_DAILY:
 
         db[thing].fs.word[FLAG_WORD2] |= HAS_DAILY;
+        db_dirty(thing);
         break;
 
     case A_FORWARDLIST:
 
         db[thing].fs.word[FLAG_WORD2] |= HAS_FWDLIST;
+        db_dirty(thing);
         break;
 
     case A_LISTEN:
 
         db[thing].fs.word[FLAG_WORD2] |= HAS_LISTEN;
+        db_dirty(thing);
+        hearlist_touch(thing);
         break;
 
     case A_TIMEOUT:
@@ -2301,6 +2426,18 @@ FoundAttribute:
 
         pcache_reload(thing);
         break;
+
+    case A_CPUMAX:
+
+        db[thing].cpu_max = -1;
+        break;
+
+#ifdef REALITY_LVLS
+    case A_RLEVEL:
+
+        rlevel_changed(thing, szValue);
+        break;
+#endif // REALITY_LVLS
     }
 }
 
@@ -2486,35 +2623,93 @@ bool atr_get_info(dbref thing, int atr, dbref *owner, int *flags)
     return true;
 }
 
-UTF8 *atr_pget_str_LEN(UTF8 *s, dbref thing, int atr, dbref *owner, int *flags, size_t *pLen)
+// atr_pget_raw_LEN: Find the raw (encoded) value of an attribute on an
+// object or the nearest ancestor which lets the object inherit it.
+//
+static const UTF8 *atr_pget_raw_LEN(dbref thing, int atr, size_t *pLen)
 {
-    dbref parent;
-    int lev;
-    ATTR *ap;
+    if (  !Good_obj(thing)
+       || mudconf.parent_nest_lim <= 0)
+    {
+        return nullptr;
+    }
+
     const UTF8 *buff;
+    if (!Good_obj(Parent(thing)))
+    {
+        buff = atr_get_raw_LEN(thing, atr, pLen);
+        return (buff && *buff) ? buff : nullptr;
+    }
+
+    ATR_RESOLVE *pr = atr_resolve_slot(thing, atr);
+    unsigned int atr_gen = atr_resolve_atr_gen[atr & (ATR_RESOLVE_GENS - 1)];
+    if (  pr->gen == atr_resolve_gen
+       && pr->atr_gen == atr_gen
+       && pr->thing == thing
+       && pr->atr == atr)
+    {
+        if (NOTHING == pr->ancestor)
+        {
+            return nullptr;
+        }
+        buff = atr_get_raw_LEN(pr->ancestor, atr, pLen);
+        if (buff && *buff)
+        {
+            return buff;
+        }
+    }
 
+    // Walk the chain, and remember each object on it so that changes to
+    // them invalidate what we learn here.
+    //
+    dbref parent;
+    int lev;
+    dbref ancestor = NOTHING;
+    buff = nullptr;
     ITER_PARENTS(thing, parent, lev)
     {
+        mudstate.bfAttrResolve.Set(parent);
         buff = atr_get_raw_LEN(parent, atr, pLen);
         if (buff && *buff)
         {
-            atr_decode_LEN(buff, *pLen, s, thing, owner, flags, pLen);
+            dbref aowner;
+            int aflags;
+            atr_decode_flags_owner(buff, &aowner, &aflags);
             if (  lev == 0
-               || !(*flags & AF_PRIVATE))
+               || !(aflags & AF_PRIVATE))
             {
-                return s;
+                ancestor = parent;
+                break;
             }
         }
+        buff = nullptr;
         if (  lev == 0
            && Good_obj(Parent(parent)))
         {
-            ap = atr_num(atr);
+            ATTR *ap = atr_num(atr);
             if (!ap || ap->flags & AF_PRIVATE)
             {
                 break;
             }
         }
     }
+
+    pr->thing    = thing;
+    pr->atr      = atr;
+    pr->ancestor = ancestor;
+    pr->gen      = atr_resolve_gen;
+    pr->atr_gen  = atr_gen;
+    return buff;
+}
+
+UTF8 *atr_pget_str_LEN(UTF8 *s, dbref thing, int atr, dbref *owner, int *flags, size_t *pLen)
+{
+    const UTF8 *buff = atr_pget_raw_LEN(thing, atr, pLen);
+    if (buff)
+    {
+        atr_decode_LEN(buff, *pLen, s, thing, owner, flags, pLen);
+        return s;
+    }
     *owner = Owner(thing);
     *flags = 0;
     *s = '\0';
@@ -2544,41 +2739,58 @@ UTF8 *atr_pget_real(dbref thing, int atr, dbref *owner, int *flags,
 
 bool atr_pget_info(dbref thing, int atr, dbref *owner, int *flags)
 {
-    dbref parent;
-    int lev;
-    ATTR *ap;
-
-    ITER_PARENTS(thing, parent, lev)
+    size_t nLen;
+    const UTF8 *buff = atr_pget_raw_LEN(thing, atr, &nLen);
+    if (buff)
     {
-        size_t nLen;
-        const UTF8 *buff = atr_get_raw_LEN(parent, atr, &nLen);
-        if (buff && *buff)
-        {
-            atr_decode_LEN(buff, nLen, nullptr, thing, owner, flags, &nLen);
-            if ((lev == 0) || !(*flags & AF_PRIVATE))
-            {
-                return true;
-            }
-        }
-        if ((lev == 0) && Good_obj(Parent(parent)))
-        {
-            ap = atr_num(atr);
-            if (!ap || ap->flags & AF_PRIVATE)
-                break;
-        }
+        atr_decode_LEN(buff, nLen, nullptr, thing, owner, flags, &nLen);
+        return true;
     }
     *owner = Owner(thing);
     *flags = 0;
     return false;
 }
 
+// atr_pget_text_LEN: Like atr_pget_str_LEN, but points at the stored text
+// rather than copying it.  The pointer is only good until the next
+// attribute operation.
+//
+const UTF8 *atr_pget_text_LEN(dbref thing, int atr, size_t *pLen)
+{
+    size_t nLen;
+    const UTF8 *buff = atr_pget_raw_LEN(thing, atr, &nLen);
+    if (buff)
+    {
+        dbref aowner;
+        int   aflags;
+        const UTF8 *p = atr_decode_flags_owner(buff, &aowner, &aflags);
+        *pLen = nLen - (p - buff);
+        return p;
+    }
+    *pLen = 0;
+    return T("");
+}
+
 /* ---------------------------------------------------------------------------
  * atr_free: Reset all attributes of an object.
  */
 
 void atr_free(dbref thing)
 {
+    cmdcache_clear(thing);
+    if (mudstate.bfAttrResolve.IsSet(thing))
+    {
+        atr_resolve_flush();
+    }
+    latency_forget(thing, 0);
+
 #ifdef MEMORY_BASED
+    for (int i = 0; i < db[thing].nALUsed; i++)
+    {
+        lockcache_changed(thing, db[thing].pALHead[i].number);
+        MEMFREE(db[thing].pALHead[i].data);
+        db[thing].pALHead[i].data = nullptr;
+    }
     if (db[thing].pALHead)
     {
         MEMFREE(db[thing].pALHead);
@@ -2586,6 +2798,9 @@ void atr_free(dbref thing)
     db[thing].pALHead  = nullptr;
     db[thing].nALAlloc = 0;
     db[thing].nALUsed  = 0;
+#ifdef REALITY_LVLS
+    db[thing].iRLevel  = -1;
+#endif // REALITY_LVLS
 #else // MEMORY_BASED
     atr_push();
     unsigned char *as;
@@ -2900,14 +3115,28 @@ bool attr_info::get_info(bool bParent)
  * db_grow: Extend the struct database.
  */
 
-#define SIZE_HACK   1   // So mistaken refs to #-1 won't die.
-
 static void initialize_objects(dbref first, dbref last)
 {
     dbref thing;
 
     for (thing = first; thing < last; thing++)
     {
+        db[thing].dirty = 0;
+        db[thing].queue_executor = nullptr;
+        db[thing].queue_owner = nullptr;
+        db[thing].queue_semaphore = nullptr;
+        db[thing].cmd_cache = nullptr;
+        db[thing].location = NOTHING;
+        db[thing].link = NOTHING;
+        db[thing].owner = NOTHING;
+        db[thing].parent = NOTHING;
+        db[thing].zone = NOTHING;
+        for (int i = 0; i < DBI_COUNT; i++)
+        {
+            db[thing].index_head[i] = NOTHING;
+            db[thing].index_next[i] = NOTHING;
+            db[thing].index_prev[i] = NOTHING;
+        }
         s_Owner(thing, GOD);
         s_Flags(thing, FLAG_WORD1, (TYPE_GARBAGE | GOING));
         s_Powers(thing, 0);
@@ -2917,12 +3146,18 @@ static void initialize_objects(dbref first, dbref last)
         s_Exits(thing, NOTHING);
         s_Link(thing, NOTHING);
         s_Next(thing, NOTHING);
+        s_Prev(thing, NOTHING);
         s_Zone(thing, NOTHING);
         s_Parent(thing, NOTHING);
 #ifdef DEPRECATED
         s_Stack(thing, nullptr);
 #endif // DEPRECATED
         db[thing].cpu_time_used.Set100ns(0);
+        db[thing].queue_cpu_time.Set100ns(0);
+        db[thing].cpu_max = -1;
+#ifdef REALITY_LVLS
+        db[thing].iRLevel = -1;
+#endif // REALITY_LVLS
         db[thing].tThrottleExpired.Set100ns(0);
         s_ThAttrib(thing, 0);
         s_ThMail(thing, 0);
@@ -2937,133 +3172,919 @@ static void initialize_objects(dbref first, dbref last)
 #endif // MEMORY_BASED
         db[thing].purename = nullptr;
         db[thing].moniker = nullptr;
+        db[thing].name_folded = nullptr;
+
+        // Unused objects are not worth collecting.  If one is put to use,
+        // that will mark it again.
+        //
+        db[thing].dirty = 0;
     }
 }
 
-void db_grow(dbref newtop)
+int db_dirty_mask = 0;
+
+// User-named attributes have been defined, changed, or deleted since the last
+// checkpoint.
+//
+bool db_vattrs_dirty = false;
+
+// Objects marked DB_DIRTY_CHECKPOINT are also remembered here, so a delta and
+// the clearing after it cost as much as the objects changed.  An object may
+// appear more than once, or after its mark has been cleared.
+//
+static dbref *aCheckpoint = nullptr;
+static int nCheckpoint = 0;
+static int nCheckpointAlloc = 0;
+
+// db_index_compare: qsort() comparison for lists of dbrefs.
+//
+int DCL_CDECL db_index_compare(const void *p1, const void *p2)
 {
-    mudstate.bfCommands.Resize(newtop);
-    mudstate.bfNoCommands.Resize(newtop);
-    mudstate.bfListens.Resize(newtop);
-    mudstate.bfNoListens.Resize(newtop);
+    dbref d1 = *(const dbref *)p1;
+    dbref d2 = *(const dbref *)p2;
+    return (d1 < d2) ? -1 : ((d1 > d2) ? 1 : 0);
+}
 
-    int delta;
-    if (mudstate.bStandAlone)
+void db_set_dirty(dbref thing)
+{
+    int fNew = db_dirty_mask & ~db[thing].dirty;
+    db[thing].dirty |= fNew;
+    if (fNew & DB_DIRTY_JOURNAL)
     {
-        delta = 1000;
+        journal_header_dirty(thing);
     }
-    else
+    if (fNew & DB_DIRTY_CHECKPOINT)
     {
-        delta = mudconf.init_size;
+        if (nCheckpointAlloc <= nCheckpoint)
+        {
+            int nNew = GrowFiftyPercent(nCheckpointAlloc, 1024, INT_MAX);
+            dbref *aNew = (dbref *)MEMALLOC(nNew * sizeof(dbref));
+            ISOUTOFMEMORY(aNew);
+            if (aCheckpoint)
+            {
+                memcpy(aNew, aCheckpoint, nCheckpoint * sizeof(dbref));
+                MEMFREE(aCheckpoint);
+            }
+            aCheckpoint = aNew;
+            nCheckpointAlloc = nNew;
+        }
+        aCheckpoint[nCheckpoint++] = thing;
     }
+}
 
-    // Determine what to do based on requested size, current top and size.
-    // Make sure we grow in reasonable-sized chunks to prevent frequent
-    // reallocations of the db array.
-    //
-    // If requested size is smaller than the current db size, ignore it.
-    //
-    if (newtop <= mudstate.db_top)
+// db_checkpoint_objects: Return, in dbref order, the objects changed since
+// the last checkpoint.  The list is only good until the next change.
+//
+int db_checkpoint_objects(dbref **paList)
+{
+    if (1 < nCheckpoint)
     {
-        return;
+        qsort(aCheckpoint, nCheckpoint, sizeof(dbref), db_index_compare);
     }
 
-    // If requested size is greater than the current db size but smaller
-    // than the amount of space we have allocated, raise the db size and
-    // initialize the new area.
-    //
-    if (newtop <= mudstate.db_size)
+    int nKept = 0;
+    for (int i = 0; i < nCheckpoint; i++)
     {
-        initialize_objects(mudstate.db_top, newtop);
-        mudstate.db_top = newtop;
-        return;
+        dbref thing = aCheckpoint[i];
+        if (  0 <= thing
+           && thing < mudstate.db_top
+           && (db[thing].dirty & DB_DIRTY_CHECKPOINT)
+           && (  0 == nKept
+              || aCheckpoint[nKept-1] != thing))
+        {
+            aCheckpoint[nKept++] = thing;
+        }
     }
+    nCheckpoint = nKept;
+    *paList = aCheckpoint;
+    return nCheckpoint;
+}
 
-    // Grow by a minimum of delta objects
-    //
-    int newsize = newtop;
-    int nMinimumGrowth = mudstate.db_size + delta;
-    if (newtop <= nMinimumGrowth)
+void db_clear_checkpoint(void)
+{
+    db_vattrs_dirty = false;
+    for (int i = 0; i < nCheckpoint; i++)
     {
-        newsize = nMinimumGrowth;
+        dbref thing = aCheckpoint[i];
+        if (  0 <= thing
+           && thing < mudstate.db_top)
+        {
+            db[thing].dirty &= ~DB_DIRTY_CHECKPOINT;
+        }
     }
+    nCheckpoint = 0;
+}
 
-    // Enforce minimum database size
-    //
-    if (newsize < mudstate.min_size)
+/* ---------------------------------------------------------------------------
+ * db_link_lists: Rebuild the back links of every contents and exits list.
+ *
+ * Prev() is not saved in the flatfile, so it is derived from the Next()
+ * chains after loading and after anything rewrites those chains wholesale.
+ */
+
+void db_link_lists(void)
+{
+    dbref thing;
+    for (thing = 0; thing < mudstate.db_top; thing++)
     {
-        newsize = mudstate.min_size;
+        s_Prev(thing, NOTHING);
     }
 
-    // Grow the db array
-    //
-
-    // NOTE: There is always one copy of 'db' around that isn't freed even
-    // just before the process terminates. We rely (quite safely) on the OS
-    // to reclaim the memory.
-    //
-    OBJ *newdb = (OBJ *)MEMALLOC((newsize + SIZE_HACK) * sizeof(OBJ));
-    ISOUTOFMEMORY(newdb);
-    if (db)
+    for (thing = 0; thing < mudstate.db_top; thing++)
     {
-        // An old struct database exists. Copy it to the new buffer.
-        //
-        db -= SIZE_HACK;
-        memcpy(newdb, db, (mudstate.db_top + SIZE_HACK) * sizeof(OBJ));
-        MEMFREE(db);
+        if (  isExit(thing)
+           || isGarbage(thing))
+        {
+            continue;
+        }
+
+        dbref heads[2] = { Contents(thing), Exits(thing) };
+        for (int i = 0; i < 2; i++)
+        {
+            dbref prev = NOTHING;
+            dbref cur = heads[i];
+            int count = 0;
+            while (  Good_dbref(cur)
+                  && count++ < mudstate.db_top)
+            {
+                s_Prev(cur, prev);
+                prev = cur;
+                cur = Next(cur);
+                if (cur == prev)
+                {
+                    break;
+                }
+            }
+        }
     }
-    else
+}
+
+/* ---------------------------------------------------------------------------
+ * db_index_*: Owner, parent, zone, destination, and home indexes.
+ *
+ * Until db_index_rebuild() has run, the setters only store the field.  That
+ * keeps loading cheap and lets the loaders refer to objects that have not
+ * been read yet.
+ *
+ * Location and Link mean different things for different types, so only
+ * exits and rooms are indexed by Location, and only players and things by
+ * Link.  Unlinking does not depend on the type, so an object which is
+ * destroyed still leaves the list it was in.
+ */
+
+static bool db_index_live = false;
+
+static dbref db_index_key(int iIndex, dbref thing)
+{
+    switch (iIndex)
     {
-        // Creating a brand new struct database. Fill in the 'reserved' area
-        // in case it is referenced.
-        //
-        db = newdb;
-        initialize_objects(0, SIZE_HACK);
-    }
-    db = newdb + SIZE_HACK;
-    newdb = nullptr;
+    case DBI_OWNER:
+        return Owner(thing);
 
-    initialize_objects(mudstate.db_top, newtop);
-    mudstate.db_top = newtop;
-    mudstate.db_size = newsize;
+    case DBI_PARENT:
+        return Parent(thing);
 
-    // Grow the db mark buffer.
-    //
-    int marksize = (newsize + 7) >> 3;
-    MARKBUF *newmarkbuf = (MARKBUF *)MEMALLOC(marksize);
-    ISOUTOFMEMORY(newmarkbuf);
-    memset(newmarkbuf, 0, marksize);
-    if (mudstate.markbits)
+    case DBI_ZONE:
+        return Zone(thing);
+
+    case DBI_DEST:
+        return Location(thing);
+
+    default:
+        return Link(thing);
+    }
+}
+
+static bool db_index_applies(int iIndex, dbref thing)
+{
+    switch (iIndex)
     {
-        marksize = (newtop + 7) >> 3;
-        memcpy(newmarkbuf, mudstate.markbits, marksize);
-        MEMFREE(mudstate.markbits);
+    case DBI_DEST:
+        return isExit(thing) || isRoom(thing);
+
+    case DBI_HOME:
+        return isPlayer(thing) || isThing(thing);
+
+    default:
+        return true;
     }
-    mudstate.markbits = newmarkbuf;
 }
 
-void db_free(void)
+static void db_index_unlink(int iIndex, dbref thing)
 {
-#ifdef SELFCHECK
-    delete_all_player_names();
-    for (dbref thing = 0; thing < mudstate.db_top; thing++)
+    dbref key = db_index_key(iIndex, thing);
+    if (!Good_dbref(key))
     {
-        free_Names(&db[thing]);
+        return;
     }
-#endif
 
-    if (db != nullptr)
+    dbref next = db[thing].index_next[iIndex];
+    dbref prev = db[thing].index_prev[iIndex];
+    if (NOTHING == prev)
+    {
+        if (db[key].index_head[iIndex] == thing)
+        {
+            db[key].index_head[iIndex] = next;
+        }
+    }
+    else
     {
-        db -= SIZE_HACK;
-        char *cp = (char *)db;
-        MEMFREE(cp);
-        cp = nullptr;
-        db = nullptr;
+        db[prev].index_next[iIndex] = next;
     }
-    mudstate.db_top = 0;
-    mudstate.db_size = 0;
-    mudstate.freelist = NOTHING;
-}
+
+    if (NOTHING != next)
+    {
+        db[next].index_prev[iIndex] = prev;
+    }
+    db[thing].index_next[iIndex] = NOTHING;
+    db[thing].index_prev[iIndex] = NOTHING;
+}
+
+static void db_index_link(int iIndex, dbref thing)
+{
+    dbref key = db_index_key(iIndex, thing);
+    if (  !Good_dbref(key)
+       || !db_index_applies(iIndex, thing))
+    {
+        return;
+    }
+
+    dbref head = db[key].index_head[iIndex];
+    db[thing].index_next[iIndex] = head;
+    db[thing].index_prev[iIndex] = NOTHING;
+    if (NOTHING != head)
+    {
+        db[head].index_prev[iIndex] = thing;
+    }
+    db[key].index_head[iIndex] = thing;
+}
+
+void db_set_location(dbref thing, dbref loc)
+{
+    if (db_index_live)
+    {
+        db_index_unlink(DBI_DEST, thing);
+        db[thing].location = loc;
+        db_index_link(DBI_DEST, thing);
+    }
+    else
+    {
+        db[thing].location = loc;
+    }
+}
+
+void db_set_link(dbref thing, dbref link)
+{
+    if (db_index_live)
+    {
+        db_index_unlink(DBI_HOME, thing);
+        db[thing].link = link;
+        db_index_link(DBI_HOME, thing);
+    }
+    else
+    {
+        db[thing].link = link;
+    }
+}
+
+void db_set_owner(dbref thing, dbref owner)
+{
+    if (db_index_live)
+    {
+        db_index_unlink(DBI_OWNER, thing);
+        db[thing].owner = owner;
+        db_index_link(DBI_OWNER, thing);
+    }
+    else
+    {
+        db[thing].owner = owner;
+    }
+}
+
+void db_set_parent(dbref thing, dbref parent)
+{
+    if (db_index_live)
+    {
+        db_index_unlink(DBI_PARENT, thing);
+        db[thing].parent = parent;
+        db_index_link(DBI_PARENT, thing);
+    }
+    else
+    {
+        db[thing].parent = parent;
+    }
+}
+
+void db_set_zone(dbref thing, dbref zone)
+{
+    if (db_index_live)
+    {
+        db_index_unlink(DBI_ZONE, thing);
+        db[thing].zone = zone;
+        db_index_link(DBI_ZONE, thing);
+    }
+    else
+    {
+        db[thing].zone = zone;
+    }
+}
+
+void db_index_rebuild(void)
+{
+    dbref thing;
+    int i;
+    for (thing = 0; thing < mudstate.db_top; thing++)
+    {
+        for (i = 0; i < DBI_COUNT; i++)
+        {
+            db[thing].index_head[i] = NOTHING;
+            db[thing].index_next[i] = NOTHING;
+            db[thing].index_prev[i] = NOTHING;
+        }
+    }
+
+    // Linking from the top down leaves every list in dbref order.
+    //
+    for (thing = mudstate.db_top - 1; 0 <= thing; thing--)
+    {
+        for (i = 0; i < DBI_COUNT; i++)
+        {
+            db_index_link(i, thing);
+        }
+    }
+    db_index_live = true;
+}
+
+static const UTF8 *db_index_names[DBI_COUNT] =
+{
+    T("Owner"),
+    T("Parent"),
+    T("Zone"),
+    T("Destination"),
+    T("Home")
+};
+
+static void db_index_damaged(dbref key, const UTF8 *pIndex)
+{
+    STARTLOG(LOG_PROBLEMS, "OBJ", "DAMAG");
+    log_type_and_name(key);
+    log_text(T(": "));
+    log_text(pIndex);
+    log_text(T(" index is damaged.  Rebuilt."));
+    ENDLOG;
+}
+
+// db_index_check: Compare the indexes against the fields they are built from.
+// Each damaged list is logged, and the number of them is returned.  The
+// contents and exits back links are checked along with them.
+//
+int db_index_check(void)
+{
+    if (!db_index_live)
+    {
+        return 0;
+    }
+
+    int nDamaged = 0;
+    dbref key, thing, prev;
+    for (int i = 0; i < DBI_COUNT; i++)
+    {
+        int nExpected = 0;
+        for (thing = 0; thing < mudstate.db_top; thing++)
+        {
+            if (  Good_dbref(db_index_key(i, thing))
+               && db_index_applies(i, thing))
+            {
+                nExpected++;
+            }
+        }
+
+        int nFound = 0;
+        for (key = 0; key < mudstate.db_top; key++)
+        {
+            bool bDamaged = false;
+            prev = NOTHING;
+            for (thing = db[key].index_head[i]; NOTHING != thing; thing = db[thing].index_next[i])
+            {
+                if (  !Good_dbref(thing)
+                   || db[thing].index_prev[i] != prev
+                   || db_index_key(i, thing) != key
+                   || !db_index_applies(i, thing)
+                   || mudstate.db_top < ++nFound)
+                {
+                    bDamaged = true;
+                    break;
+                }
+                prev = thing;
+            }
+
+            if (bDamaged)
+            {
+                db_index_damaged(key, db_index_names[i]);
+                nDamaged++;
+            }
+        }
+
+        if (nFound != nExpected)
+        {
+            STARTLOG(LOG_PROBLEMS, "OBJ", "DAMAG");
+            log_text(db_index_names[i]);
+            log_text(tprintf(T(" index holds %d objects instead of %d.  Rebuilt."), nFound, nExpected));
+            ENDLOG;
+            nDamaged++;
+        }
+    }
+
+    for (key = 0; key < mudstate.db_top; key++)
+    {
+        if (  isExit(key)
+           || isGarbage(key))
+        {
+            continue;
+        }
+
+        dbref heads[2] = { Contents(key), Exits(key) };
+        for (int i = 0; i < 2; i++)
+        {
+            int count = 0;
+            prev = NOTHING;
+            for (thing = heads[i]; Good_dbref(thing) && count++ < mudstate.db_top; thing = Next(thing))
+            {
+                if (Prev(thing) != prev)
+                {
+                    db_index_damaged(key, (0 == i) ? T("Contents") : T("Exits"));
+                    nDamaged++;
+                    break;
+                }
+                prev = thing;
+                if (Next(thing) == thing)
+                {
+                    break;
+                }
+            }
+        }
+    }
+    return nDamaged;
+}
+
+// db_index_gather: Collect, in dbref order, the objects owned by, parented
+// to, or zoned to key.  The caller frees the list with MEMFREE.
+//
+int db_index_gather(int iIndex, dbref key, dbref **paList)
+{
+    *paList = nullptr;
+    if (!Good_dbref(key))
+    {
+        return 0;
+    }
+    else if (!db_index_live)
+    {
+        db_index_rebuild();
+    }
+
+    int nList = 0;
+    dbref thing;
+    for (thing = db[key].index_head[iIndex]; NOTHING != thing; thing = db[thing].index_next[iIndex])
+    {
+        nList++;
+    }
+
+    if (0 < nList)
+    {
+        dbref *aList = (dbref *)MEMALLOC(nList * sizeof(dbref));
+        ISOUTOFMEMORY(aList);
+
+        int i = 0;
+        for (thing = db[key].index_head[iIndex]; NOTHING != thing; thing = db[thing].index_next[iIndex])
+        {
+            aList[i++] = thing;
+        }
+        qsort(aList, nList, sizeof(dbref), db_index_compare);
+        *paList = aList;
+    }
+    return nList;
+}
+
+/* ---------------------------------------------------------------------------
+ * name_index_*: Objects by the prefixes of the words in their names.
+ *
+ * Every place string_match() would try (the start of the name, and the
+ * start of each later word) files the object under its first one, two,
+ * and three characters, folded the way string_prefix() folds them.  A
+ * pattern with a literal prefix therefore needs only one bucket, and the
+ * bucket holds every object that can match it.
+ *
+ * The index is built the first time it is used, so games that never
+ * search do not pay for it.  After that, s_Name() keeps it current.
+ */
+
+#define NAME_INDEX_KEY  3
+
+typedef struct name_bucket
+{
+    int    nUsed;
+    int    nAlloc;
+    dbref *aObjects;
+} NAME_BUCKET;
+
+static bool name_index_live = false;
+
+static UTF8 *name_index_fold(const UTF8 *pPureName, size_t nPureName)
+{
+    if (0 == nPureName)
+    {
+        return nullptr;
+    }
+
+    UTF8 *pFolded = (UTF8 *)MEMALLOC(nPureName + 1);
+    ISOUTOFMEMORY(pFolded);
+    for (size_t i = 0; i < nPureName; i++)
+    {
+        pFolded[i] = mux_tolower_ascii(pPureName[i]);
+    }
+    pFolded[nPureName] = '\0';
+    return pFolded;
+}
+
+// Advance past the current word to the start of the next, as string_match()
+// does.
+//
+static size_t name_index_next_word(const UTF8 *pFolded, size_t i)
+{
+    while (mux_isalnum(pFolded[i]))
+    {
+        i++;
+    }
+    while (  '\0' != pFolded[i]
+          && !mux_isalnum(pFolded[i]))
+    {
+        i++;
+    }
+    return i;
+}
+
+static void name_index_add(dbref thing, const UTF8 *pKey, size_t nKey)
+{
+    NAME_BUCKET *pnb = (NAME_BUCKET *)hashfindLEN(pKey, nKey, &mudstate.name_index_htab);
+    if (nullptr == pnb)
+    {
+        pnb = new NAME_BUCKET;
+        pnb->nUsed = 0;
+        pnb->nAlloc = 0;
+        pnb->aObjects = nullptr;
+        hashaddLEN(pKey, nKey, pnb, &mudstate.name_index_htab);
+    }
+
+    if (pnb->nUsed == pnb->nAlloc)
+    {
+        int nAlloc = (0 == pnb->nAlloc) ? 4 : 2 * pnb->nAlloc;
+        dbref *aObjects = (dbref *)MEMALLOC(nAlloc * sizeof(dbref));
+        ISOUTOFMEMORY(aObjects);
+        if (nullptr != pnb->aObjects)
+        {
+            memcpy(aObjects, pnb->aObjects, pnb->nUsed * sizeof(dbref));
+            MEMFREE(pnb->aObjects);
+        }
+        pnb->aObjects = aObjects;
+        pnb->nAlloc = nAlloc;
+    }
+    pnb->aObjects[pnb->nUsed++] = thing;
+}
+
+static void name_index_remove(dbref thing, const UTF8 *pKey, size_t nKey)
+{
+    NAME_BUCKET *pnb = (NAME_BUCKET *)hashfindLEN(pKey, nKey, &mudstate.name_index_htab);
+    if (nullptr == pnb)
+    {
+        return;
+    }
+
+    for (int i = 0; i < pnb->nUsed; i++)
+    {
+        if (pnb->aObjects[i] == thing)
+        {
+            pnb->aObjects[i] = pnb->aObjects[--pnb->nUsed];
+            break;
+        }
+    }
+
+    if (0 == pnb->nUsed)
+    {
+        hashdeleteLEN(pKey, nKey, &mudstate.name_index_htab);
+        if (nullptr != pnb->aObjects)
+        {
+            MEMFREE(pnb->aObjects);
+        }
+        delete pnb;
+    }
+}
+
+// File (or unfile) thing under each distinct key of its folded name.
+//
+static void name_index_apply(dbref thing, const UTF8 *pFolded, bool bAdd)
+{
+    size_t nFolded = strlen((const char *)pFolded);
+    for (size_t i = 0; i < nFolded; i = name_index_next_word(pFolded, i))
+    {
+        for (size_t nKey = 1; nKey <= NAME_INDEX_KEY && i + nKey <= nFolded; nKey++)
+        {
+            // An earlier word with the same prefix has already been filed.
+            //
+            bool bSeen = false;
+            for (size_t j = 0; j < i; j = name_index_next_word(pFolded, j))
+            {
+                if (  j + nKey <= nFolded
+                   && memcmp(pFolded + j, pFolded + i, nKey) == 0)
+                {
+                    bSeen = true;
+                    break;
+                }
+            }
+
+            if (!bSeen)
+            {
+                if (bAdd)
+                {
+                    name_index_add(thing, pFolded + i, nKey);
+                }
+                else
+                {
+                    name_index_remove(thing, pFolded + i, nKey);
+                }
+            }
+        }
+    }
+}
+
+static void name_index_build(void)
+{
+    dbref thing;
+    DO_WHOLE_DB(thing)
+    {
+        if (isGarbage(thing))
+        {
+            continue;
+        }
+
+        const UTF8 *pPureName = PureName(thing);
+        UTF8 *pFolded = name_index_fold(pPureName, strlen((const char *)pPureName));
+        if (nullptr != pFolded)
+        {
+            name_index_apply(thing, pFolded, true);
+            db[thing].name_folded = pFolded;
+        }
+    }
+    name_index_live = true;
+}
+
+void name_index_rename(dbref thing, const UTF8 *pName)
+{
+    if (!name_index_live)
+    {
+        return;
+    }
+
+    if (nullptr != db[thing].name_folded)
+    {
+        name_index_apply(thing, db[thing].name_folded, false);
+        MEMFREE(db[thing].name_folded);
+        db[thing].name_folded = nullptr;
+    }
+
+    if (nullptr != pName)
+    {
+        size_t nPureName;
+        const UTF8 *pPureName = strip_color(pName, &nPureName);
+        UTF8 *pFolded = name_index_fold(pPureName, nPureName);
+        if (nullptr != pFolded)
+        {
+            name_index_apply(thing, pFolded, true);
+            db[thing].name_folded = pFolded;
+        }
+    }
+}
+
+void name_index_drop(void)
+{
+    if (!name_index_live)
+    {
+        return;
+    }
+
+    int nKey;
+    UTF8 *pKey;
+    UTF8 aKey[NAME_INDEX_KEY];
+    NAME_BUCKET *pnb;
+    while (nullptr != (pnb = (NAME_BUCKET *)hash_firstkey(&mudstate.name_index_htab, &nKey, &pKey)))
+    {
+        // pKey points into the table's own scratch record, which deleting
+        // reuses.
+        //
+        memcpy(aKey, pKey, nKey);
+        hashdeleteLEN(aKey, nKey, &mudstate.name_index_htab);
+        if (nullptr != pnb->aObjects)
+        {
+            MEMFREE(pnb->aObjects);
+        }
+        delete pnb;
+    }
+
+    dbref thing;
+    DO_WHOLE_DB(thing)
+    {
+        if (nullptr != db[thing].name_folded)
+        {
+            MEMFREE(db[thing].name_folded);
+            db[thing].name_folded = nullptr;
+        }
+    }
+    name_index_live = false;
+}
+
+// name_index_gather: Collect, in dbref order, the objects which may match
+// pPattern under string_match() or string_prefix().  The caller still
+// applies the match, and frees the list with MEMFREE.  Returns -1 when
+// pPattern has no literal prefix to go on.
+//
+int name_index_gather(const UTF8 *pPattern, dbref **paList)
+{
+    *paList = nullptr;
+    if (  nullptr == pPattern
+       || '\0' == pPattern[0])
+    {
+        return -1;
+    }
+    else if (!name_index_live)
+    {
+        name_index_build();
+    }
+
+    UTF8 aKey[NAME_INDEX_KEY];
+    size_t nKey = 0;
+    while (  nKey < NAME_INDEX_KEY
+          && '\0' != pPattern[nKey])
+    {
+        aKey[nKey] = mux_tolower_ascii(pPattern[nKey]);
+        nKey++;
+    }
+
+    NAME_BUCKET *pnb = (NAME_BUCKET *)hashfindLEN(aKey, nKey, &mudstate.name_index_htab);
+    if (  nullptr == pnb
+       || 0 == pnb->nUsed)
+    {
+        return 0;
+    }
+
+    dbref *aList = (dbref *)MEMALLOC(pnb->nUsed * sizeof(dbref));
+    ISOUTOFMEMORY(aList);
+    memcpy(aList, pnb->aObjects, pnb->nUsed * sizeof(dbref));
+    qsort(aList, pnb->nUsed, sizeof(dbref), db_index_compare);
+    *paList = aList;
+    return pnb->nUsed;
+}
+
+void db_grow(dbref newtop)
+{
+    mudstate.bfCommands.Resize(newtop);
+    mudstate.bfNoCommands.Resize(newtop);
+    mudstate.bfListens.Resize(newtop);
+    mudstate.bfNoListens.Resize(newtop);
+    mudstate.bfCmdIndex.Resize(newtop);
+    mudstate.bfAttrResolve.Resize(newtop);
+    mudstate.bfLockCache.Resize(newtop);
+    mudstate.bfHearList.Resize(newtop);
+    mudstate.bfExitIndex.Resize(newtop);
+    mudstate.bfLatency.Resize(newtop);
+
+    int delta;
+    if (mudstate.bStandAlone)
+    {
+        delta = 1000;
+    }
+    else
+    {
+        delta = mudconf.init_size;
+    }
+
+    // Determine what to do based on requested size, current top and size.
+    // Make sure we grow in reasonable-sized chunks to prevent frequent
+    // reallocations of the directory and mark buffer.
+    //
+    // If requested size is smaller than the current db size, ignore it.
+    //
+    if (newtop <= mudstate.db_top)
+    {
+        return;
+    }
+
+    // If requested size is greater than the current db size but smaller
+    // than the amount of space we have allocated, raise the db size and
+    // initialize the new area.
+    //
+    if (newtop <= mudstate.db_size)
+    {
+        initialize_objects(mudstate.db_top, newtop);
+        mudstate.db_top = newtop;
+        return;
+    }
+
+    // Grow by a minimum of delta objects
+    //
+    int newsize = newtop;
+    int nMinimumGrowth = mudstate.db_size + delta;
+    if (newtop <= nMinimumGrowth)
+    {
+        newsize = nMinimumGrowth;
+    }
+
+    // Enforce minimum database size
+    //
+    if (newsize < mudstate.min_size)
+    {
+        newsize = mudstate.min_size;
+    }
+
+    // Add the segments needed to hold newsize objects.  Only the directory
+    // is copied.
+    //
+    int nSegments = (newsize + SIZE_HACK + OBJ_SEGMENT_MASK) >> OBJ_SEGMENT_SHIFT;
+    if (db.m_nSegments < nSegments)
+    {
+        OBJ **apSegments = (OBJ **)MEMALLOC(nSegments * sizeof(OBJ *));
+        ISOUTOFMEMORY(apSegments);
+
+        int i;
+        for (i = 0; i < db.m_nSegments; i++)
+        {
+            apSegments[i] = db.m_apSegments[i];
+        }
+        for ( ; i < nSegments; i++)
+        {
+            apSegments[i] = (OBJ *)MEMALLOC(OBJ_SEGMENT_SIZE * sizeof(OBJ));
+            ISOUTOFMEMORY(apSegments[i]);
+        }
+
+        bool bFirst = (nullptr == db.m_apSegments);
+        if (!bFirst)
+        {
+            MEMFREE(db.m_apSegments);
+        }
+        db.m_apSegments = apSegments;
+        db.m_nSegments = nSegments;
+
+        if (bFirst)
+        {
+            // Fill in the 'reserved' area in case it is referenced.
+            //
+            initialize_objects(-SIZE_HACK, 0);
+        }
+    }
+
+    initialize_objects(mudstate.db_top, newtop);
+    mudstate.db_top = newtop;
+    mudstate.db_size = newsize;
+
+    // Grow the db mark buffer.
+    //
+    int marksize = (newsize + 7) >> 3;
+    MARKBUF *newmarkbuf = (MARKBUF *)MEMALLOC(marksize);
+    ISOUTOFMEMORY(newmarkbuf);
+    memset(newmarkbuf, 0, marksize);
+    if (mudstate.markbits)
+    {
+        marksize = (newtop + 7) >> 3;
+        memcpy(newmarkbuf, mudstate.markbits, marksize);
+        MEMFREE(mudstate.markbits);
+    }
+    mudstate.markbits = newmarkbuf;
+}
+
+void db_free(void)
+{
+    name_index_drop();
+#ifdef SELFCHECK
+    delete_all_player_names();
+    for (dbref thing = 0; thing < mudstate.db_top; thing++)
+    {
+        free_Names(&db[thing]);
+    }
+#endif
+
+    if (nullptr != db.m_apSegments)
+    {
+        for (int i = 0; i < db.m_nSegments; i++)
+        {
+            MEMFREE(db.m_apSegments[i]);
+        }
+        MEMFREE(db.m_apSegments);
+        db.m_apSegments = nullptr;
+        db.m_nSegments = 0;
+    }
+    mudstate.db_top = 0;
+    mudstate.db_size = 0;
+    mudstate.freelist = NOTHING;
+    db_index_live = false;
+}
 
 void db_make_minimal(void)
 {
@@ -3405,11 +4426,11 @@ static const unsigned char encode_table[256] =
     0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0  // F
 };
 
-void putstring(FILE *f, const UTF8 *pRaw)
+// Quote pRaw into pBuffer as putstring() writes it, and return the end of the
+// result.  pBuffer must have room for 2*strlen(pRaw)+4 characters.
+//
+UTF8 *putstring_encode(UTF8 *pBuffer, const UTF8 *pRaw)
 {
-    static UTF8 aBuffer[2*LBUF_SIZE+4];
-    UTF8 *pBuffer = aBuffer;
-
     // Always leave room for four characters. One at the beginning and
     // three on the end. '\\"\n' or '\""\n'
     //
@@ -3449,7 +4470,13 @@ void putstring(FILE *f, const UTF8 *pRaw)
 
     *pBuffer++ = '"';
     *pBuffer++ = '\n';
+    return pBuffer;
+}
 
+void putstring(FILE *f, const UTF8 *pRaw)
+{
+    static UTF8 aBuffer[2*LBUF_SIZE+4];
+    UTF8 *pBuffer = putstring_encode(aBuffer, pRaw);
     fwrite(aBuffer, sizeof(UTF8), pBuffer - aBuffer, f);
 }
 
@@ -3943,6 +4970,9 @@ void load_restart_db(void)
         d->raw_input_at = nullptr;
         d->nOption = 0;
         d->quota = mudconf.cmd_quota_max;
+        d->quota_time.GetUTC();
+        d->idle_task = nullptr;
+        d->keepalive_task = nullptr;
         d->program_data = nullptr;
         d->hashnext = nullptr;
 
@@ -3975,6 +5005,7 @@ void load_restart_db(void)
         if (isPlayer(d->player))
         {
             s_Connected(d->player);
+            hearlist_touch(d->player);
         }
     }
 
@@ -3986,6 +5017,12 @@ void load_restart_db(void)
         }
     }
 
+    DESC_ITER_ALL(d)
+    {
+        desc_recheck_idle(d);
+        desc_start_keepalive(d);
+    }
+
     if (fclose(f) == 0)
     {
         DebugTotalFiles--;
@@ -127,6 +127,18 @@ struct boolexp
 #define NOPERM      (-4)    /* Error status, no permission */
 extern const UTF8 *aszSpecialDBRefNames[1-NOPERM];
 
+// Objects are indexed by owner, parent, zone, destination, and home so that
+// the objects referring to one of them can be found without walking the
+// whole database.  Each index is an unordered doubly linked list hanging off
+// the object being referred to.  See db_index_gather().
+//
+const int DBI_OWNER  = 0;
+const int DBI_PARENT = 1;
+const int DBI_ZONE   = 2;
+const int DBI_DEST   = 3;   // EXIT: destination, ROOM: dropto
+const int DBI_HOME   = 4;   // PLAYER, THING: home
+const int DBI_COUNT  = 5;
+
 typedef struct object OBJ;
 struct object
 {
@@ -140,6 +152,8 @@ struct object
     dbref   next;       /* PLAYER, THING: next in contentslist */
                         /* EXIT: next in exitslist */
                         /* ROOM: unused */
+    dbref   prev;       // PLAYER, THING, EXIT: previous in the same list, or
+                        // NOTHING at the head.  Not saved; see db_link_lists().
     dbref   link;       /* PLAYER, THING: home location */
                         /* ROOM, EXIT: unused */
     dbref   parent;     /* ALL: defaults for attrs, exits, $cmds, */
@@ -148,6 +162,11 @@ struct object
 
     dbref   zone;       /* Whatever the object is zoned to.*/
 
+    dbref   index_head[DBI_COUNT];  // ALL: first object that refers to this
+                                    // one in each index.
+    dbref   index_next[DBI_COUNT];  // ALL: neighbors in those lists.  Not
+    dbref   index_prev[DBI_COUNT];  // saved; see db_index_rebuild().
+
     FLAGSET fs;         // ALL: Flags set on the object.
 
     POWER   powers;     /* ALL: Powers on object */
@@ -158,6 +177,14 @@ struct object
 #endif // DEPRECATED
 
     CLinearTimeDelta cpu_time_used; /* ALL: CPU time eaten */
+    CLinearTimeDelta queue_cpu_time; // PLAYER: CPU eaten by queue entries of owned objects
+    int     cpu_max;    // ALL: Cached CpuMax in milliseconds (0 is none, -1 is unknown).
+
+#ifdef REALITY_LVLS
+    RLEVEL  rxlevel;    // ALL: Receive levels from Rlevel (if iRLevel is 1).
+    RLEVEL  txlevel;    // ALL: Transmit levels from Rlevel (if iRLevel is 1).
+    int     iRLevel;    // ALL: Rlevel decoded (1), type defaults apply (0), or unknown (-1).
+#endif // REALITY_LVLS
 
     // ALL: When to refurbish throttled counters.
     //
@@ -168,6 +195,15 @@ struct object
 
     UTF8    *purename;
     UTF8    *moniker;
+    UTF8    *name_folded;   // ALL: case-folded PureName as filed in the name
+                            // index, or nullptr.
+
+    int     dirty;      /* ALL: DB_DIRTY_* changes not yet collected */
+
+    struct bque *queue_executor;    // ALL: queue entries run by this object
+    struct bque *queue_owner;       // PLAYER: queue entries of owned objects
+    struct semaphore_waiters *queue_semaphore; // ALL: wait lists of this semaphore
+    struct cmd_cache *cmd_cache;    // ALL: compiled $-command and ^-listen patterns
 
 #ifdef MEMORY_BASED
     ATRLIST *pALHead;   /* The head of the attribute list.       */
@@ -180,7 +216,30 @@ struct object
 
 const int INITIAL_ATRLIST_SIZE = 10;
 
-extern OBJ *db;
+// The object table is kept in fixed-size segments found through a small
+// directory.  Growing the database adds segments and never moves an object
+// that is already there, so a pointer to an OBJ stays good.  The first
+// SIZE_HACK entries of the first segment sit below #0.
+//
+#define SIZE_HACK           1   // So mistaken refs to #-1 won't die.
+#define OBJ_SEGMENT_SHIFT   12
+#define OBJ_SEGMENT_SIZE    (1 << OBJ_SEGMENT_SHIFT)
+#define OBJ_SEGMENT_MASK    (OBJ_SEGMENT_SIZE - 1)
+
+class CObjectTable
+{
+public:
+    OBJ **m_apSegments;
+    int   m_nSegments;
+
+    OBJ &operator[](dbref i) const
+    {
+        unsigned int j = static_cast<unsigned int>(i + SIZE_HACK);
+        return m_apSegments[j >> OBJ_SEGMENT_SHIFT][j & OBJ_SEGMENT_MASK];
+    }
+};
+
+extern CObjectTable db;
 
 #define Location(t)     db[t].location
 
@@ -189,6 +248,7 @@ extern OBJ *db;
 #define Contents(t)     db[t].contents
 #define Exits(t)        db[t].exits
 #define Next(t)         db[t].next
+#define Prev(t)         db[t].prev
 #define Link(t)         db[t].link
 #define Owner(t)        db[t].owner
 #define Parent(t)       db[t].parent
@@ -203,19 +263,49 @@ extern OBJ *db;
 #define ThMail(t)       db[t].throttled_mail
 #define ThRefs(t)       db[t].throttled_references
 
-#define s_Location(t,n)     db[t].location = (n)
-
-#define s_Zone(t,n)         db[t].zone = (n)
-
-#define s_Contents(t,n)     db[t].contents = (n)
-#define s_Exits(t,n)        db[t].exits = (n)
-#define s_Next(t,n)         db[t].next = (n)
-#define s_Link(t,n)         db[t].link = (n)
-#define s_Owner(t,n)        db[t].owner = (n)
-#define s_Parent(t,n)       db[t].parent = (n)
-#define s_Flags(t,f,n)      db[t].fs.word[f] = (n)
-#define s_Powers(t,n)       db[t].powers = (n)
-#define s_Powers2(t,n)      db[t].powers2 = (n)
+// Changes to the object header are noticed here for the journal and for
+// incremental checkpoints.  db_dirty_mask holds the DB_DIRTY_* bits currently
+// being collected, so when nothing is being collected, db_dirty() costs a
+// load and a test.
+//
+#define DB_DIRTY_JOURNAL    0x00000001
+#define DB_DIRTY_CHECKPOINT 0x00000002
+extern int db_dirty_mask;
+void db_set_dirty(dbref t);
+int  db_checkpoint_objects(dbref **paList);
+void db_clear_checkpoint(void);
+extern bool db_vattrs_dirty;
+#define db_dirty(t)         ((db_dirty_mask & ~db[t].dirty) ? db_set_dirty(t) : (void)0)
+
+// Queue entries are indexed by owner, so they follow their executor when it
+// changes hands.
+//
+void que_rekey(dbref executor);
+void que_reweight(dbref owner);
+
+// These keep the object indexes in step.
+//
+void db_set_location(dbref thing, dbref loc);
+void db_set_link(dbref thing, dbref link);
+void db_set_owner(dbref thing, dbref owner);
+void db_set_parent(dbref thing, dbref parent);
+void db_set_zone(dbref thing, dbref zone);
+
+#define s_Location(t,n)     (db_set_location((t), (n)), db_dirty(t))
+
+#define s_Zone(t,n)         (db_set_zone((t), (n)), db_dirty(t))
+
+#define s_Contents(t,n)     (db[t].contents = (n), db_dirty(t))
+#define s_Exits(t,n)        (db[t].exits = (n), db_dirty(t))
+#define s_Next(t,n)         (db[t].next = (n), db_dirty(t))
+#define s_Prev(t,n)         (db[t].prev = (n))
+#define s_Link(t,n)         (db_set_link((t), (n)), db_dirty(t))
+#define s_Owner(t,n)        (db_set_owner((t), (n)), db_dirty(t), \
+                             db[t].queue_executor ? que_rekey(t) : (void)0)
+#define s_Parent(t,n)       (db_set_parent((t), (n)), db_dirty(t), atr_resolve_flush())
+#define s_Flags(t,f,n)      (db[t].fs.word[f] = (n), db_dirty(t))
+#define s_Powers(t,n)       (db[t].powers = (n), db_dirty(t))
+#define s_Powers2(t,n)      (db[t].powers2 = (n), db_dirty(t))
 #define s_Home(t,n)         s_Link(t,n)
 #define s_Dropto(t,n)       s_Location(t,n)
 #define s_ThAttrib(t,n)     db[t].throttled_attributes = (n);
@@ -246,13 +336,21 @@ bool ThrottlePlayerCreate(void);
 int  mkattr(dbref executor, const UTF8 *);
 void al_store(void);
 void db_grow(dbref);
+void db_link_lists(void);
+void db_index_rebuild(void);
+int  db_index_gather(int iIndex, dbref key, dbref **paList);
+int  DCL_CDECL db_index_compare(const void *p1, const void *p2);
+int  db_index_check(void);
 void db_free(void);
 void db_make_minimal(void);
 dbref    db_read(FILE *, int *, int *, int *);
+dbref    db_read_delta(FILE *, int, int);
 dbref    db_write(FILE *, int, int);
+dbref    db_write_checkpoint(FILE *, int, int, int, int);
 void destroy_thing(dbref);
 void destroy_exit(dbref);
 void putstring(FILE *f, const UTF8 *s);
+UTF8 *putstring_encode(UTF8 *pBuffer, const UTF8 *s);
 void *getstring_noalloc(FILE *f, bool new_strings, size_t *pnBuffer);
 void init_attrtab(void);
 int GrowFiftyPercent(int x, int low, int high);
@@ -6,6 +6,9 @@
 
 #include "copyright.h"
 #include "autoconf.h"
+#include <condition_variable>
+#include <mutex>
+#include <thread>
 #include "config.h"
 #include "externs.h"
 
@@ -347,7 +350,11 @@ static bool get_list(FILE *f, dbref i)
     }
 }
 
-dbref db_read(FILE *f, int *db_format, int *db_version, int *db_flags)
+// A delta (see db_write_checkpoint) uses the same format as a full flatfile
+// but carries only the objects changed since the previous checkpoint.  It is
+// read on top of what is already loaded.
+//
+static dbref db_read_file(FILE *f, int *db_format, int *db_version, int *db_flags, bool bDelta)
 {
     dbref i, anum;
     int ch;
@@ -378,6 +385,12 @@ dbref db_read(FILE *f, int *db_format, int *db_version, int *db_flags)
     bool bValid;
     UTF8 *pName;
 
+    // A delta which carries the whole list of user-named attributes notes
+    // the ones it names here.  Any others have been deleted.
+    //
+    char *aVattrNamed = nullptr;
+    int nVattrNamed = 0;
+
     int iDotCounter = 0;
     if (mudstate.bStandAlone)
     {
@@ -385,7 +398,10 @@ dbref db_read(FILE *f, int *db_format, int *db_version, int *db_flags)
         Log.Flush();
     }
 
-    db_free();
+    if (!bDelta)
+    {
+        db_free();
+    }
     for (i = 0;; i++)
     {
         if (mudstate.bStandAlone)
@@ -414,6 +430,46 @@ dbref db_read(FILE *f, int *db_format, int *db_version, int *db_flags)
                     mudstate.record_players = 0;
                 }
             }
+            else if (ch == 'B')
+            {
+                // Checkpoint this file is or builds on.
+                //
+                int iBase = getref(f);
+                if (!bDelta)
+                {
+                    mudstate.checkpoint_base = iBase;
+                    mudstate.checkpoint_delta = 0;
+                }
+            }
+            else if (ch == 'D')
+            {
+                // Sequence number of a delta.
+                //
+                int iDelta = getref(f);
+                if (bDelta)
+                {
+                    mudstate.checkpoint_delta = iDelta;
+                }
+            }
+            else if (ch == 'A')
+            {
+                // The user-named attributes which follow are complete.
+                //
+                int iAttrTop = getref(f);
+                if (  bDelta
+                   && nullptr == aVattrNamed
+                   && A_USER_START <= iAttrTop)
+                {
+                    nVattrNamed = iAttrTop + 1;
+                    aVattrNamed = (char *)MEMALLOC(nVattrNamed);
+                    ISOUTOFMEMORY(aVattrNamed);
+                    memset(aVattrNamed, 0, nVattrNamed);
+                }
+            }
+            else
+            {
+                tstr = (UTF8 *)getstring_noalloc(f, false, &nBuffer);
+            }
             break;
 
         case '+':
@@ -459,7 +515,19 @@ dbref db_read(FILE *f, int *db_format, int *db_version, int *db_flags)
                         g_max_nam_atr = anum;
                     }
 
-                    vattr_define_LEN(pName, nName, anum, aflags);
+                    if (bDelta)
+                    {
+                        vattr_redefine_LEN(pName, nName, anum, aflags);
+                        if (  0 <= anum
+                           && anum < nVattrNamed)
+                        {
+                            aVattrNamed[anum] = 1;
+                        }
+                    }
+                    else
+                    {
+                        vattr_define_LEN(pName, nName, anum, aflags);
+                    }
                 }
             }
             else if (ch == 'X')
@@ -559,6 +627,15 @@ dbref db_read(FILE *f, int *db_format, int *db_version, int *db_flags)
             i = getref(f);
             db_grow(i + 1);
 
+            // A delta carries every attribute the object still has, and the
+            // name and pennies may be kept as attributes, too.
+            //
+            if (  bDelta
+               && read_attribs)
+            {
+                atr_free(i);
+            }
+
             if (read_name)
             {
                 tstr = (UTF8 *)getstring_noalloc(f, true, &nBuffer);
@@ -647,6 +724,10 @@ dbref db_read(FILE *f, int *db_format, int *db_version, int *db_flags)
                 if (!get_list(f, i))
                 {
                     Log.tinyprintf(T(ENDLINE "Error reading attrs for object #%d" ENDLINE), i);
+                    if (nullptr != aVattrNamed)
+                    {
+                        MEMFREE(aVattrNamed);
+                    }
                     return -1;
                 }
             }
@@ -664,58 +745,87 @@ dbref db_read(FILE *f, int *db_format, int *db_version, int *db_flags)
             if (strncmp((char *)tstr, "**END OF DUMP***", 16))
             {
                 Log.tinyprintf(T(ENDLINE "Bad EOF marker at object #%d" ENDLINE), i);
+                if (nullptr != aVattrNamed)
+                {
+                    MEMFREE(aVattrNamed);
+                }
                 return -1;
             }
             else
             {
-                // Attribute number warnings.
+                // A delta's attribute numbers only make sense together with
+                // everything already loaded.
                 //
-                if (g_max_nam_atr < g_max_obj_atr)
+                if (!bDelta)
                 {
-                    Log.tinyprintf(T(ENDLINE "Warning: One or more attribute values are unnamed. Did you use ./Backup on a running game?"));
-                }
+                    // Attribute number warnings.
+                    //
+                    if (g_max_nam_atr < g_max_obj_atr)
+                    {
+                        Log.tinyprintf(T(ENDLINE "Warning: One or more attribute values are unnamed. Did you use ./Backup on a running game?"));
+                    }
 
-                if (!nextattr_gotten)
-                {
-                    Log.tinyprintf(T(ENDLINE "Warning: Missing +N<next free>. Adjusting."));
-                }
+                    if (!nextattr_gotten)
+                    {
+                        Log.tinyprintf(T(ENDLINE "Warning: Missing +N<next free>. Adjusting."));
+                    }
 
-                if (mudstate.attr_next <= g_max_nam_atr)
-                {
-                    if (nextattr_gotten)
+                    if (mudstate.attr_next <= g_max_nam_atr)
                     {
-                        Log.tinyprintf(T(ENDLINE "Warning: +N<next free attr> conflicts with existing attribute names. Adjusting."));
+                        if (nextattr_gotten)
+                        {
+                            Log.tinyprintf(T(ENDLINE "Warning: +N<next free attr> conflicts with existing attribute names. Adjusting."));
+                        }
+                        mudstate.attr_next = g_max_nam_atr + 1;
                     }
-                    mudstate.attr_next = g_max_nam_atr + 1;
-                }
 
-                if (mudstate.attr_next <= g_max_obj_atr)
-                {
-                    if (nextattr_gotten)
+                    if (mudstate.attr_next <= g_max_obj_atr)
                     {
-                        Log.tinyprintf(T(ENDLINE "Warning: +N<next free attr> conflicts object attribute numbers. Adjusting."));
+                        if (nextattr_gotten)
+                        {
+                            Log.tinyprintf(T(ENDLINE "Warning: +N<next free attr> conflicts object attribute numbers. Adjusting."));
+                        }
+                        mudstate.attr_next = g_max_nam_atr + 1;
                     }
-                    mudstate.attr_next = g_max_nam_atr + 1;
-                }
 
-                int max_atr = A_USER_START;
-                if (max_atr < g_max_nam_atr)
-                {
-                    max_atr = g_max_nam_atr;
-                }
+                    int max_atr = A_USER_START;
+                    if (max_atr < g_max_nam_atr)
+                    {
+                        max_atr = g_max_nam_atr;
+                    }
 
-                if (max_atr < g_max_obj_atr)
-                {
-                    max_atr = g_max_obj_atr;
-                }
+                    if (max_atr < g_max_obj_atr)
+                    {
+                        max_atr = g_max_obj_atr;
+                    }
 
-                if (max_atr + 1 < mudstate.attr_next)
+                    if (max_atr + 1 < mudstate.attr_next)
+                    {
+                        if (nextattr_gotten)
+                        {
+                            Log.tinyprintf(T(ENDLINE "Info: +N<next free attr> can be safely adjusted down."));
+                        }
+                        mudstate.attr_next = max_atr + 1;
+                    }
+                }
+                else if (nullptr != aVattrNamed)
                 {
-                    if (nextattr_gotten)
+                    // The delta did not name these, so they were deleted.
+                    //
+                    for (int iAttr = A_USER_START; iAttr <= anum_alc_top; iAttr++)
                     {
-                        Log.tinyprintf(T(ENDLINE "Info: +N<next free attr> can be safely adjusted down."));
+                        ATTR *vp = (ATTR *)anum_get(iAttr);
+                        if (  nullptr != vp
+                           && (  nVattrNamed <= iAttr
+                              || !aVattrNamed[iAttr]))
+                        {
+                            vattr_delete_LEN((UTF8 *)vp->name, strlen((char *)vp->name));
+                        }
                     }
-                    mudstate.attr_next = max_atr + 1;
+                    MEMFREE(aVattrNamed);
+                    aVattrNamed = nullptr;
+                    atr_resolve_flush();
+                    lockcache_flush();
                 }
 
                 if (convert_values)
@@ -756,15 +866,15 @@ dbref db_read(FILE *f, int *db_format, int *db_version, int *db_flags)
                     Log.WriteString(T(ENDLINE));
                     Log.Flush();
                 }
-                else
-                {
-                    load_player_names();
-                }
                 return mudstate.db_top;
             }
 
         case EOF:
             Log.tinyprintf(T(ENDLINE "Unexpected end of file near object #%d" ENDLINE), i);
+            if (nullptr != aVattrNamed)
+            {
+                MEMFREE(aVattrNamed);
+            }
             return -1;
 
         default:
@@ -776,46 +886,163 @@ dbref db_read(FILE *f, int *db_format, int *db_version, int *db_flags)
             {
                 Log.tinyprintf(T(ENDLINE "Illegal character 0x%02x near object #%d" ENDLINE), ch, i);
             }
+            if (nullptr != aVattrNamed)
+            {
+                MEMFREE(aVattrNamed);
+            }
             return -1;
         }
     }
 }
 
-static bool db_write_object(FILE *f, dbref i, int db_format, int flags)
+dbref db_read(FILE *f, int *db_format, int *db_version, int *db_flags)
 {
-    UNUSED_PARAMETER(db_format);
+    return db_read_file(f, db_format, db_version, db_flags, false);
+}
 
+// Apply delta iDelta of checkpoint iBase.  Nothing is applied unless the
+// file's header says it is exactly that delta.
+//
+dbref db_read_delta(FILE *f, int iBase, int iDelta)
+{
+    if (  getc(f) != '+'
+       || getc(f) != 'X')
+    {
+        return -1;
+    }
+    getref(f);
+
+    if (  getc(f) != '-'
+       || getc(f) != 'B'
+       || getref(f) != iBase
+       || getc(f) != '-'
+       || getc(f) != 'D'
+       || getref(f) != iDelta)
+    {
+        return -1;
+    }
+    rewind(f);
+
+    int db_format, db_version, db_flags;
+    return db_read_file(f, &db_format, &db_version, &db_flags, true);
+}
+
+// Objects are rendered into memory and then written, so that ranges of them
+// can be rendered on several threads at once.
+//
+typedef struct
+{
+    UTF8  *pData;
+    size_t nUsed;
+    size_t nAlloc;
+} DUMP_BUFFER;
+
+static void dump_reserve(DUMP_BUFFER *pdb, size_t nMore)
+{
+    size_t nNeeded = pdb->nUsed + nMore;
+    if (pdb->nAlloc < nNeeded)
+    {
+        size_t nAlloc = nNeeded + nNeeded/2;
+        if (nAlloc < 65536)
+        {
+            nAlloc = 65536;
+        }
+        UTF8 *pData = (UTF8 *)MEMREALLOC(pdb->pData, nAlloc);
+        ISOUTOFMEMORY(pData);
+        pdb->pData = pData;
+        pdb->nAlloc = nAlloc;
+    }
+}
+
+static void dump_ref(DUMP_BUFFER *pdb, int ref)
+{
+    dump_reserve(pdb, I32BUF_SIZE+1);
+    UTF8 *p = pdb->pData + pdb->nUsed;
+    size_t n = mux_ltoa(ref, p);
+    p[n++] = '\n';
+    pdb->nUsed += n;
+}
+
+static void dump_string(DUMP_BUFFER *pdb, const UTF8 *pRaw)
+{
+    size_t n = (nullptr == pRaw) ? 0 : strlen((const char *)pRaw);
+    dump_reserve(pdb, 2*n+4);
+    UTF8 *pEnd = putstring_encode(pdb->pData + pdb->nUsed, pRaw);
+    pdb->nUsed = pEnd - pdb->pData;
+}
+
+// The text of an attribute without its owner and flags.
+//
+static const UTF8 *db_write_text(dbref i, int atr)
+{
+    const UTF8 *p = atr_get_raw(i, atr);
+    if (nullptr == p)
+    {
+        return T("");
+    }
+    dbref aowner;
+    int aflags;
+    return atr_decode_flags_owner(p, &aowner, &aflags);
+}
+
+// Can objects be rendered off the main thread?  Memory-based attributes
+// can be read from anywhere as long as nothing changes them.  The disk-based
+// attribute cache cannot, so there only headers qualify.
+//
+static bool db_write_parallel(int flags)
+{
+#ifdef MEMORY_BASED
+    UNUSED_PARAMETER(flags);
+    return true;
+#else // MEMORY_BASED
+    return (  (flags & V_DATABASE)
+           && (flags & V_ATRNAME)
+           && (flags & V_ATRMONEY));
+#endif // MEMORY_BASED
+}
+
+// Render object i.  This may run on a worker thread, so it only reads.  In
+// particular, money comes from A_MONEY rather than the player cache, which
+// db_write_checkpoint() syncs first.
+//
+static void db_write_object(DUMP_BUFFER *pdb, dbref i, int flags)
+{
     ATTR *a;
     int ca, j;
 
+    // Format is: "!%d\n", i
+    //
+    dump_reserve(pdb, 1);
+    pdb->pData[pdb->nUsed++] = '!';
+    dump_ref(pdb, i);
+
     if (!(flags & V_ATRNAME))
     {
-        putstring(f, Name(i));
+        dump_string(pdb, db_write_text(i, A_NAME));
     }
-    putref(f, Location(i));
-    putref(f, Zone(i));
-    putref(f, Contents(i));
-    putref(f, Exits(i));
-    putref(f, Link(i));
-    putref(f, Next(i));
-    putref(f, Owner(i));
-    putref(f, Parent(i));
+    dump_ref(pdb, Location(i));
+    dump_ref(pdb, Zone(i));
+    dump_ref(pdb, Contents(i));
+    dump_ref(pdb, Exits(i));
+    dump_ref(pdb, Link(i));
+    dump_ref(pdb, Next(i));
+    dump_ref(pdb, Owner(i));
+    dump_ref(pdb, Parent(i));
     if (!(flags & V_ATRMONEY))
     {
-        putref(f, Pennies(i));
+        const UTF8 *pMoney = Good_obj(i) ? atr_get_raw(i, A_MONEY) : nullptr;
+        dump_ref(pdb, (nullptr == pMoney) ? 0 : mux_atol(pMoney));
     }
-    putref(f, Flags(i));
-    putref(f, Flags2(i));
-    putref(f, Flags3(i));
-    putref(f, Powers(i));
-    putref(f, Powers2(i));
+    dump_ref(pdb, Flags(i));
+    dump_ref(pdb, Flags2(i));
+    dump_ref(pdb, Flags3(i));
+    dump_ref(pdb, Powers(i));
+    dump_ref(pdb, Powers2(i));
 
     // Write the attribute list.
     //
     if (!(flags & V_DATABASE))
     {
-        UTF8 buf[SBUF_SIZE];
-        buf[0] = '>';
         unsigned char *as;
         for (ca = atr_head(i, &as); ca; ca = atr_next(&as))
         {
@@ -853,17 +1080,202 @@ static bool db_write_object(FILE *f, dbref i, int db_format, int flags)
             // Format is: ">%d\n", j
             //
             const UTF8 *p = atr_get_raw(i, j);
-            size_t n = mux_ltoa(j, buf+1) + 1;
-            buf[n++] = '\n';
-            fwrite(buf, sizeof(UTF8), n, f);
-            putstring(f, p);
+            dump_reserve(pdb, 1);
+            pdb->pData[pdb->nUsed++] = '>';
+            dump_ref(pdb, j);
+            dump_string(pdb, p);
         }
-        fwrite("<\n", sizeof(UTF8), 2, f);
+        dump_reserve(pdb, 2);
+        pdb->pData[pdb->nUsed++] = '<';
+        pdb->pData[pdb->nUsed++] = '\n';
     }
-    return false;
 }
 
-dbref db_write(FILE *f, int format, int version)
+static void db_write_range(DUMP_BUFFER *pdb, dbref first, dbref last, int flags)
+{
+    for (dbref i = first; i < last; i++)
+    {
+        if (!isGarbage(i))
+        {
+            db_write_object(pdb, i, flags);
+        }
+    }
+}
+
+static void db_write_dots(dbref first, dbref last)
+{
+    if (mudstate.bStandAlone)
+    {
+        for (dbref i = first; i < last; i++)
+        {
+            if (0 == i % 100)
+            {
+                fputc('.', stderr);
+            }
+        }
+        fflush(stderr);
+    }
+}
+
+#define DUMP_CHUNK_SIZE   1024  // Objects rendered by a worker at a time.
+#define DUMP_MAX_THREADS  16
+#define DUMP_WINDOW       4     // Chunks in flight per worker.
+
+typedef struct
+{
+    DUMP_BUFFER buffer;
+    bool        bRendered;
+} DUMP_CHUNK;
+
+// Shared between the thread writing the file and the workers rendering
+// chunks for it.  Chunks are handed out in order, and workers stay within a
+// window of the writer, so memory use is bounded.
+//
+struct DUMP_SHARED
+{
+    int         flags;
+    int         nChunks;
+    int         nWindow;
+    DUMP_CHUNK *aChunks;
+    int         iNext;
+    int         iWritten;
+
+    std::mutex              mutex;
+    std::condition_variable cvRendered;
+    std::condition_variable cvWritten;
+};
+
+static void db_write_worker(DUMP_SHARED *pds)
+{
+    std::unique_lock<std::mutex> lock(pds->mutex);
+    for (;;)
+    {
+        while (  pds->iNext < pds->nChunks
+              && pds->iWritten + pds->nWindow <= pds->iNext)
+        {
+            pds->cvWritten.wait(lock);
+        }
+
+        if (pds->nChunks <= pds->iNext)
+        {
+            break;
+        }
+        int iChunk = pds->iNext++;
+        lock.unlock();
+
+        dbref first = iChunk * DUMP_CHUNK_SIZE;
+        dbref last = first + DUMP_CHUNK_SIZE;
+        if (mudstate.db_top < last)
+        {
+            last = mudstate.db_top;
+        }
+        db_write_range(&pds->aChunks[iChunk].buffer, first, last, pds->flags);
+
+        lock.lock();
+        pds->aChunks[iChunk].bRendered = true;
+
+        // Parenthesized to keep the notify_all() macro out of it.
+        //
+        (pds->cvRendered.notify_all)();
+    }
+}
+
+// Render the objects on worker threads and write them here in dbref order.
+// Returns false if the workers could not be started.
+//
+static bool db_write_objects_parallel(FILE *f, int flags)
+{
+    int nChunks = (mudstate.db_top + DUMP_CHUNK_SIZE - 1) / DUMP_CHUNK_SIZE;
+    int nThreads = static_cast<int>(std::thread::hardware_concurrency());
+    if (DUMP_MAX_THREADS < nThreads)
+    {
+        nThreads = DUMP_MAX_THREADS;
+    }
+    if (nChunks < nThreads)
+    {
+        nThreads = nChunks;
+    }
+    if (nThreads < 2)
+    {
+        return false;
+    }
+
+    DUMP_SHARED ds;
+    ds.flags    = flags;
+    ds.nChunks  = nChunks;
+    ds.nWindow  = DUMP_WINDOW * nThreads;
+    ds.iNext    = 0;
+    ds.iWritten = 0;
+    ds.aChunks  = (DUMP_CHUNK *)MEMALLOC(nChunks * sizeof(DUMP_CHUNK));
+    ISOUTOFMEMORY(ds.aChunks);
+    memset(ds.aChunks, 0, nChunks * sizeof(DUMP_CHUNK));
+
+    std::thread *apThreads[DUMP_MAX_THREADS];
+    int nStarted = 0;
+    for (int k = 0; k < nThreads; k++)
+    {
+        try
+        {
+            apThreads[nStarted] = new std::thread(db_write_worker, &ds);
+            nStarted++;
+        }
+        catch (...)
+        {
+            break;
+        }
+    }
+
+    if (0 == nStarted)
+    {
+        MEMFREE(ds.aChunks);
+        ds.aChunks = nullptr;
+        return false;
+    }
+
+    // Whatever workers did start will render every chunk.
+    //
+    for (int iChunk = 0; iChunk < nChunks; iChunk++)
+    {
+        {
+            std::unique_lock<std::mutex> lock(ds.mutex);
+            while (!ds.aChunks[iChunk].bRendered)
+            {
+                ds.cvRendered.wait(lock);
+            }
+        }
+
+        DUMP_BUFFER *pdb = &ds.aChunks[iChunk].buffer;
+        if (0 < pdb->nUsed)
+        {
+            fwrite(pdb->pData, sizeof(UTF8), pdb->nUsed, f);
+        }
+        if (nullptr != pdb->pData)
+        {
+            MEMFREE(pdb->pData);
+            pdb->pData = nullptr;
+        }
+
+        dbref first = iChunk * DUMP_CHUNK_SIZE;
+        db_write_dots(first, (iChunk + 1 == nChunks) ? mudstate.db_top : first + DUMP_CHUNK_SIZE);
+
+        {
+            std::lock_guard<std::mutex> lock(ds.mutex);
+            ds.iWritten = iChunk + 1;
+        }
+        (ds.cvWritten.notify_all)();
+    }
+
+    for (int k = 0; k < nStarted; k++)
+    {
+        apThreads[k]->join();
+        delete apThreads[k];
+    }
+    MEMFREE(ds.aChunks);
+    ds.aChunks = nullptr;
+    return true;
+}
+
+dbref db_write_checkpoint(FILE *f, int format, int version, int iBase, int iDelta)
 {
     dbref i;
     int flags;
@@ -879,22 +1291,52 @@ dbref db_write(FILE *f, int format, int version)
         Log.WriteString(T("Can only write MUX format." ENDLINE));
         return -1;
     }
+
+    // Money is written from A_MONEY, which lags the player cache until it
+    // is synced.  This is done here, before anything is rendered, so that
+    // it also reaches the objects of a delta.
+    //
+    if (  !(flags & V_ATRMONEY)
+       && !mudstate.bStandAlone)
+    {
+        pcache_sync();
+    }
+
     if (mudstate.bStandAlone)
     {
         Log.WriteString(T("Writing "));
         Log.Flush();
     }
+    mux_fprintf(f, T("+X%d\n"), flags);
+    if (0 < iBase)
+    {
+        mux_fprintf(f, T("-B%d\n"), iBase);
+        if (0 < iDelta)
+        {
+            mux_fprintf(f, T("-D%d\n"), iDelta);
+        }
+    }
     i = mudstate.attr_next;
-    mux_fprintf(f, T("+X%d\n+S%d\n+N%d\n"), flags, mudstate.db_top, i);
+    mux_fprintf(f, T("+S%d\n+N%d\n"), mudstate.db_top, i);
     mux_fprintf(f, T("-R%d\n"), mudstate.record_players);
+    if (  0 < iDelta
+       && db_vattrs_dirty)
+    {
+        // The user-named attributes which follow are all there are, so any
+        // others have been deleted.
+        //
+        mux_fprintf(f, T("-A%d\n"), anum_alc_top);
+    }
 
-    // Dump user-named attribute info.
+    // Dump user-named attribute info.  A delta carries them only when they
+    // have changed.
     //
     UTF8 Buffer[LBUF_SIZE];
     Buffer[0] = '+';
     Buffer[1] = 'A';
     int iAttr;
-    for (iAttr = A_USER_START; iAttr <= anum_alc_top; iAttr++)
+    int iAttrLast = (0 == iDelta || db_vattrs_dirty) ? anum_alc_top : 0;
+    for (iAttr = A_USER_START; iAttr <= iAttrLast; iAttr++)
     {
         vp = (ATTR *) anum_get(iAttr);
         if (  vp != nullptr
@@ -917,30 +1359,55 @@ dbref db_write(FILE *f, int format, int version)
         }
     }
 
-    int iDotCounter = 0;
-    UTF8 buf[SBUF_SIZE];
-    buf[0] = '!';
-    DO_WHOLE_DB(i)
+    if (0 < iDelta)
     {
-        if (mudstate.bStandAlone)
+        // A delta carries only the objects changed since the last
+        // checkpoint, including those which have been destroyed.
+        //
+        dbref *aList;
+        int nList = db_checkpoint_objects(&aList);
+        DUMP_BUFFER db = { nullptr, 0, 0 };
+        for (int k = 0; k < nList; k++)
         {
-            if (!iDotCounter)
+            db_write_object(&db, aList[k], flags);
+            if (  DUMP_CHUNK_SIZE - 1 == k % DUMP_CHUNK_SIZE
+               || nList - 1 == k)
             {
-                iDotCounter = 100;
-                fputc('.', stderr);
-                fflush(stderr);
+                fwrite(db.pData, sizeof(UTF8), db.nUsed, f);
+                db.nUsed = 0;
             }
-            iDotCounter--;
         }
-
-        if (!isGarbage(i))
+        if (nullptr != db.pData)
         {
-            // Format is: "!%d\n", i
-            //
-            size_t n = mux_ltoa(i, buf+1) + 1;
-            buf[n++] = '\n';
-            fwrite(buf, sizeof(UTF8), n, f);
-            db_write_object(f, i, format, flags);
+            MEMFREE(db.pData);
+            db.pData = nullptr;
+        }
+    }
+    else if (  !db_write_parallel(flags)
+            || !db_write_objects_parallel(f, flags))
+    {
+        // Write in the same chunks as the workers would.
+        //
+        DUMP_BUFFER db = { nullptr, 0, 0 };
+        for (dbref first = 0; first < mudstate.db_top; first += DUMP_CHUNK_SIZE)
+        {
+            dbref last = first + DUMP_CHUNK_SIZE;
+            if (mudstate.db_top < last)
+            {
+                last = mudstate.db_top;
+            }
+            db.nUsed = 0;
+            db_write_range(&db, first, last, flags);
+            if (0 < db.nUsed)
+            {
+                fwrite(db.pData, sizeof(UTF8), db.nUsed, f);
+            }
+            db_write_dots(first, last);
+        }
+        if (nullptr != db.pData)
+        {
+            MEMFREE(db.pData);
+            db.pData = nullptr;
         }
     }
     fputs("***END OF DUMP***\n", f);
@@ -951,3 +1418,8 @@ dbref db_write(FILE *f, int format, int version)
     }
     return mudstate.db_top;
 }
+
+dbref db_write(FILE *f, int format, int version)
+{
+    return db_write_checkpoint(f, format, version, 0, 0);
+}
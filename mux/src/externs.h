@@ -124,7 +124,7 @@ LBUF_OFFSET trimmed_name(dbref player, UTF8 cbuff[MBUF_SIZE], LBUF_OFFSET nMin,
 /* From cque.cpp */
 int  nfy_que(dbref, int, int, int);
 int  halt_que(dbref, dbref);
-void wait_que(dbref executor, dbref caller, dbref enactor, int, bool,
+bool wait_que(dbref executor, dbref caller, dbref enactor, int, bool,
     CLinearTimeAbsolute&, dbref, int, UTF8 *, int, const UTF8 *[], reg_ref *[]);
 void query_complete(UINT32 hQuery, UINT32 iError, CResultsSet *prs);
 
@@ -247,6 +247,8 @@ bool atr_match
     UTF8  *raw_str,
     bool  check_parents
 );
+void cmdcache_clear(dbref thing);
+void cmdcache_changed(dbref thing, int atr, const UTF8 *szValue);
 
 bool regexp_match
 (
@@ -266,6 +268,32 @@ bool list_check
     UTF8  *raw_str,
     bool  check_parent
 );
+bool list_check_index
+(
+    dbref room,
+    dbref player,
+    UTF8  *str,
+    UTF8  *raw_str,
+    bool  check_parent
+);
+void cmdindex_drop(dbref room);
+void cmdindex_drop_all(void);
+void cmdindex_touch(dbref thing);
+
+typedef struct hear_list
+{
+    dbref  loc;
+    int    nRef;
+    bool   bStale;
+    int    nHearers;
+    dbref *aHearers;        // Objects to offer a message, in contents order.
+} HEAR_LIST;
+
+HEAR_LIST *hearlist_acquire(dbref loc, int key);
+void hearlist_release(HEAR_LIST *phl);
+void hearlist_drop(dbref loc);
+void hearlist_drop_all(void);
+void hearlist_touch(dbref thing);
 bool html_escape(const UTF8 *src, UTF8 *dest, UTF8 **destp);
 
 #define DUMP_I_NORMAL    0  // OUTPUT to the outdb through a temporary file.
@@ -276,6 +304,7 @@ bool html_escape(const UTF8 *src, UTF8 *dest, UTF8 **destp);
 #define NUM_DUMP_TYPES   5
 void dump_database_internal(int);
 void fork_and_dump(int key);
+void checkpoint_target(UTF8 *pName, size_t nName);
 
 #define MUX_OPEN_INVALID_HANDLE_VALUE (-1)
 bool mux_fopen(FILE **pFile, const UTF8 *filename, const UTF8 *mode);
@@ -337,6 +366,7 @@ public:
 };
 
 extern CLogFile Log;
+extern CLogFile SlowLog;
 
 /* From look.cpp */
 void look_in(dbref,dbref, int);
@@ -455,6 +485,9 @@ void SetClearFlags(dbref thing, FLAG aClearFlags[3], FLAG aSetFlags[3]);
 bool eval_boolexp(dbref, dbref, dbref, BOOLEXP *);
 BOOLEXP *parse_boolexp(dbref, const UTF8 *, bool);
 bool eval_boolexp_atr(dbref, dbref, dbref, UTF8 *);
+bool eval_boolexp_lock(dbref, dbref, dbref, dbref, int);
+void lockcache_changed(dbref, int);
+void lockcache_flush(void);
 
 /* From functions.cpp */
 bool xlate(UTF8 *);
@@ -492,6 +525,9 @@ UTF8 *process_command(dbref executor, dbref caller, dbref enactor, int, bool,
     UTF8 *, const UTF8 *[], int);
 size_t LeftJustifyString(UTF8 *field, size_t nWidth, const UTF8 *value);
 size_t RightJustifyNumber(UTF8 *field, size_t nWidth, INT64 value, UTF8 chFill);
+void latency_attr(dbref thing, int atr, dbref executor, dbref enactor,
+    CLinearTimeDelta ltd);
+void latency_forget(dbref thing, int atr);
 
 #define Protect(f) (cmdp->perms & f)
 
@@ -508,6 +544,9 @@ void s_Moniker(dbref thing, const UTF8 *s);
 const UTF8 *Name(dbref thing);
 const UTF8 *PureName(dbref thing);
 const UTF8 *Moniker(dbref thing);
+void name_index_rename(dbref thing, const UTF8 *pName);
+int  name_index_gather(const UTF8 *pPattern, dbref **paList);
+void name_index_drop(void);
 FWDLIST *fwdlist_load(dbref player, UTF8 *atext);
 void fwdlist_set(dbref, FWDLIST *);
 void fwdlist_clr(dbref);
@@ -546,6 +585,8 @@ UTF8 *atr_pget_str_LEN(UTF8 *, dbref, int, dbref *, int *, size_t *);
 UTF8 *atr_pget_str(UTF8 *, dbref, int, dbref *, int *);
 bool atr_get_info(dbref, int, dbref *, int *);
 bool atr_pget_info(dbref, int, dbref *, int *);
+const UTF8 *atr_pget_text_LEN(dbref, int, size_t *);
+void atr_resolve_flush(void);
 void atr_free(dbref);
 bool check_zone_handler(dbref player, dbref thing, bool bPlayerCheck);
 #define check_zone(player, thing) check_zone_handler(player, thing, false)
@@ -599,6 +640,7 @@ extern int anum_alc_top;
 #define CSET_LOG_TIME  10   // Add timestamps to logs
 #define DBCK_DEFAULT    1   /* Get default tests too */
 #define DBCK_FULL       2   /* Do all tests */
+#define DBCK_INDEX      4   /* Check the object indexes */
 #define DECOMP_DBREF    1   /* decompile by dbref */
 //#define DECOMP_PRETTY   2   /* pretty-format output */
 #define DEST_ONE        1   /* object */
@@ -681,6 +723,9 @@ extern int anum_alc_top;
 #define ICMD_LALLROOM   512
 #define KILL_KILL       1   /* gives victim insurance */
 #define KILL_SLAY       2   /* no insurance */
+#define LATENCY_RESET   1   // Reset all histograms
+#define LATENCY_SCREEN  2   // Write summary to screen
+#define LATENCY_LOG     4   // Write histograms to the slow command log
 #define LOOK_LOOK       1   /* list desc (and succ/fail if room) */
 #define LOOK_OUTSIDE    8   /* look for object in container of player */
 #define MAIL_STATS      1   /* Mail stats */
@@ -1041,26 +1086,37 @@ extern pid_t game_pid;
 void init_timer(void);
 void dispatch_DatabaseDump(void *pUnused, int iUnused);
 void dispatch_FreeListReconstruction(void *pUnused, int iUnused);
-void dispatch_IdleCheck(void *pUnused, int iUnused);
 void dispatch_CheckEvents(void *pUnused, int iUnused);
-void dispatch_KeepAlive(void *pUnused, int iUnused);
+void dispatch_JournalCommit(void *pUnused, int iUnused);
 #ifndef MEMORY_BASED
 void dispatch_CacheTick(void *pUnused, int iUnused);
 #endif
 
-// Using a heap as the data structure for representing this priority
-// has some attributes which we depend on:
+// Pending tasks are kept in three kinds of structures:
 //
-// 1. Most importantly, actions scheduled for the same time (i.e.,
-//    immediately) keep the order that they were inserted into the
-//    heap.
+// 1. A hierarchical timer wheel holds tasks scheduled for a particular
+//    time. Inserting and removing a task is O(1).
+//
+// 2. A FIFO per priority level holds tasks scheduled to run immediately.
+//    Tickets are handed out in increasing order, so each FIFO is also in
+//    ticket order.
+//
+// 3. A heap holds timed tasks which have come due, ordered by priority
+//    and then by ticket.
+//
+// The next task to run is the one with the lowest priority and ticket
+// among the top of the heap and the heads of the FIFOs. Most importantly,
+// actions scheduled for the same time (i.e., immediately) keep the order
+// that they were inserted.
 //
 // If you ever re-implement this object using another data structure,
 // please remember to maintain this property.
 //
 typedef void FTASK(void *, int);
 
-typedef struct
+class CTaskList;
+
+typedef struct task_record
 {
     CLinearTimeAbsolute ltaWhen;
 
@@ -1070,6 +1126,15 @@ typedef struct
     void       *arg_voidptr;
     int        arg_Integer;
     int        m_iVisitedMark;
+    int        m_iHeapIndex;    // Position on the PriorityHeap, or -1.
+    int        m_iGroup;        // Fair-share group (the owner), or -1.
+    int        m_iWeight;       // Share of the group when it is busy.
+
+    // Links for the timer wheel slot or FIFO that holds this task.
+    //
+    CTaskList          *m_pList;
+    struct task_record *m_pNext;
+    struct task_record *m_pPrev;
 } TASK_RECORD, *PTASK_RECORD;
 
 #define PRIORITY_SYSTEM  100
@@ -1085,6 +1150,11 @@ typedef struct
 typedef int SCHCMP(PTASK_RECORD, PTASK_RECORD);
 typedef int SCHLOOK(PTASK_RECORD);
 
+#define IU_DONE        0
+#define IU_NEXT_TASK   1
+#define IU_REMOVE_TASK 2
+#define IU_UPDATE_TASK 3
+
 class CTaskHeap
 {
 private:
@@ -1100,7 +1170,6 @@ private:
     PTASK_RECORD Remove(int, SCHCMP *);
     void Update(int iNode, SCHCMP *pfCompare);
     void Sort(SCHCMP *pfCompare);
-    void Remake(SCHCMP *pfCompare);
 
 public:
     CTaskHeap();
@@ -1111,29 +1180,175 @@ public:
     PTASK_RECORD PeekAtTopmost(void);
     PTASK_RECORD RemoveTopmost(SCHCMP *);
     void CancelTask(FTASK *fpTask, void *arg_voidptr, int arg_Integer);
+    void Remake(SCHCMP *pfCompare);
+    void RemoveTask(PTASK_RECORD pTask, SCHCMP *pfCompare);
+    void UpdateTask(PTASK_RECORD pTask, SCHCMP *pfCompare);
+    int  Count(void) { return m_nCurrent; }
+    PTASK_RECORD GetTask(int i) { return m_pHeap[i]; }
 
-#define IU_DONE        0
-#define IU_NEXT_TASK   1
-#define IU_REMOVE_TASK 2
-#define IU_UPDATE_TASK 3
     int TraverseUnordered(SCHLOOK *pfLook, SCHCMP *pfCompare);
     int TraverseOrdered(SCHLOOK *pfLook, SCHCMP *pfCompare);
 };
 
+// A doubly-linked list of tasks. Used for timer wheel slots, FIFOs, and
+// fair-share groups.
+//
+#define LIST_FIFO  (-1)
+#define LIST_GROUP (-2)
+
+class CTaskList
+{
+public:
+    PTASK_RECORD m_pHead;
+    PTASK_RECORD m_pTail;
+    int          m_nTasks;
+    int          m_iLevel;      // Timer wheel level, LIST_FIFO, or LIST_GROUP.
+
+    CTaskList(void) { m_pHead = nullptr; m_pTail = nullptr; m_nTasks = 0; m_iLevel = LIST_FIFO; }
+    void Append(PTASK_RECORD pTask);
+    void Remove(PTASK_RECORD pTask);
+};
+
+class CTaskFairQueue;
+
+// The tasks of one group at one priority, in ticket order.
+//
+class CTaskGroup : public CTaskList
+{
+public:
+    void Insert(PTASK_RECORD pTask);
+
+
+    CTaskFairQueue *m_pQueue;
+    int         m_iGroup;
+    int         m_iWeight;
+    int         m_iDeficit;     // Tasks left in this turn.
+    bool        m_bActive;      // On the active ring rather than pending.
+    CTaskGroup *m_pRingNext;
+    CTaskGroup *m_pRingPrev;
+    CTaskGroup *m_pHashNext;
+};
+
+#define FAIR_HASH_SIZE 256
+
+// Tasks at one priority are taken from their groups by deficit round-robin:
+// when a group's turn comes, it may run as many tasks as its weight before
+// the next group on the active ring. A group whose first task is not ready
+// yet waits on the pending ring until the next ReadyTasks().
+//
+class CTaskFairQueue
+{
+private:
+    CTaskGroup *m_aHash[FAIR_HASH_SIZE];
+    CTaskGroup *m_pActive;
+    CTaskGroup *m_pPending;
+    CTaskGroup *m_pCurrent;
+    int         m_nTasks;
+
+    CTaskGroup *Find(int iGroup);
+    void Join(CTaskGroup **ppRing, CTaskGroup *pGroup);
+    void Leave(CTaskGroup **ppRing, CTaskGroup *pGroup);
+    void Activate(CTaskGroup *pGroup);
+    void Deactivate(CTaskGroup *pGroup);
+    void NextTurn(void);
+
+public:
+    CTaskFairQueue(void);
+    ~CTaskFairQueue(void);
+
+    void Append(PTASK_RECORD pTask, bool bReady);
+    void Remove(PTASK_RECORD pTask, int iReadyTicket);
+    void Regroup(PTASK_RECORD pTask, int iGroup, int iWeight, int iReadyTicket);
+    void MakeReady(void);
+    PTASK_RECORD PeekAtNext(void) { return (nullptr == m_pCurrent) ? nullptr : m_pCurrent->m_pHead; }
+    bool IsPending(void) { return nullptr != m_pPending; }
+    int  Count(void) { return m_nTasks; }
+    int  Collect(PTASK_RECORD *aTasks);
+    void CancelTask(FTASK *fpTask, void *arg_voidptr, int arg_Integer);
+};
+
+// The timer wheel advances in ticks of 2^17 100ns units (about 13ms). The
+// first level has a slot for each of the next 256 ticks, and each of the
+// four levels above it has 64 slots, each spanning 64 slots of the level
+// below. Tasks further out than the last level are parked in its furthest
+// slot and placed again when that slot is cascaded.
+//
+#define WHEEL_TICK_SHIFT  17
+#define WHEEL_ROOT_BITS   8
+#define WHEEL_LEVEL_BITS  6
+#define WHEEL_ROOT_SIZE   (1 << WHEEL_ROOT_BITS)
+#define WHEEL_LEVEL_SIZE  (1 << WHEEL_LEVEL_BITS)
+#define WHEEL_LEVELS      5
+#define WHEEL_LISTS       (WHEEL_ROOT_SIZE + (WHEEL_LEVELS-1)*WHEEL_LEVEL_SIZE)
+
+class CTaskWheel
+{
+private:
+    CTaskList m_aLists[WHEEL_LISTS];
+    int       m_anTasks[WHEEL_LEVELS];
+    int       m_nTasks;
+    INT64     m_tCurrent;
+
+    CTaskList *Level(int iLevel, INT64 iSlot)
+    {
+        return &m_aLists[WHEEL_ROOT_SIZE + (iLevel-1)*WHEEL_LEVEL_SIZE + (iSlot & (WHEEL_LEVEL_SIZE-1))];
+    }
+    CTaskList *Slot(INT64 tWhen);
+    void Place(PTASK_RECORD pTask);
+    void Cascade(CTaskList *pList);
+    void Advance(INT64 tNow);
+
+public:
+    CTaskWheel(void);
+    ~CTaskWheel(void);
+
+    void Insert(PTASK_RECORD pTask);
+    void Remove(PTASK_RECORD pTask);
+    PTASK_RECORD RemoveExpired(const CLinearTimeAbsolute& ltaNow);
+    bool WhenNext(CLinearTimeAbsolute *pltaWhen);
+    void CancelTask(FTASK *fpTask, void *arg_voidptr, int arg_Integer);
+    int  Count(void) { return m_nTasks; }
+    int  Collect(PTASK_RECORD *aTasks);
+};
+
+// Immediate tasks at PRIORITY_SYSTEM have a FIFO. Ready tasks at
+// PRIORITY_PLAYER and PRIORITY_OBJECT are shared fairly among their groups.
+// Immediate tasks at other priorities go through the timer wheel as already
+// due.
+//
+#define NUM_FAIR 2
+
 class CScheduler
 {
 private:
-    CTaskHeap m_WhenHeap;
-    CTaskHeap m_PriorityHeap;
-    int       m_Ticket;
-    int       m_minPriority;
+    CTaskWheel m_Wheel;
+    CTaskList  m_Immediate;
+    CTaskFairQueue m_aFair[NUM_FAIR];
+    CTaskHeap  m_PriorityHeap;
+    int        m_Ticket;
+    int        m_ReadyTicket;   // Immediate tasks before this ticket are ready.
+    int        m_minPriority;
+
+    CTaskFairQueue *FairQueue(int iPriority);
+    bool         IsReady(PTASK_RECORD pTask);
+    void         Ready(PTASK_RECORD pTask);
+    PTASK_RECORD PeekAtNext(void);
+    void         Unlink(PTASK_RECORD pTask);
+    void         Relocate(PTASK_RECORD pTask);
+    int          Collect(PTASK_RECORD **paTasks, bool bHeap, bool bReady, bool bWaiting, int iPriority);
 
 public:
     void TraverseUnordered(SCHLOOK *pfLook);
     void TraverseOrdered(SCHLOOK *pfLook);
-    CScheduler(void) { m_Ticket = 0; m_minPriority = PRIORITY_CF_DEQUEUE_ENABLED; }
-    void DeferTask(const CLinearTimeAbsolute& ltWhen, int iPriority, FTASK *fpTask, void *arg_voidptr, int arg_Integer);
-    void DeferImmediateTask(int iPriority, FTASK *fpTask, void *arg_voidptr, int arg_Integer);
+    void TraverseOrdered(SCHLOOK *pfLook, int iPriority);
+    void SortTasks(PTASK_RECORD *aTasks, int nTasks);
+    CScheduler(void);
+    ~CScheduler(void);
+    PTASK_RECORD DeferTask(const CLinearTimeAbsolute& ltWhen, int iPriority, FTASK *fpTask, void *arg_voidptr, int arg_Integer, int iGroup = -1, int iWeight = 1);
+    PTASK_RECORD DeferImmediateTask(int iPriority, FTASK *fpTask, void *arg_voidptr, int arg_Integer, int iGroup = -1, int iWeight = 1);
+    void RemoveTask(PTASK_RECORD pTask);
+    void UpdateTask(PTASK_RECORD pTask);
+    void RegroupTask(PTASK_RECORD pTask, int iGroup, int iWeight);
     bool WhenNext(CLinearTimeAbsolute *);
     int  RunTasks(int iCount);
     int  RunAllTasks(void);
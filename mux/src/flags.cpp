@@ -40,11 +40,14 @@ static bool fh_any(dbref target, dbref player, FLAG flag, int fflags, bool reset
     if (reset)
     {
         db[target].fs.word[fflags] &= ~flag;
+        db_dirty(target);
     }
     else
     {
         db[target].fs.word[fflags] |= flag;
+        db_dirty(target);
     }
+    hearlist_touch(target);
     return true;
 }
 
@@ -61,6 +64,24 @@ static bool fh_god(dbref target, dbref player, FLAG flag, int fflags, bool reset
     return (fh_any(target, player, flag, fflags, reset));
 }
 
+/* ---------------------------------------------------------------------------
+ * fh_wizard: only GOD may set or clear the WIZARD bit.  It decides the share
+ * of the queue that the entries of target's objects get.
+ */
+
+static bool fh_wizard(dbref target, dbref player, FLAG flag, int fflags, bool reset)
+{
+    if (!fh_god(target, player, flag, fflags, reset))
+    {
+        return false;
+    }
+    if (OwnsOthers(target))
+    {
+        que_reweight(target);
+    }
+    return true;
+}
+
 /*
  * ---------------------------------------------------------------------------
  * * fh_wiz: only WIZARDS (or GOD) may set or clear the bit
@@ -315,6 +336,29 @@ static bool fh_unicode(dbref target, dbref player, FLAG flag, int fflags, bool r
     return false;
 }
 
+/*
+ * ---------------------------------------------------------------------------
+ * * fh_keepalive: start keepalives on the player's sessions when set.
+ */
+
+static bool fh_keepalive(dbref target, dbref player, FLAG flag, int fflags, bool reset)
+{
+    if (fh_any(target, player, flag, fflags, reset))
+    {
+        if (  !reset
+           && isPlayer(target))
+        {
+            DESC *dtemp;
+            DESC_ITER_PLAYER(target, dtemp)
+            {
+                desc_start_keepalive(dtemp);
+            }
+        }
+        return true;
+    }
+    return false;
+}
+
 /*
  * ---------------------------------------------------------------------------
  * * fh_ascii: only players may set or clear this bit.
@@ -374,7 +418,7 @@ static FLAGBITENT fbeHtml           = { HTML,         '(',    FLAG_WORD2, 0,
 static FLAGBITENT fbeImmortal       = { IMMORTAL,     'i',    FLAG_WORD1, 0,                    fh_wiz};
 static FLAGBITENT fbeInherit        = { INHERIT,      'I',    FLAG_WORD1, 0,                    fh_inherit};
 static FLAGBITENT fbeJumpOk         = { JUMP_OK,      'J',    FLAG_WORD1, 0,                    fh_any};
-static FLAGBITENT fbeKeepAlive      = { CKEEPALIVE,   'k',    FLAG_WORD2, 0,                    fh_any};
+static FLAGBITENT fbeKeepAlive      = { CKEEPALIVE,   'k',    FLAG_WORD2, 0,                    fh_keepalive};
 static FLAGBITENT fbeKey            = { KEY,          'K',    FLAG_WORD2, 0,                    fh_any};
 static FLAGBITENT fbeLight          = { LIGHT,        'l',    FLAG_WORD2, 0,                    fh_any};
 static FLAGBITENT fbeLinkOk         = { LINK_OK,      'L',    FLAG_WORD1, 0,                    fh_any};
@@ -406,7 +450,7 @@ static FLAGBITENT fbeUninspected    = { UNINSPECTED,  'g',    FLAG_WORD2, 0,
 static FLAGBITENT fbeVacation       = { VACATION,     '|',    FLAG_WORD2, 0,                    fh_restrict_player};
 static FLAGBITENT fbeVerbose        = { VERBOSE,      'v',    FLAG_WORD1, 0,                    fh_any};
 static FLAGBITENT fbeVisual         = { VISUAL,       'V',    FLAG_WORD1, 0,                    fh_any};
-static FLAGBITENT fbeWizard         = { WIZARD,       'W',    FLAG_WORD1, 0,                    fh_god};
+static FLAGBITENT fbeWizard         = { WIZARD,       'W',    FLAG_WORD1, 0,                    fh_wizard};
 static FLAGBITENT fbeSitemon        = { SITEMON,      '$',    FLAG_WORD3, 0,                    fh_wiz};
 #ifdef WOD_REALMS
 static FLAGBITENT fbeFae            = { FAE,          '0',    FLAG_WORD3, CA_STAFF,             fh_wizroy};
@@ -481,8 +481,8 @@ FUNCTION(fun_create)
         if (thing != NOTHING)
         {
             s_Exits(thing, executor);
-            s_Next(thing, Exits(executor));
-            s_Exits(executor, thing);
+            s_Exits(executor, insert_first(Exits(executor), thing));
+            exitindex_drop(executor);
             local_data_create(thing);
             ServerEventsSinkNode *p = g_pServerEventsSinkListHead;
             while (nullptr != p)
@@ -928,19 +928,24 @@ static void scan_zone
         return;
     }
 
-    dbref i;
+    dbref *aZoned;
+    int nZoned = db_index_gather(DBI_ZONE, it, &aZoned);
+
     ITL pContext;
     ItemToList_Init(&pContext, buff, bufc, '#');
-    DO_WHOLE_DB(i)
+    for (int i = 0; i < nZoned; i++)
     {
-        if (  Typeof(i) == ObjectType
-           && Zone(i) == it
-           && !ItemToList_AddInteger(&pContext, i))
+        if (  Typeof(aZoned[i]) == ObjectType
+           && !ItemToList_AddInteger(&pContext, aZoned[i]))
         {
             break;
         }
     }
     ItemToList_Final(&pContext);
+    if (nullptr != aZoned)
+    {
+        MEMFREE(aZoned);
+    }
 }
 
 FUNCTION(fun_zwho)
@@ -991,18 +996,23 @@ FUNCTION(fun_children)
         return;
     }
 
-    dbref i;
+    dbref *aChildren;
+    int nChildren = db_index_gather(DBI_PARENT, it, &aChildren);
+
     ITL pContext;
     ItemToList_Init(&pContext, buff, bufc, '#');
-    DO_WHOLE_DB(i)
+    for (int i = 0; i < nChildren; i++)
     {
-        if (  Parent(i) == it
-           && !ItemToList_AddInteger(&pContext, i))
+        if (!ItemToList_AddInteger(&pContext, aChildren[i]))
         {
             break;
         }
     }
     ItemToList_Final(&pContext);
+    if (nullptr != aChildren)
+    {
+        MEMFREE(aChildren);
+    }
 }
 
 FUNCTION(fun_objeval)
@@ -1536,14 +1546,17 @@ FUNCTION(fun_playmem)
     {
         thing = executor;
     }
+    dbref *aOwned;
+    int nOwned = db_index_gather(DBI_OWNER, thing, &aOwned);
+
     size_t tot = 0;
-    dbref j;
-    DO_WHOLE_DB(j)
+    for (int i = 0; i < nOwned; i++)
     {
-        if (Owner(j) == thing)
-        {
-            tot += mem_usage(j);
-        }
+        tot += mem_usage(aOwned[i]);
+    }
+    if (nullptr != aOwned)
+    {
+        MEMFREE(aOwned);
     }
     safe_ltoa(static_cast<long>(tot), buff, bufc);
 }
@@ -5333,10 +5333,8 @@ static FUNCTION(fun_elock)
     UNUSED_PARAMETER(cargs);
     UNUSED_PARAMETER(ncargs);
 
-    dbref it, aowner;
-    int aflags;
+    dbref it;
     ATTR *pattr;
-    struct boolexp *pBoolExp;
 
     // Parse lock supplier into obj + lock.
     //
@@ -5363,19 +5361,15 @@ static FUNCTION(fun_elock)
     else if (  nearby_or_control(executor, victim)
             || nearby_or_control(executor, it))
     {
-        UTF8 *tbuf = atr_get("fun_elock.4738", it, pattr->number, &aowner, &aflags);
         if (  pattr->number == A_LOCK
            || bCanReadAttr(executor, it, pattr, false))
         {
-            pBoolExp = parse_boolexp(executor, tbuf, true);
-            safe_bool(eval_boolexp(victim, it, it, pBoolExp), buff, bufc);
-            free_boolexp(pBoolExp);
+            safe_bool(eval_boolexp_lock(executor, victim, it, it, pattr->number), buff, bufc);
         }
         else
         {
             safe_chr('0', buff, bufc);
         }
-        free_lbuf(tbuf);
     }
     else
     {
@@ -5695,6 +5689,63 @@ static FUNCTION(fun_mtime)
     }
 }
 
+// ---------------------------------------------------------------------------
+// fun_cputime: Return the CPU time in milliseconds an object has used, or
+// with 'owner', the CPU time queue entries of its owner's objects have used.
+// ---------------------------------------------------------------------------
+
+static FUNCTION(fun_cputime)
+{
+    UNUSED_PARAMETER(caller);
+    UNUSED_PARAMETER(enactor);
+    UNUSED_PARAMETER(eval);
+    UNUSED_PARAMETER(cargs);
+    UNUSED_PARAMETER(ncargs);
+
+    bool bOwner = false;
+    if (2 == nfargs)
+    {
+        if (mux_stricmp(T("owner"), fargs[1]) == 0)
+        {
+            bOwner = true;
+        }
+        else if (mux_stricmp(T("object"), fargs[1]) != 0)
+        {
+            safe_str(T("#-1 INVALID TYPE"), buff, bufc);
+            return;
+        }
+    }
+
+    dbref thing = match_thing_quiet(executor, fargs[0]);
+    if (!Good_obj(thing))
+    {
+        safe_match_result(thing, buff, bufc);
+        return;
+    }
+
+    if (bOwner)
+    {
+        thing = Owner(thing);
+    }
+
+    if (  !Good_obj(thing)
+       || (  !Controls(executor, thing)
+          && !See_Queue(executor)))
+    {
+        safe_noperm(buff, bufc);
+        return;
+    }
+
+    if (bOwner)
+    {
+        safe_ltoa(db[thing].queue_cpu_time.ReturnMilliseconds(), buff, bufc);
+    }
+    else
+    {
+        safe_ltoa(db[thing].cpu_time_used.ReturnMilliseconds(), buff, bufc);
+    }
+}
+
 // ---------------------------------------------------------------------------
 // fun_moniker: Return the value of an object's @moniker attribute.
 // ---------------------------------------------------------------------------
@@ -11067,6 +11118,7 @@ static FUN builtin_function_list[] =
     {T("CORBOOL"),     fun_corbool,    MAX_ARG, 0, MAX_ARG, FN_NOEVAL, CA_PUBLIC},
     {T("COS"),         fun_cos,        MAX_ARG, 1,       2,         0, CA_PUBLIC},
     {T("CPAD"),        fun_cpad,       MAX_ARG, 2,       3,         0, CA_PUBLIC},
+    {T("CPUTIME"),     fun_cputime,    MAX_ARG, 1,       2,         0, CA_PUBLIC},
     {T("CRC32"),       fun_crc32,      MAX_ARG, 0, MAX_ARG,         0, CA_PUBLIC},
     {T("CREATE"),      fun_create,     MAX_ARG, 2,       3,         0, CA_PUBLIC},
     {T("CTIME"),       fun_ctime,      MAX_ARG, 0,       1,         0, CA_PUBLIC},
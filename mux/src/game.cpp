@@ -18,10 +18,12 @@
 #include "file_c.h"
 #include "functions.h"
 #include "help.h"
+#include "journal.h"
 #include "mguests.h"
 #include "muxcli.h"
 #include "pcre.h"
 #include "powers.h"
+#include "snapshot.h"
 #ifdef REALITY_LVLS
 #include "levels.h"
 #endif // REALITY_LVLS
@@ -47,6 +49,25 @@ void do_dump(dbref executor, dbref caller, dbref enactor, int eval, int key)
 #endif
     notify(executor, T("Dumping..."));
     fork_and_dump(key);
+
+    if (  0 == key
+       || (key & DUMP_STRUCT))
+    {
+        UTF8 target[SIZEOF_PATHNAME+32];
+        checkpoint_target(target, sizeof(target));
+        struct stat statbuf;
+#if defined(HAVE_WORKING_FORK)
+        if (mudstate.dumping)
+        {
+            notify(executor, tprintf(T("Writing %s in the background."), target));
+        }
+        else
+#endif // HAVE_WORKING_FORK
+        if (stat((char *)target, &statbuf) == 0)
+        {
+            notify(executor, tprintf(T("Wrote %s: %lld bytes."), target, (INT64)statbuf.st_size));
+        }
+    }
 }
 
 // print out stuff into error file
@@ -74,41 +95,20 @@ void report(void)
 }
 
 /* ----------------------------------------------------------------------
- * regexp_match: Load a regular expression match and insert it into
- * registers.
+ * regexp_exec: Match a compiled regular expression and insert the substrings
+ * into registers.
  */
 
-bool regexp_match
+static bool regexp_exec
 (
-    UTF8 *pattern,
+    pcre *re,
     UTF8 *str,
-    int case_opt,
     UTF8 *args[],
     int nargs
 )
 {
     int matches;
     int i;
-    const char *errptr;
-    int erroffset;
-
-    /*
-     * Load the regexp pattern. This allocates memory which must be
-     * later freed. A free() of the regexp does free all structures
-     * under it.
-     */
-
-    pcre *re;
-    if (  alarm_clock.alarmed
-       || (re = pcre_compile((char *)pattern, PCRE_UTF8|case_opt, &errptr, &erroffset, nullptr)) == nullptr)
-    {
-        /*
-         * This is a matching error. We have an error message in
-         * regexp_errbuf that we can ignore, since we're doing
-         * command-matching.
-         */
-        return false;
-    }
 
     // To capture N substrings, you need space for 3(N+1) offsets in the
     // offset vector. We'll allow 2N-1 substrings and possibly ignore some.
@@ -124,7 +124,6 @@ bool regexp_match
     if (matches < 0)
     {
         delete [] ovec;
-        MEMFREE(re);
         return false;
     }
 
@@ -155,102 +154,346 @@ bool regexp_match
     }
 
     delete [] ovec;
-    MEMFREE(re);
     return true;
 }
 
 /* ----------------------------------------------------------------------
- * atr_match: Check attribute list for wild card matches and queue them.
+ * regexp_match: Load a regular expression match and insert it into
+ * registers.
  */
 
-static int atr_match1
+bool regexp_match
 (
-    dbref thing,
-    dbref parent,
-    dbref player,
-    UTF8  type,
-    UTF8  *str,
-    UTF8  *raw_str,
-    int   check_exclude,
-    int   hash_insert
+    UTF8 *pattern,
+    UTF8 *str,
+    int case_opt,
+    UTF8 *args[],
+    int nargs
 )
 {
-    // See if we can do it.  Silently fail if we can't.
-    //
-    if (!could_doit(player, parent, A_LUSE))
+    const char *errptr;
+    int erroffset;
+
+    /*
+     * Load the regexp pattern. This allocates memory which must be
+     * later freed. A free() of the regexp does free all structures
+     * under it.
+     */
+
+    pcre *re;
+    if (  alarm_clock.alarmed
+       || (re = pcre_compile((char *)pattern, PCRE_UTF8|case_opt, &errptr, &erroffset, nullptr)) == nullptr)
     {
-        return -1;
+        /*
+         * This is a matching error. We have an error message in
+         * regexp_errbuf that we can ignore, since we're doing
+         * command-matching.
+         */
+        return false;
     }
 
-    int match = 0;
-    if (  (  AMATCH_CMD    == type
-          && mudstate.bfNoCommands.IsSet(parent))
-       || (  AMATCH_LISTEN == type
-          && mudstate.bfNoListens.IsSet(parent)))
+    bool bMatched = regexp_exec(re, str, args, nargs);
+    MEMFREE(re);
+    return bMatched;
+}
+
+/* ----------------------------------------------------------------------
+ * Compiled $-command and ^-listen patterns.
+ *
+ * The first time an object is checked for $-commands or ^-listens, its
+ * patterns are pulled out of its attributes, regular expressions are
+ * compiled, and the result is kept with the object until one of its
+ * attributes changes.  Each cache holds only the object's own attributes,
+ * so changing a parent does not invalidate it.
+ *
+ * A wild() pattern which begins with a literal word can only match a string
+ * which begins with the same word (compared without regard to ASCII case).
+ * Those words are kept in mudstate.cmd_word_htab, keyed by object, leadin
+ * character, and word, so an object whose patterns all begin with literal
+ * words is passed over with a single lookup when none of them fit.
+ */
+
+#define CMD_WORD_MAX  32
+
+#define CMD_TYPE_CMD    0
+#define CMD_TYPE_LISTEN 1
+#define CMD_NUM_TYPES   2
+#define CMD_TYPE_ROOM   2   // Key type of room command index words.
+
+typedef struct cmd_pattern
+{
+    int    atr;             // Attribute holding the pattern.
+    int    aflags;          // Attribute flags on the object.
+    int    iType;           // CMD_TYPE_CMD or CMD_TYPE_LISTEN.
+    size_t nWord;           // Length of the literal first word or 0.
+    UTF8  *pattern;         // Pattern text between the leadin and ':'.
+    pcre  *re;              // Compiled pattern when AF_REGEXP.
+} CMD_PATTERN;
+
+typedef struct cmd_attr
+{
+    int    atr;
+    int    aflags;
+} CMD_ATTR;
+
+struct cmd_cache
+{
+    int          nPatterns;
+    CMD_PATTERN *aPatterns;
+
+    // Number of patterns of each type, and whether any of them lacks a
+    // literal first word and must always be tried.
+    //
+    int          nType[CMD_NUM_TYPES];
+    bool         bWildFirst[CMD_NUM_TYPES];
+
+    // Every attribute on the object, needed to exclude attributes on parents.
+    // Loaded only for objects which take part in parent chains.
+    //
+    bool         bAttrs;
+    int          nAttrs;
+    CMD_ATTR    *aAttrs;
+};
+
+// A command or message prepared for matching against cached patterns.
+//
+typedef struct cmd_subject
+{
+    UTF8  *str;
+    UTF8  *raw_str;
+    UTF8   word[CMD_WORD_MAX+1];
+    size_t nWord;
+    UTF8   raw_word[CMD_WORD_MAX+1];
+    size_t nRawWord;
+} CMD_SUBJECT;
+
+// Copy the first space-delimited word of str in lower case.  Words too long
+// to be indexed are reported as empty and can only match wild-first patterns.
+//
+static size_t cmd_first_word(const UTF8 *str, UTF8 word[CMD_WORD_MAX+1])
+{
+    size_t n = 0;
+    while (  '\0' != str[n]
+          && ' '  != str[n])
     {
-        // We may need to process the hash_insert to support exclusion of
-        // this parent's $-commands before we return no matches.
-        //
-        if (hash_insert)
+        if (CMD_WORD_MAX <= n)
         {
-            // Because we know this object contains no commands, there is no
-            // need to look at the attribute values.
-            //
-            atr_push();
-            unsigned char *as;
-            for (int atr = atr_head(parent, &as); atr; atr = atr_next(&as))
-            {
-                ATTR *ap = atr_num(atr);
+            word[0] = '\0';
+            return 0;
+        }
+        word[n] = mux_tolower_ascii(str[n]);
+        n++;
+    }
+    word[n] = '\0';
+    return n;
+}
 
-                if (  ap
-                   && 0 == (ap->flags & AF_NOPROG)
-                   && (  !check_exclude
-                      || (  0 == (ap->flags & AF_PRIVATE)
-                         && !hashfindLEN(&(ap->number), sizeof(ap->number), &mudstate.parent_htab))))
-                {
-                    hashaddLEN(&(ap->number), sizeof(ap->number), &atr, &mudstate.parent_htab);
-                }
-            }
-            atr_pop();
+static size_t cmd_word_key
+(
+    dbref thing,
+    int iType,
+    const UTF8 *word,
+    size_t nWord,
+    UTF8 key[sizeof(dbref) + 1 + CMD_WORD_MAX]
+)
+{
+    memcpy(key, &thing, sizeof(dbref));
+    key[sizeof(dbref)] = static_cast<UTF8>(iType);
+    for (size_t i = 0; i < nWord; i++)
+    {
+        key[sizeof(dbref) + 1 + i] = mux_tolower_ascii(word[i]);
+    }
+    return sizeof(dbref) + 1 + nWord;
+}
+
+// Return the length of the literal first word of a wild() pattern, or 0 if
+// the first word contains wildcards, escapes, or is too long to index.
+//
+static size_t cmd_pattern_word(const UTF8 *pattern)
+{
+    size_t n = 0;
+    while (  '\0' != pattern[n]
+          && ' '  != pattern[n])
+    {
+        if (  '*'  == pattern[n]
+           || '?'  == pattern[n]
+           || '\\' == pattern[n]
+           || CMD_WORD_MAX <= n)
+        {
+            return 0;
         }
-        return match;
+        n++;
     }
+    return n;
+}
 
-    bool bFoundCommands = false;
-    bool bFoundListens  = false;
+void cmdcache_clear(dbref thing)
+{
+    cmdindex_touch(thing);
 
-    atr_push();
-    unsigned char *as;
-    for (int atr = atr_head(parent, &as); atr; atr = atr_next(&as))
+    struct cmd_cache *pcc = db[thing].cmd_cache;
+    if (nullptr == pcc)
     {
-        ATTR *ap = atr_num(atr);
+        return;
+    }
+    db[thing].cmd_cache = nullptr;
 
-        // Never check NOPROG attributes.
-        //
-        if (  !ap
-           || (ap->flags & AF_NOPROG))
+    UTF8 key[sizeof(dbref) + 1 + CMD_WORD_MAX];
+    for (int i = 0; i < pcc->nPatterns; i++)
+    {
+        CMD_PATTERN *pp = &pcc->aPatterns[i];
+        if (0 < pp->nWord)
         {
-            continue;
+            size_t nKey = cmd_word_key(thing, pp->iType, pp->pattern, pp->nWord, key);
+            hashdeleteLEN(key, nKey, &mudstate.cmd_word_htab);
+        }
+        if (nullptr != pp->re)
+        {
+            MEMFREE(pp->re);
         }
+        MEMFREE(pp->pattern);
+    }
+    if (nullptr != pcc->aPatterns)
+    {
+        MEMFREE(pcc->aPatterns);
+    }
+    if (nullptr != pcc->aAttrs)
+    {
+        MEMFREE(pcc->aAttrs);
+    }
+    delete pcc;
+}
 
-        // We need to grab the attribute even before we know whether we'll use
-        // it or not in order to maintain cached knowledge about ^-Commands
-        // and $-Commands.
-        //
+// An attribute on thing is being set to szValue (as stored, with owner and
+// flags) or cleared.  Writes which neither touch a cached pattern nor add one
+// only change the attribute list.
+//
+void cmdcache_changed(dbref thing, int atr, const UTF8 *szValue)
+{
+    struct cmd_cache *pcc = db[thing].cmd_cache;
+    if (nullptr == pcc)
+    {
+        return;
+    }
+
+    bool bPattern = false;
+    if (nullptr != szValue)
+    {
         dbref aowner;
         int   aflags;
-        UTF8 buff[LBUF_SIZE];
-        atr_get_str(buff, parent, atr, &aowner, &aflags);
+        const UTF8 *p = atr_decode_flags_owner(szValue, &aowner, &aflags);
+        bPattern = (  AMATCH_CMD    == p[0]
+                   || AMATCH_LISTEN == p[0]);
+    }
+    for (int i = 0; i < pcc->nPatterns && !bPattern; i++)
+    {
+        bPattern = (atr == pcc->aPatterns[i].atr);
+    }
 
-        UTF8 *s = nullptr;
-        if (  0 == (aflags & AF_NOPROG)
-           &&  (  AMATCH_CMD    == buff[0]
-               || AMATCH_LISTEN == buff[0]))
+    if (bPattern)
+    {
+        cmdcache_clear(thing);
+    }
+    else if (pcc->bAttrs)
+    {
+        if (nullptr != pcc->aAttrs)
         {
-            s = (UTF8 *)strchr((char *)buff+1, ':');
-            if (s)
+            MEMFREE(pcc->aAttrs);
+            pcc->aAttrs = nullptr;
+        }
+        pcc->nAttrs = 0;
+        pcc->bAttrs = false;
+    }
+}
+
+static int cmdcache_count_attrs(dbref thing)
+{
+    int nAttrs = 0;
+    atr_push();
+    unsigned char *as;
+    for (int atr = atr_head(thing, &as); atr; atr = atr_next(&as))
+    {
+        nAttrs++;
+    }
+    atr_pop();
+    return nAttrs;
+}
+
+static struct cmd_cache *cmdcache_load(dbref thing)
+{
+    struct cmd_cache *pcc = db[thing].cmd_cache;
+    if (nullptr != pcc)
+    {
+        return pcc;
+    }
+
+    pcc = new struct cmd_cache;
+    pcc->nPatterns = 0;
+    pcc->aPatterns = nullptr;
+    pcc->bAttrs = false;
+    pcc->nAttrs = 0;
+    pcc->aAttrs = nullptr;
+    for (int i = 0; i < CMD_NUM_TYPES; i++)
+    {
+        pcc->nType[i] = 0;
+        pcc->bWildFirst[i] = false;
+    }
+
+    bool bFoundCommands = false;
+    bool bFoundListens  = false;
+
+    int nAttrs = cmdcache_count_attrs(thing);
+    if (0 < nAttrs)
+    {
+        pcc->aPatterns = (CMD_PATTERN *)MEMALLOC(nAttrs * sizeof(CMD_PATTERN));
+        ISOUTOFMEMORY(pcc->aPatterns);
+
+        UTF8 *buff = alloc_lbuf("cmdcache_load");
+        UTF8 key[sizeof(dbref) + 1 + CMD_WORD_MAX];
+        atr_push();
+        unsigned char *as;
+        for (int atr = atr_head(thing, &as); atr; atr = atr_next(&as))
+        {
+            if (nAttrs <= pcc->nPatterns)
+            {
+                break;
+            }
+
+            ATTR *ap = atr_num(atr);
+            if (nullptr == ap)
+            {
+                continue;
+            }
+
+            dbref aowner;
+            int   aflags;
+            atr_get_str(buff, thing, atr, &aowner, &aflags);
+            if (  (aflags & AF_NOPROG)
+               || (  AMATCH_CMD    != buff[0]
+                  && AMATCH_LISTEN != buff[0]))
+            {
+                continue;
+            }
+
+            UTF8 *s = (UTF8 *)strchr((char *)buff+1, ':');
+            if (nullptr == s)
+            {
+                continue;
+            }
+            *s = '\0';
+
+            CMD_PATTERN *pp = &pcc->aPatterns[pcc->nPatterns++];
+            pp->atr     = atr;
+            pp->aflags  = aflags;
+            pp->iType   = (AMATCH_CMD == buff[0]) ? CMD_TYPE_CMD : CMD_TYPE_LISTEN;
+            pp->pattern = StringCloneLen(buff + 1, s - (buff + 1));
+            pp->re      = nullptr;
+            pp->nWord   = 0;
+            pcc->nType[pp->iType]++;
+
+            if (0 == (ap->flags & AF_NOPROG))
             {
-                if (AMATCH_CMD == buff[0])
+                if (CMD_TYPE_CMD == pp->iType)
                 {
                     bFoundCommands = true;
                 }
@@ -259,96 +502,306 @@ static int atr_match1
                     bFoundListens = true;
                 }
             }
-        }
 
-        // If we aren't the bottom level, check if we saw this attr
-        // before. Also exclude it if the attribute type is PRIVATE.
-        //
-        if (  check_exclude
-           && (  (ap->flags & AF_PRIVATE)
-              || (aflags & AF_PRIVATE)
-              || hashfindLEN(&(ap->number), sizeof(ap->number), &mudstate.parent_htab)))
-        {
-            continue;
+            if (aflags & AF_REGEXP)
+            {
+                // A pattern which does not compile never matches.
+                //
+                const char *errptr;
+                int erroffset;
+                pp->re = pcre_compile((char *)pp->pattern,
+                    PCRE_UTF8 | ((aflags & AF_CASE) ? 0 : PCRE_CASELESS),
+                    &errptr, &erroffset, nullptr);
+                pcc->bWildFirst[pp->iType] = true;
+            }
+            else
+            {
+                pp->nWord = cmd_pattern_word(pp->pattern);
+                if (0 < pp->nWord)
+                {
+                    // Patterns on the same object may share a word, but the
+                    // key is only added once.
+                    //
+                    size_t nKey = cmd_word_key(thing, pp->iType, pp->pattern, pp->nWord, key);
+                    if (nullptr == hashfindLEN(key, nKey, &mudstate.cmd_word_htab))
+                    {
+                        hashaddLEN(key, nKey, pcc, &mudstate.cmd_word_htab);
+                    }
+                }
+                else
+                {
+                    pcc->bWildFirst[pp->iType] = true;
+                }
+            }
         }
+        atr_pop();
+        free_lbuf(buff);
+    }
+    db[thing].cmd_cache = pcc;
 
-        // If we aren't the top level, remember this attr so we
-        // exclude it from now on.
-        //
-        if (hash_insert)
+    if (bFoundCommands)
+    {
+        mudstate.bfNoCommands.Clear(thing);
+        mudstate.bfCommands.Set(thing);
+    }
+    else
+    {
+        mudstate.bfCommands.Clear(thing);
+        mudstate.bfNoCommands.Set(thing);
+    }
+
+    if (bFoundListens)
+    {
+        mudstate.bfNoListens.Clear(thing);
+        mudstate.bfListens.Set(thing);
+    }
+    else
+    {
+        mudstate.bfListens.Clear(thing);
+        mudstate.bfNoListens.Set(thing);
+    }
+    return pcc;
+}
+
+static void cmdcache_load_attrs(dbref thing, struct cmd_cache *pcc)
+{
+    if (pcc->bAttrs)
+    {
+        return;
+    }
+    pcc->bAttrs = true;
+
+    int nAttrs = cmdcache_count_attrs(thing);
+    if (0 == nAttrs)
+    {
+        return;
+    }
+
+    pcc->aAttrs = (CMD_ATTR *)MEMALLOC(nAttrs * sizeof(CMD_ATTR));
+    ISOUTOFMEMORY(pcc->aAttrs);
+
+    atr_push();
+    unsigned char *as;
+    for (int atr = atr_head(thing, &as); atr && pcc->nAttrs < nAttrs; atr = atr_next(&as))
+    {
+        dbref aowner;
+        int   aflags;
+        if (atr_get_info(thing, atr, &aowner, &aflags))
         {
-            hashaddLEN(&(ap->number), sizeof(ap->number), &atr, &mudstate.parent_htab);
+            pcc->aAttrs[pcc->nAttrs].atr    = atr;
+            pcc->aAttrs[pcc->nAttrs].aflags = aflags;
+            pcc->nAttrs++;
         }
+    }
+    atr_pop();
+}
 
-        if (aflags & AF_NOPROG)
+// Does the first word of the subject appear among the object's literal
+// first words?
+//
+static bool cmdcache_has_word(dbref thing, int iType, CMD_SUBJECT *pcs)
+{
+    UTF8 key[sizeof(dbref) + 1 + CMD_WORD_MAX];
+    size_t nKey;
+    if (0 < pcs->nWord)
+    {
+        nKey = cmd_word_key(thing, iType, pcs->word, pcs->nWord, key);
+        if (nullptr != hashfindLEN(key, nKey, &mudstate.cmd_word_htab))
         {
-            continue;
+            return true;
         }
+    }
 
-        // Check for the leadin character after excluding the attrib.
-        // This lets non-command attribs on the child block commands
-        // on the parent.
-        //
-        if (buff[0] != type)
+    if (  0 < pcs->nRawWord
+       && (  pcs->nRawWord != pcs->nWord
+          || memcmp(pcs->raw_word, pcs->word, pcs->nWord) != 0))
+    {
+        nKey = cmd_word_key(thing, iType, pcs->raw_word, pcs->nRawWord, key);
+        if (nullptr != hashfindLEN(key, nKey, &mudstate.cmd_word_htab))
         {
-            continue;
+            return true;
         }
+    }
+    return false;
+}
 
-        // Was there a ':'?
-        //
-        if (!s)
+// Could any pattern of this type on the object match the subject?
+//
+static bool cmdcache_candidate(dbref thing, int iType, CMD_SUBJECT *pcs)
+{
+    struct cmd_cache *pcc = cmdcache_load(thing);
+    return (  0 < pcc->nType[iType]
+           && (  pcc->bWildFirst[iType]
+              || cmdcache_has_word(thing, iType, pcs)));
+}
+
+// Is the attribute excluded from matching on a parent, either because it is
+// private or because a child already has it?
+//
+static bool cmd_excluded(ATTR *ap, int aflags)
+{
+    return (  (ap->flags & AF_PRIVATE)
+           || (aflags & AF_PRIVATE)
+           || hashfindLEN(&(ap->number), sizeof(ap->number), &mudstate.parent_htab));
+}
+
+/* ----------------------------------------------------------------------
+ * atr_match: Check attribute list for wild card matches and queue them.
+ */
+
+static int atr_match1
+(
+    dbref thing,
+    dbref parent,
+    dbref player,
+    UTF8  type,
+    CMD_SUBJECT *pcs,
+    int   check_exclude,
+    int   hash_insert
+)
+{
+    // See if we can do it.  Silently fail if we can't.
+    //
+    if (!could_doit(player, parent, A_LUSE))
+    {
+        return -1;
+    }
+
+    struct cmd_cache *pcc = cmdcache_load(parent);
+    if (  check_exclude
+       || hash_insert)
+    {
+        cmdcache_load_attrs(parent, pcc);
+    }
+
+    int match = 0;
+    int iType = (AMATCH_CMD == type) ? CMD_TYPE_CMD : CMD_TYPE_LISTEN;
+    if (cmdcache_candidate(parent, iType, pcs))
+    {
+        UTF8 *buff = nullptr;
+        for (int i = 0; i < pcc->nPatterns; i++)
         {
-            continue;
-        }
-        *s++ = '\0';
+            CMD_PATTERN *pp = &pcc->aPatterns[i];
+            if (iType != pp->iType)
+            {
+                continue;
+            }
 
-        UTF8 *args[NUM_ENV_VARS];
-        if (  (  0 != (aflags & AF_REGEXP)
-            && regexp_match(buff + 1, (aflags & AF_NOPARSE) ? raw_str : str,
-                ((aflags & AF_CASE) ? 0 : PCRE_CASELESS), args, NUM_ENV_VARS))
-           || (  0 == (aflags & AF_REGEXP)
-              && wild(buff + 1, (aflags & AF_NOPARSE) ? raw_str : str,
-                args, NUM_ENV_VARS)))
-        {
-            match = 1;
-            CLinearTimeAbsolute lta;
-            wait_que(thing, player, player, AttrTrace(aflags, 0), false, lta,
-                NOTHING, 0,
-                s,
-                NUM_ENV_VARS, (const UTF8 **)args,
-                mudstate.global_regs);
-
-            for (int i = 0; i < NUM_ENV_VARS; i++)
-            {
-                if (args[i])
+            // Never check NOPROG attributes.
+            //
+            ATTR *ap = atr_num(pp->atr);
+            if (  nullptr == ap
+               || (ap->flags & AF_NOPROG))
+            {
+                continue;
+            }
+
+            // If we aren't the bottom level, check if we saw this attr
+            // before. Also exclude it if the attribute type is PRIVATE.
+            //
+            if (  check_exclude
+               && cmd_excluded(ap, pp->aflags))
+            {
+                continue;
+            }
+
+            UTF8 *str;
+            if (pp->aflags & AF_NOPARSE)
+            {
+                str = pcs->raw_str;
+                if (  0 < pp->nWord
+                   && (  pp->nWord != pcs->nRawWord
+                      || !string_prefix(pp->pattern, pcs->raw_word)))
                 {
-                    free_lbuf(args[i]);
+                    continue;
+                }
+            }
+            else
+            {
+                str = pcs->str;
+                if (  0 < pp->nWord
+                   && (  pp->nWord != pcs->nWord
+                      || !string_prefix(pp->pattern, pcs->word)))
+                {
+                    continue;
+                }
+            }
+
+            UTF8 *args[NUM_ENV_VARS];
+            if (  (  nullptr != pp->re
+                  && !alarm_clock.alarmed
+                  && regexp_exec(pp->re, str, args, NUM_ENV_VARS))
+               || (  0 == (pp->aflags & AF_REGEXP)
+                  && wild(pp->pattern, str, args, NUM_ENV_VARS)))
+            {
+                // Only the pattern is cached.  The action is fetched when it
+                // is needed.
+                //
+                if (nullptr == buff)
+                {
+                    buff = alloc_lbuf("atr_match1");
+                }
+                dbref aowner;
+                int   aflags;
+                atr_get_str(buff, parent, pp->atr, &aowner, &aflags);
+                UTF8 *s = (UTF8 *)strchr((char *)buff+1, ':');
+                if (s)
+                {
+                    match = 1;
+
+                    // Remember which attribute queued the action, so its
+                    // latency can be charged to it.
+                    //
+                    dbref src_thing = mudstate.que_src_thing;
+                    int   src_atr   = mudstate.que_src_atr;
+                    mudstate.que_src_thing = parent;
+                    mudstate.que_src_atr   = pp->atr;
+
+                    CLinearTimeAbsolute lta;
+                    wait_que(thing, player, player, AttrTrace(pp->aflags, 0), false, lta,
+                        NOTHING, 0,
+                        s + 1,
+                        NUM_ENV_VARS, (const UTF8 **)args,
+                        mudstate.global_regs);
+
+                    mudstate.que_src_thing = src_thing;
+                    mudstate.que_src_atr   = src_atr;
+                }
+
+                for (int j = 0; j < NUM_ENV_VARS; j++)
+                {
+                    if (args[j])
+                    {
+                        free_lbuf(args[j]);
+                    }
                 }
             }
         }
-    }
-    atr_pop();
 
-    if (bFoundCommands)
-    {
-        mudstate.bfNoCommands.Clear(parent);
-        mudstate.bfCommands.Set(parent);
-    }
-    else
-    {
-        mudstate.bfCommands.Clear(parent);
-        mudstate.bfNoCommands.Set(parent);
+        if (nullptr != buff)
+        {
+            free_lbuf(buff);
+        }
     }
 
-    if (bFoundListens)
-    {
-        mudstate.bfNoListens.Clear(parent);
-        mudstate.bfListens.Set(parent);
-    }
-    else
+    // If we aren't the top level, remember this level's attrs so we exclude
+    // them from now on.  This lets non-command attribs on the child block
+    // commands on the parent.
+    //
+    if (hash_insert)
     {
-        mudstate.bfListens.Clear(parent);
-        mudstate.bfNoListens.Set(parent);
+        for (int i = 0; i < pcc->nAttrs; i++)
+        {
+            ATTR *ap = atr_num(pcc->aAttrs[i].atr);
+            if (  nullptr == ap
+               || (ap->flags & AF_NOPROG)
+               || (  check_exclude
+                  && cmd_excluded(ap, pcc->aAttrs[i].aflags)))
+            {
+                continue;
+            }
+            hashaddLEN(&(ap->number), sizeof(ap->number), &pcc->aAttrs[i], &mudstate.parent_htab);
+        }
     }
     return match;
 }
@@ -387,12 +840,41 @@ bool atr_match
         str = strip_color(str);
     }
 
+    CMD_SUBJECT cs;
+    cs.str      = str;
+    cs.raw_str  = raw_str;
+    cs.nWord    = cmd_first_word(str, cs.word);
+    cs.nRawWord = cmd_first_word(raw_str, cs.raw_word);
+    int iType = (AMATCH_CMD == type) ? CMD_TYPE_CMD : CMD_TYPE_LISTEN;
+
     // If not checking parents, just check the thing
     //
     bool match = false;
     if (!check_parents)
     {
-        return (atr_match1(thing, thing, player, type, str, raw_str, false, false) > 0);
+        if (!cmdcache_candidate(thing, iType, &cs))
+        {
+            return false;
+        }
+        return (atr_match1(thing, thing, player, type, &cs, false, false) > 0);
+    }
+
+    // Most objects have nothing which could match.  Rule them out with one
+    // lookup per level before evaluating locks or excluding attributes.
+    //
+    bool bCandidate = false;
+    ITER_PARENTS(thing, parent, lev)
+    {
+        if (cmdcache_candidate(parent, iType, &cs))
+        {
+            bCandidate = true;
+            break;
+        }
+    }
+
+    if (!bCandidate)
+    {
+        return false;
     }
 
     // Check parents, ignoring halted objects
@@ -406,8 +888,7 @@ bool atr_match
         {
             insert = false;
         }
-        result = atr_match1(thing, parent, player, type, str, raw_str,
-            exclude, insert);
+        result = atr_match1(thing, parent, player, type, &cs, exclude, insert);
         if (result > 0)
         {
             match = true;
@@ -421,21 +902,330 @@ bool atr_match
     return match;
 }
 
+/* ----------------------------------------------------------------------
+ * Room command indexes.
+ *
+ * When nothing nearer matches, a command is tried against every object in
+ * the master room, and against every object in a parent room zone.  Large
+ * games keep hundreds of objects there, so each room which is searched this
+ * way keeps an index from the literal first words of its objects' $-commands
+ * to their positions in the contents list.  Objects with wild-first or
+ * regexp $-commands, and objects with parents, are always tried.  Only the
+ * objects which could match are handed to atr_match().
+ *
+ * The index is dropped when the room's contents change, or when one of its
+ * objects changes an attribute or its parent.
+ */
+
+typedef struct cmd_index_word
+{
+    size_t nKey;
+    UTF8   key[sizeof(dbref) + 1 + CMD_WORD_MAX];
+    int    nPos;
+    int   *aPos;            // Positions in aObjects, in ascending order.
+} CMD_INDEX_WORD;
+
+typedef struct cmd_index
+{
+    dbref  room;
+    bool   bParents;        // Built for matching with parents.
+    int    nObjects;
+    dbref *aObjects;        // Contents of the room in order.
+    int    nFallback;
+    int   *aFallback;       // Positions which are always tried.
+    int    nWords;
+    CMD_INDEX_WORD *aWords;
+} CMD_INDEX;
+
+typedef struct cmd_index_entry
+{
+    int          pos;
+    CMD_PATTERN *pp;
+} CMD_INDEX_ENTRY;
+
+// Compare the literal first words of two patterns without regard to ASCII
+// case.
+//
+static int cmd_word_compare(const CMD_PATTERN *pa, const CMD_PATTERN *pb)
+{
+    size_t n = (pa->nWord < pb->nWord) ? pa->nWord : pb->nWord;
+    for (size_t i = 0; i < n; i++)
+    {
+        int ca = mux_tolower_ascii(pa->pattern[i]);
+        int cb = mux_tolower_ascii(pb->pattern[i]);
+        if (ca != cb)
+        {
+            return ca - cb;
+        }
+    }
+    if (pa->nWord != pb->nWord)
+    {
+        return (pa->nWord < pb->nWord) ? -1 : 1;
+    }
+    return 0;
+}
+
+static int cmdindex_compare(const void *a, const void *b)
+{
+    const CMD_INDEX_ENTRY *pa = (const CMD_INDEX_ENTRY *)a;
+    const CMD_INDEX_ENTRY *pb = (const CMD_INDEX_ENTRY *)b;
+    int cmp = cmd_word_compare(pa->pp, pb->pp);
+    if (0 != cmp)
+    {
+        return cmp;
+    }
+    return pa->pos - pb->pos;
+}
+
+void cmdindex_drop(dbref room)
+{
+    if (  !Good_dbref(room)
+       || !mudstate.bfCmdIndex.IsSet(room))
+    {
+        return;
+    }
+    mudstate.bfCmdIndex.Clear(room);
+
+    CMD_INDEX *pci = (CMD_INDEX *)hashfindLEN(&room, sizeof(room), &mudstate.cmd_index_htab);
+    if (nullptr == pci)
+    {
+        return;
+    }
+    hashdeleteLEN(&room, sizeof(room), &mudstate.cmd_index_htab);
+
+    for (int i = 0; i < pci->nWords; i++)
+    {
+        hashdeleteLEN(pci->aWords[i].key, pci->aWords[i].nKey, &mudstate.cmd_word_htab);
+        MEMFREE(pci->aWords[i].aPos);
+    }
+    if (nullptr != pci->aWords)
+    {
+        MEMFREE(pci->aWords);
+    }
+    if (nullptr != pci->aObjects)
+    {
+        MEMFREE(pci->aObjects);
+    }
+    if (nullptr != pci->aFallback)
+    {
+        MEMFREE(pci->aFallback);
+    }
+    delete pci;
+}
+
+void cmdindex_drop_all(void)
+{
+    CMD_INDEX *pci;
+    while (nullptr != (pci = (CMD_INDEX *)hash_firstentry(&mudstate.cmd_index_htab)))
+    {
+        cmdindex_drop(pci->room);
+    }
+}
+
+// The $-commands, parent, or location of thing may have changed.
+//
+void cmdindex_touch(dbref thing)
+{
+    if (Good_obj(thing))
+    {
+        cmdindex_drop(Location(thing));
+    }
+}
+
+static CMD_INDEX *cmdindex_load(dbref room, bool bParents)
+{
+    CMD_INDEX *pci = nullptr;
+    if (mudstate.bfCmdIndex.IsSet(room))
+    {
+        pci = (CMD_INDEX *)hashfindLEN(&room, sizeof(room), &mudstate.cmd_index_htab);
+        if (  nullptr != pci
+           && pci->bParents == bParents)
+        {
+            return pci;
+        }
+        cmdindex_drop(room);
+    }
+
+    pci = new CMD_INDEX;
+    pci->room      = room;
+    pci->bParents  = bParents;
+    pci->nObjects  = 0;
+    pci->aObjects  = nullptr;
+    pci->nFallback = 0;
+    pci->aFallback = nullptr;
+    pci->nWords    = 0;
+    pci->aWords    = nullptr;
+
+    // Walk the contents the same way list_check() does.
+    //
+    int nObjects = 0;
+    int limit = mudstate.db_top;
+    dbref thing;
+    for (thing = Contents(room); NOTHING != thing; thing = Next(thing))
+    {
+        nObjects++;
+        if (  thing == Next(thing)
+           || --limit < 0)
+        {
+            break;
+        }
+    }
+
+    int nEntries = 0;
+    CMD_INDEX_ENTRY *aEntries = nullptr;
+    if (0 < nObjects)
+    {
+        pci->aObjects  = (dbref *)MEMALLOC(nObjects * sizeof(dbref));
+        ISOUTOFMEMORY(pci->aObjects);
+        pci->aFallback = (int *)MEMALLOC(nObjects * sizeof(int));
+        ISOUTOFMEMORY(pci->aFallback);
+
+        // First pass to size the entries.
+        //
+        int nPatterns = 0;
+        thing = Contents(room);
+        for (int pos = 0; pos < nObjects; pos++, thing = Next(thing))
+        {
+            pci->aObjects[pos] = thing;
+            if (Good_obj(thing))
+            {
+                nPatterns += cmdcache_load(thing)->nType[CMD_TYPE_CMD];
+            }
+        }
+        pci->nObjects = nObjects;
+
+        if (0 < nPatterns)
+        {
+            aEntries = (CMD_INDEX_ENTRY *)MEMALLOC(nPatterns * sizeof(CMD_INDEX_ENTRY));
+            ISOUTOFMEMORY(aEntries);
+        }
+
+        for (int pos = 0; pos < nObjects; pos++)
+        {
+            thing = pci->aObjects[pos];
+            if (!Good_obj(thing))
+            {
+                continue;
+            }
+
+            struct cmd_cache *pcc = cmdcache_load(thing);
+            if (  (  bParents
+                  && Good_obj(Parent(thing)))
+               || pcc->bWildFirst[CMD_TYPE_CMD])
+            {
+                pci->aFallback[pci->nFallback++] = pos;
+                continue;
+            }
+
+            for (int i = 0; i < pcc->nPatterns; i++)
+            {
+                CMD_PATTERN *pp = &pcc->aPatterns[i];
+                if (  CMD_TYPE_CMD == pp->iType
+                   && 0 < pp->nWord
+                   && nEntries < nPatterns)
+                {
+                    aEntries[nEntries].pos = pos;
+                    aEntries[nEntries].pp  = pp;
+                    nEntries++;
+                }
+            }
+        }
+    }
+
+    // Group the entries by word.
+    //
+    if (0 < nEntries)
+    {
+        qsort(aEntries, nEntries, sizeof(CMD_INDEX_ENTRY), cmdindex_compare);
+
+        pci->aWords = (CMD_INDEX_WORD *)MEMALLOC(nEntries * sizeof(CMD_INDEX_WORD));
+        ISOUTOFMEMORY(pci->aWords);
+
+        int i = 0;
+        while (i < nEntries)
+        {
+            int j = i + 1;
+            while (  j < nEntries
+                  && 0 == cmd_word_compare(aEntries[i].pp, aEntries[j].pp))
+            {
+                j++;
+            }
+
+            CMD_INDEX_WORD *pw = &pci->aWords[pci->nWords++];
+            pw->nKey = cmd_word_key(room, CMD_TYPE_ROOM, aEntries[i].pp->pattern,
+                aEntries[i].pp->nWord, pw->key);
+            pw->nPos = 0;
+            pw->aPos = (int *)MEMALLOC((j - i) * sizeof(int));
+            ISOUTOFMEMORY(pw->aPos);
+            for (int k = i; k < j; k++)
+            {
+                if (  0 == pw->nPos
+                   || pw->aPos[pw->nPos - 1] != aEntries[k].pos)
+                {
+                    pw->aPos[pw->nPos++] = aEntries[k].pos;
+                }
+            }
+            hashaddLEN(pw->key, pw->nKey, pw, &mudstate.cmd_word_htab);
+            i = j;
+        }
+        MEMFREE(aEntries);
+    }
+    else if (nullptr != aEntries)
+    {
+        MEMFREE(aEntries);
+    }
+
+    hashaddLEN(&room, sizeof(room), pci, &mudstate.cmd_index_htab);
+    mudstate.bfCmdIndex.Set(room);
+    return pci;
+}
+
+static const CMD_INDEX_WORD *cmdindex_find(dbref room, const UTF8 *word, size_t nWord)
+{
+    if (0 == nWord)
+    {
+        return nullptr;
+    }
+    UTF8 key[sizeof(dbref) + 1 + CMD_WORD_MAX];
+    size_t nKey = cmd_word_key(room, CMD_TYPE_ROOM, word, nWord, key);
+    return (const CMD_INDEX_WORD *)hashfindLEN(key, nKey, &mudstate.cmd_word_htab);
+}
+
 /* ---------------------------------------------------------------------------
  * notify_check: notifies the object #target of the message msg, and
  * optionally notify the contents, neighbors, and location also.
  */
 
-static bool check_filter(dbref object, dbref player, int filter, const UTF8 *msg)
+// The plain-text form of the message is only needed for @listen, @filter
+// and ^-listen checks, so it is made the first time one of them asks.
+//
+static UTF8 *notify_plain(const mux_string &msg, UTF8 **pmsgPlain)
+{
+    if (nullptr == *pmsgPlain)
+    {
+        *pmsgPlain = alloc_lbuf("notify_check.plain");
+        msg.export_TextPlain(*pmsgPlain);
+    }
+    return *pmsgPlain;
+}
+
+static bool check_filter(dbref object, dbref player, int filter,
+    const mux_string &sMsg, UTF8 **pmsgPlain)
 {
     int aflags;
     dbref aowner;
+    if (!atr_pget_info(object, filter, &aowner, &aflags))
+    {
+        return true;
+    }
+
     UTF8 *buf = atr_pget(object, filter, &aowner, &aflags);
     if (!*buf)
     {
         free_lbuf(buf);
         return true;
     }
+    const UTF8 *msg = notify_plain(sMsg, pmsgPlain);
 
     reg_ref **preserve = nullptr;
     preserve = PushRegisters(MAX_GLOBAL_REGS);
@@ -610,6 +1400,48 @@ bool html_escape(const UTF8 *src, UTF8 *dest, UTF8 **destp)
     return ret;
 }
 
+// notify_check() keeps its working strings here, one set for each level of
+// notification nesting, so that delivering a message to a crowd does not
+// construct and destroy a pair of mux_strings for every listener.  Levels
+// beyond the table (only possible with a large notify_recursion_limit) fall
+// back to the heap.
+//
+#define NOTIFY_SCRATCH_LEVELS   32
+
+#define NOTIFY_SCRATCH_NOSPOOF  0   // Message with the NOSPOOF tag.
+#define NOTIFY_SCRATCH_FINAL    1   // Message with a prefix.
+#define NOTIFY_SCRATCH_DISTANT  2   // Message passing through an exit.
+#define NOTIFY_SCRATCH_MESSAGE  3   // Message given to notify_check() as text.
+#define NOTIFY_SCRATCH_SLOTS    4
+
+static mux_string *notify_scratch[NOTIFY_SCRATCH_LEVELS][NOTIFY_SCRATCH_SLOTS];
+
+static mux_string *notify_scratch_get(int iLevel, int iSlot)
+{
+    if (  iLevel < 0
+       || NOTIFY_SCRATCH_LEVELS <= iLevel)
+    {
+        return new mux_string;
+    }
+
+    mux_string *sStr = notify_scratch[iLevel][iSlot];
+    if (nullptr == sStr)
+    {
+        sStr = new mux_string;
+        notify_scratch[iLevel][iSlot] = sStr;
+    }
+    return sStr;
+}
+
+static void notify_scratch_put(int iLevel, mux_string *sStr)
+{
+    if (  iLevel < 0
+       || NOTIFY_SCRATCH_LEVELS <= iLevel)
+    {
+        delete sStr;
+    }
+}
+
 void notify_check(dbref target, dbref sender, const mux_string &msg, int key)
 {
     // If speaker is invalid or message is empty, just exit.
@@ -649,8 +1481,10 @@ void notify_check(dbref target, dbref sender, const mux_string &msg, int key)
         return;
     }
 
-    mux_string *msg_ns = new mux_string;
-    mux_string *msgFinal = new mux_string;
+    int iLevel = mudstate.ntfy_nest_lev;
+    const mux_string *msg_ns = &msg;
+    mux_string *msgNoSpoof = nullptr;
+    mux_string *msgFinal = nullptr;
     UTF8 *tp;
     UTF8 *prefix;
     dbref aowner,  recip, obj;
@@ -671,56 +1505,59 @@ void notify_check(dbref target, dbref sender, const mux_string &msg, int key)
             // caller may have.  notify(target, tprintf(...)) is quite common
             // in the code.
             //
-            msg_ns->import(T("["), 1);
-            msg_ns->append(Moniker(sender));
-            msg_ns->append_TextPlain(T("("), 1);
-            msg_ns->append(sender);
-            msg_ns->append_TextPlain(T(")"), 1);
+            msgNoSpoof = notify_scratch_get(iLevel, NOTIFY_SCRATCH_NOSPOOF);
+            msgNoSpoof->import(T("["), 1);
+            msgNoSpoof->append(Moniker(sender));
+            msgNoSpoof->append_TextPlain(T("("), 1);
+            msgNoSpoof->append(sender);
+            msgNoSpoof->append_TextPlain(T(")"), 1);
 
             if (sender != Owner(sender))
             {
-                msg_ns->append_TextPlain(T("{"), 1);
-                msg_ns->append(Moniker(Owner(sender)));
-                msg_ns->append_TextPlain(T("}"), 1);
+                msgNoSpoof->append_TextPlain(T("{"), 1);
+                msgNoSpoof->append(Moniker(Owner(sender)));
+                msgNoSpoof->append_TextPlain(T("}"), 1);
             }
 
             if (sender != mudstate.curr_enactor)
             {
-                msg_ns->append_TextPlain(T("<-("), 3);
-                msg_ns->append(mudstate.curr_enactor);
-                msg_ns->append_TextPlain(T(")"), 1);
+                msgNoSpoof->append_TextPlain(T("<-("), 3);
+                msgNoSpoof->append(mudstate.curr_enactor);
+                msgNoSpoof->append_TextPlain(T(")"), 1);
             }
 
             switch (DecodeMsgSource(key))
             {
             case MSG_SRC_COMSYS:
-                msg_ns->append_TextPlain(T(",comsys"));
+                msgNoSpoof->append_TextPlain(T(",comsys"));
                 break;
 
             case MSG_SRC_KILL:
-                msg_ns->append_TextPlain(T(",kill"));
+                msgNoSpoof->append_TextPlain(T(",kill"));
                 break;
 
             case MSG_SRC_GIVE:
-                msg_ns->append_TextPlain(T(",give"));
+                msgNoSpoof->append_TextPlain(T(",give"));
                 break;
 
             case MSG_SRC_PAGE:
-                msg_ns->append_TextPlain(T(",page"));
+                msgNoSpoof->append_TextPlain(T(",page"));
                 break;
 
             default:
                 if (key & MSG_SAYPOSE)
                 {
-                    msg_ns->append_TextPlain(T(",saypose"));
+                    msgNoSpoof->append_TextPlain(T(",saypose"));
                 }
                 break;
             }
 
-            msg_ns->append_TextPlain(T("] "), 2);
+            msgNoSpoof->append_TextPlain(T("] "), 2);
+            msgNoSpoof->append(msg);
+            msg_ns = msgNoSpoof;
         }
     }
-    msg_ns->append(msg);
+    msgFinal = notify_scratch_get(iLevel, NOTIFY_SCRATCH_FINAL);
 
     // msg contains the raw message, msg_ns contains the NOSPOOFed msg.
     //
@@ -734,15 +1571,16 @@ void notify_check(dbref target, dbref sender, const mux_string &msg, int key)
             {
                 raw_notify_html(target, *msg_ns);
             }
-            else
+            else if (Html(target))
             {
                 msgFinal->import(*msg_ns);
-                if (Html(target))
-                {
-                    msgFinal->encode_Html();
-                }
+                msgFinal->encode_Html();
                 raw_notify(target, *msgFinal);
             }
+            else
+            {
+                raw_notify(target, *msg_ns);
+            }
         }
         if (!mudconf.player_listen)
         {
@@ -785,8 +1623,7 @@ void notify_check(dbref target, dbref sender, const mux_string &msg, int key)
 
         // Check for @Listen match if it will be useful.
         //
-        UTF8 *msgPlain = alloc_lbuf("notify_check.plain");
-        msg.export_TextPlain(msgPlain);
+        UTF8 *msgPlain = nullptr;
         bool pass_listen = false;
         UTF8 *args[NUM_ENV_VARS];
         nargs = 0;
@@ -795,7 +1632,7 @@ void notify_check(dbref target, dbref sender, const mux_string &msg, int key)
            && H_Listen(target))
         {
             tp = atr_get("notify_check.790", target, A_LISTEN, &aowner, &aflags);
-            if (*tp && wild(tp, msgPlain, args, NUM_ENV_VARS))
+            if (*tp && wild(tp, notify_plain(msg, &msgPlain), args, NUM_ENV_VARS))
             {
                 for (nargs = NUM_ENV_VARS; nargs && (!args[nargs - 1] || !(*args[nargs - 1])); nargs--)
                 {
@@ -861,6 +1698,7 @@ void notify_check(dbref target, dbref sender, const mux_string &msg, int key)
            && sender != target
            && Monitor(target))
         {
+            notify_plain(msg, &msgPlain);
             atr_match(target, sender, AMATCH_LISTEN, msgPlain, msgPlain, false);
         }
 
@@ -868,7 +1706,7 @@ void notify_check(dbref target, dbref sender, const mux_string &msg, int key)
         //
         if ( (key & MSG_FWDLIST)
            && is_audible
-           && check_filter(target, sender, A_FILTER, msgPlain))
+           && check_filter(target, sender, A_FILTER, msg, &msgPlain))
         {
             fp = fwdlist_get(target);
             if (nullptr != fp)
@@ -901,7 +1739,7 @@ void notify_check(dbref target, dbref sender, const mux_string &msg, int key)
                 recip = Location(obj);
                 if (  Audible(obj)
                    && (  recip != target
-                      && check_filter(obj, sender, A_FILTER, msgPlain)))
+                      && check_filter(obj, sender, A_FILTER, msg, &msgPlain)))
                 {
                     prefix = make_prefix(obj, target, A_PREFIX, T("From a distance,"));
                     msgFinal->import(prefix);
@@ -937,7 +1775,7 @@ void notify_check(dbref target, dbref sender, const mux_string &msg, int key)
                 msgFinal->import(msg);
             }
 
-            mux_string *msgPrefixed2 = new mux_string;
+            mux_string *msgPrefixed2 = notify_scratch_get(iLevel, NOTIFY_SCRATCH_DISTANT);
 
             DOLIST(obj, Exits(Location(target)))
             {
@@ -946,7 +1784,7 @@ void notify_check(dbref target, dbref sender, const mux_string &msg, int key)
                    && Audible(obj)
                    && recip != targetloc
                    && recip != target
-                   && check_filter(obj, sender, A_FILTER, msgPlain))
+                   && check_filter(obj, sender, A_FILTER, msg, &msgPlain))
                 {
                     prefix = make_prefix(obj, target, A_PREFIX, T("From a distance,"));
                     msgPrefixed2->import(prefix);
@@ -957,7 +1795,7 @@ void notify_check(dbref target, dbref sender, const mux_string &msg, int key)
                         MSG_ME | MSG_F_UP | MSG_F_CONTENTS | MSG_S_INSIDE | (key & (MSG_SRC_MASK | MSG_SAYPOSE | MSG_OOC)));
                 }
             }
-            delete msgPrefixed2;
+            notify_scratch_put(iLevel, msgPrefixed2);
         }
 
         // Deliver message to contents.
@@ -965,7 +1803,7 @@ void notify_check(dbref target, dbref sender, const mux_string &msg, int key)
         if (  (  (key & MSG_INV)
               || (  (key & MSG_INV_L)
                  && pass_listen))
-           && check_filter(target, sender, A_INFILTER, msgPlain))
+           && check_filter(target, sender, A_INFILTER, msg, &msgPlain))
         {
             // Don't prefix the message if we were given the MSG_NOPREFIX key.
             //
@@ -982,14 +1820,17 @@ void notify_check(dbref target, dbref sender, const mux_string &msg, int key)
                 msgFinal->import(msg);
             }
 
-            DOLIST(obj, Contents(target))
+            int keyInv = MSG_ME | MSG_F_DOWN | MSG_S_OUTSIDE | (key & (MSG_HTML | MSG_SRC_MASK | MSG_SAYPOSE | MSG_OOC));
+            HEAR_LIST *phl = hearlist_acquire(target, keyInv);
+            for (i = 0; i < phl->nHearers; i++)
             {
+                obj = phl->aHearers[i];
                 if (obj != target)
                 {
-                    notify_check(obj, sender, *msgFinal,
-                        MSG_ME | MSG_F_DOWN | MSG_S_OUTSIDE | (key & (MSG_HTML | MSG_SRC_MASK | MSG_SAYPOSE | MSG_OOC)));
+                    notify_check(obj, sender, *msgFinal, keyInv);
                 }
             }
+            hearlist_release(phl);
         }
 
         // Deliver message to neighbors.
@@ -998,7 +1839,7 @@ void notify_check(dbref target, dbref sender, const mux_string &msg, int key)
            && (  (key & MSG_NBR)
               || (  (key & MSG_NBR_A)
                  && is_audible
-                 && check_filter(target, sender, A_FILTER, msgPlain))))
+                 && check_filter(target, sender, A_FILTER, msg, &msgPlain))))
         {
             if (key & MSG_S_INSIDE)
             {
@@ -1013,15 +1854,18 @@ void notify_check(dbref target, dbref sender, const mux_string &msg, int key)
                 msgFinal->import(msg);
             }
 
-            DOLIST(obj, Contents(targetloc))
+            int keyNbr = MSG_ME | MSG_F_DOWN | MSG_S_OUTSIDE | (key & (MSG_SRC_MASK | MSG_SAYPOSE | MSG_OOC));
+            HEAR_LIST *phl = hearlist_acquire(targetloc, keyNbr);
+            for (i = 0; i < phl->nHearers; i++)
             {
+                obj = phl->aHearers[i];
                 if (  obj != target
                    && obj != targetloc)
                 {
-                    notify_check(obj, sender, *msgFinal,
-                        MSG_ME | MSG_F_DOWN | MSG_S_OUTSIDE | (key & (MSG_SRC_MASK | MSG_SAYPOSE | MSG_OOC)));
+                    notify_check(obj, sender, *msgFinal, keyNbr);
                 }
             }
+            hearlist_release(phl);
         }
 
         // Deliver message to container.
@@ -1030,7 +1874,7 @@ void notify_check(dbref target, dbref sender, const mux_string &msg, int key)
            && (  (key & MSG_LOC)
               || ( (key & MSG_LOC_A)
                  && is_audible
-                 && check_filter(target, sender, A_FILTER, msgPlain))))
+                 && check_filter(target, sender, A_FILTER, msg, &msgPlain))))
         {
             if (key & MSG_S_INSIDE)
             {
@@ -1047,10 +1891,16 @@ void notify_check(dbref target, dbref sender, const mux_string &msg, int key)
             notify_check(targetloc, sender, *msgFinal,
                 MSG_ME | MSG_F_UP | MSG_S_INSIDE | (key & (MSG_SRC_MASK | MSG_SAYPOSE | MSG_OOC)));
         }
-        free_lbuf(msgPlain);
+        if (nullptr != msgPlain)
+        {
+            free_lbuf(msgPlain);
+        }
+    }
+    notify_scratch_put(iLevel, msgFinal);
+    if (nullptr != msgNoSpoof)
+    {
+        notify_scratch_put(iLevel, msgNoSpoof);
     }
-    delete msgFinal;
-    delete msg_ns;
     mudstate.ntfy_nest_lev--;
 }
 
@@ -1065,47 +1915,229 @@ void notify_check(dbref target, dbref sender, const UTF8 *msg, int key)
         return;
     }
 
-    mux_string *sMsg = new mux_string(msg);
+    int iLevel = mudstate.ntfy_nest_lev + 1;
+    mux_string *sMsg = notify_scratch_get(iLevel, NOTIFY_SCRATCH_MESSAGE);
+    sMsg->import(msg);
 
     notify_check(target, sender, *sMsg, key);
 
-    delete sMsg;
+    notify_scratch_put(iLevel, sMsg);
+}
+
+/* ----------------------------------------------------------------------
+ * Hearer lists.
+ *
+ * A message emitted into a room is offered to everything in it, but most
+ * objects in a crowded room do nothing with it.  Unless the message is also
+ * to be passed on to an object's contents, exits, neighbors or forwardlist,
+ * only a connected player, a puppet, a MONITOR object, or an object with an
+ * @listen has anything to do in notify_check(), so each location keeps the
+ * list of such objects in contents order.
+ *
+ * The list is dropped when the location's contents change, and when one of
+ * its objects connects, disconnects, changes a flag, or gains or loses an
+ * @listen.
+ */
+
+// Keys which make no work for an object that cannot hear.
+//
+#define HEARLIST_KEYS (MSG_PUP_ALWAYS|MSG_INV_L|MSG_ME|MSG_S_INSIDE|MSG_S_OUTSIDE \
+                      |MSG_HTML|MSG_OOC|MSG_SAYPOSE|MSG_SRC_MASK)
+
+static bool hearlist_member(dbref thing)
+{
+    return (  Connected(thing)
+           || Puppet(thing)
+           || Monitor(thing)
+           || H_Listen(thing));
+}
+
+void hearlist_release(HEAR_LIST *phl)
+{
+    phl->nRef--;
+    if (  phl->bStale
+       && 0 == phl->nRef)
+    {
+        if (nullptr != phl->aHearers)
+        {
+            MEMFREE(phl->aHearers);
+        }
+        delete phl;
+    }
+}
+
+void hearlist_drop(dbref loc)
+{
+    if (  !Good_dbref(loc)
+       || !mudstate.bfHearList.IsSet(loc))
+    {
+        return;
+    }
+    mudstate.bfHearList.Clear(loc);
+
+    HEAR_LIST *phl = (HEAR_LIST *)hashfindLEN(&loc, sizeof(loc), &mudstate.hear_list_htab);
+    if (nullptr != phl)
+    {
+        hashdeleteLEN(&loc, sizeof(loc), &mudstate.hear_list_htab);
+        phl->bStale = true;
+        phl->nRef++;
+        hearlist_release(phl);
+    }
+}
+
+void hearlist_drop_all(void)
+{
+    HEAR_LIST *phl;
+    while (nullptr != (phl = (HEAR_LIST *)hash_firstentry(&mudstate.hear_list_htab)))
+    {
+        hearlist_drop(phl->loc);
+    }
+}
+
+// Whether thing can hear may have changed.
+//
+void hearlist_touch(dbref thing)
+{
+    if (Good_obj(thing))
+    {
+        hearlist_drop(Location(thing));
+    }
+}
+
+// Returns the objects in loc which should be offered a message with the
+// given key.  The list stays valid until it is released, even if loc changes
+// meanwhile.  Every object in loc is returned when the key asks for more than
+// HEARLIST_KEYS, or inside @pipe, where output to the pipe object must be
+// captured whether or not it hears.
+//
+HEAR_LIST *hearlist_acquire(dbref loc, int key)
+{
+    HEAR_LIST *phl;
+    bool bAll = (  mudstate.inpipe
+                || 0 != (key & ~HEARLIST_KEYS)
+                || !Good_dbref(loc));
+    if (  !bAll
+       && mudstate.bfHearList.IsSet(loc))
+    {
+        phl = (HEAR_LIST *)hashfindLEN(&loc, sizeof(loc), &mudstate.hear_list_htab);
+        if (nullptr != phl)
+        {
+            phl->nRef++;
+            return phl;
+        }
+        mudstate.bfHearList.Clear(loc);
+    }
+
+    phl = new HEAR_LIST;
+    phl->loc      = loc;
+    phl->nRef     = 1;
+    phl->bStale   = bAll;
+    phl->nHearers = 0;
+    phl->aHearers = nullptr;
+
+    int nObjects = 0;
+    int limit = mudstate.db_top;
+    dbref thing = Good_dbref(loc) ? Contents(loc) : NOTHING;
+    for ( ; NOTHING != thing; thing = Next(thing))
+    {
+        nObjects++;
+        if (  thing == Next(thing)
+           || --limit < 0)
+        {
+            break;
+        }
+    }
+
+    if (0 < nObjects)
+    {
+        phl->aHearers = (dbref *)MEMALLOC(nObjects * sizeof(dbref));
+        ISOUTOFMEMORY(phl->aHearers);
+
+        thing = Contents(loc);
+        for (int i = 0; i < nObjects; i++, thing = Next(thing))
+        {
+            if (  bAll
+               || (  Good_obj(thing)
+                  && hearlist_member(thing)))
+            {
+                phl->aHearers[phl->nHearers++] = thing;
+            }
+        }
+    }
+
+    if (!bAll)
+    {
+        hashaddLEN(&loc, sizeof(loc), phl, &mudstate.hear_list_htab);
+        mudstate.bfHearList.Set(loc);
+    }
+    return phl;
 }
 
+// The message is parsed once and the same mux_string is handed to every
+// listener in the room.
+//
 void notify_except(dbref loc, dbref player, dbref exception, const UTF8 *msg, int key)
 {
-    dbref first;
+    if (  nullptr == msg
+       || '\0' == msg[0])
+    {
+        return;
+    }
+
+    int iLevel = mudstate.ntfy_nest_lev + 1;
+    mux_string *sMsg = notify_scratch_get(iLevel, NOTIFY_SCRATCH_MESSAGE);
+    sMsg->import(msg);
 
     if (loc != exception)
     {
-        notify_check(loc, player, msg, MSG_ME_ALL | MSG_F_UP | MSG_S_INSIDE | MSG_NBR_EXITS_A | key);
+        notify_check(loc, player, *sMsg, MSG_ME_ALL | MSG_F_UP | MSG_S_INSIDE | MSG_NBR_EXITS_A | key);
     }
-    DOLIST(first, Contents(loc))
+
+    HEAR_LIST *phl = hearlist_acquire(loc, MSG_ME | MSG_F_DOWN | MSG_S_OUTSIDE | key);
+    for (int i = 0; i < phl->nHearers; i++)
     {
+        dbref first = phl->aHearers[i];
         if (first != exception)
         {
-            notify_check(first, player, msg, MSG_ME | MSG_F_DOWN | MSG_S_OUTSIDE | key);
+            notify_check(first, player, *sMsg, MSG_ME | MSG_F_DOWN | MSG_S_OUTSIDE | key);
         }
     }
+    hearlist_release(phl);
+
+    notify_scratch_put(iLevel, sMsg);
 }
 
 void notify_except2(dbref loc, dbref player, dbref exc1, dbref exc2, const UTF8 *msg)
 {
-    dbref first;
+    if (  nullptr == msg
+       || '\0' == msg[0])
+    {
+        return;
+    }
+
+    int iLevel = mudstate.ntfy_nest_lev + 1;
+    mux_string *sMsg = notify_scratch_get(iLevel, NOTIFY_SCRATCH_MESSAGE);
+    sMsg->import(msg);
 
     if (  loc != exc1
        && loc != exc2)
     {
-        notify_check(loc, player, msg, MSG_ME_ALL | MSG_F_UP | MSG_S_INSIDE | MSG_NBR_EXITS_A);
+        notify_check(loc, player, *sMsg, MSG_ME_ALL | MSG_F_UP | MSG_S_INSIDE | MSG_NBR_EXITS_A);
     }
-    DOLIST(first, Contents(loc))
+
+    HEAR_LIST *phl = hearlist_acquire(loc, MSG_ME | MSG_F_DOWN | MSG_S_OUTSIDE);
+    for (int i = 0; i < phl->nHearers; i++)
     {
+        dbref first = phl->aHearers[i];
         if (  first != exc1
            && first != exc2)
         {
-            notify_check(first, player, msg, MSG_ME | MSG_F_DOWN | MSG_S_OUTSIDE);
+            notify_check(first, player, *sMsg, MSG_ME | MSG_F_DOWN | MSG_S_OUTSIDE);
         }
     }
+    hearlist_release(phl);
+
+    notify_scratch_put(iLevel, sMsg);
 }
 
 /* ----------------------------------------------------------------------
@@ -1170,6 +2202,7 @@ static void report_timecheck
             if (yes_clear)
             {
                 ltd.Set100ns(0);
+                db[thing].queue_cpu_time.Set100ns(0);
             }
         }
     }
@@ -1310,6 +2343,7 @@ void do_shutdown
 #endif // MEMORY_BASED
 
         pcache_sync();
+        journal_close();
         SYNC;
         CLOSE;
 
@@ -1371,6 +2405,208 @@ static DUMP_PROCEDURE DumpProcedures[NUM_DUMP_TYPES] =
 #define POPEN_WRITE_OP "w"
 #endif // UNIX_FILES
 
+// Incremental dumps.  When dump_deltas is set, a full dump is followed by up
+// to that many deltas holding only the objects changed since the dump before.
+// Deltas are written beside the output database as <outdb>.d1, <outdb>.d2,
+// and so on, and are applied in order on top of the full dump at startup.
+// Every file in a chain is stamped with the generation of its full dump, so a
+// delta is never applied to a database it was not written against.  A full
+// dump may also be followed by a binary snapshot of itself (snapshot.cpp).
+//
+static time_t tCheckpointBase = 0;
+
+static void checkpoint_delta_name(UTF8 *pName, size_t nName, int iDelta)
+{
+    mux_sprintf(pName, nName, T("%s.d%d"), mudconf.outdb, iDelta);
+}
+
+// The file the next DUMP_I_NORMAL writes.
+//
+void checkpoint_target(UTF8 *pName, size_t nName)
+{
+    if (0 < mudstate.checkpoint_delta)
+    {
+        checkpoint_delta_name(pName, nName, mudstate.checkpoint_delta);
+    }
+    else if (mudconf.compress_db)
+    {
+        mux_sprintf(pName, nName, T("%s.gz"), mudconf.outdb);
+    }
+    else
+    {
+        mux_strncpy(pName, mudconf.outdb, nName-1);
+    }
+}
+
+// Is the dump the next delta would build on safely on disk?  A forked dump
+// can fail without telling us.
+//
+static bool checkpoint_chain_intact(void)
+{
+    UTF8 fn[SIZEOF_PATHNAME+32];
+    struct stat statbuf;
+    checkpoint_target(fn, sizeof(fn));
+    if (stat((char *)fn, &statbuf) != 0)
+    {
+        // Just after startup, the full dump is the input database.
+        //
+        return (  0 == mudstate.checkpoint_delta
+               && 0 == tCheckpointBase);
+    }
+    return (  0 < mudstate.checkpoint_delta
+           || tCheckpointBase <= statbuf.st_mtime);
+}
+
+// Decide whether the coming DUMP_I_NORMAL is a delta or a full dump.
+//
+static void checkpoint_plan(bool bAllowDelta)
+{
+    if (  bAllowDelta
+       && 0 < mudconf.dump_deltas
+       && 0 < mudstate.checkpoint_base
+       && mudstate.checkpoint_delta < mudconf.dump_deltas
+       && checkpoint_chain_intact())
+    {
+        mudstate.checkpoint_delta++;
+    }
+    else
+    {
+        // Generations increase across restarts as well.
+        //
+        tCheckpointBase = time(nullptr);
+        mudstate.checkpoint_base++;
+        if (mudstate.checkpoint_base < (int)tCheckpointBase)
+        {
+            mudstate.checkpoint_base = (int)tCheckpointBase;
+        }
+        mudstate.checkpoint_delta = 0;
+    }
+}
+
+// The generation to stamp on a full dump.  Without incremental dumps, the
+// output is left exactly as before.
+//
+static int checkpoint_stamp(void)
+{
+    return (0 < mudconf.dump_deltas) ? mudstate.checkpoint_base : 0;
+}
+
+// A new full dump makes every existing delta obsolete.
+//
+static void checkpoint_remove_deltas(void)
+{
+    UTF8 fn[SIZEOF_PATHNAME+32];
+    struct stat statbuf;
+    for (int iDelta = 1; ; iDelta++)
+    {
+        checkpoint_delta_name(fn, sizeof(fn), iDelta);
+        if (stat((char *)fn, &statbuf) != 0)
+        {
+            break;
+        }
+        RemoveFile(fn);
+    }
+}
+
+static void checkpoint_log_written(const UTF8 *pName)
+{
+    struct stat statbuf;
+    if (stat((char *)pName, &statbuf) == 0)
+    {
+        STARTLOG(LOG_DBSAVES, "DMP", "SIZE");
+        log_printf(T("Wrote %s: %lld bytes."), pName, (INT64)statbuf.st_size);
+        ENDLOG;
+    }
+}
+
+static void dump_delta(void)
+{
+    UTF8 tmpfile[SIZEOF_PATHNAME+64];
+    UTF8 outfn[SIZEOF_PATHNAME+32];
+    FILE *f;
+
+    checkpoint_delta_name(outfn, sizeof(outfn), mudstate.checkpoint_delta);
+    mux_sprintf(tmpfile, sizeof(tmpfile), T("%s.#%d#"), outfn, mudstate.epoch);
+    if (mux_fopen(&f, tmpfile, T("wb")))
+    {
+        DebugTotalFiles++;
+        setvbuf(f, nullptr, _IOFBF, 16384);
+        db_write_checkpoint(f, F_MUX, OUTPUT_VERSION | OUTPUT_FLAGS,
+            mudstate.checkpoint_base, mudstate.checkpoint_delta);
+        bool bSuccess = (0 == ferror(f));
+        if (fclose(f) == 0)
+        {
+            DebugTotalFiles--;
+        }
+        else
+        {
+            bSuccess = false;
+        }
+
+        if (!bSuccess)
+        {
+            log_perror(T("SAV"), T("FAIL"), T("Writing"), tmpfile);
+            RemoveFile(tmpfile);
+        }
+        else if (ReplaceFile(tmpfile, outfn) < 0)
+        {
+            log_perror(T("SAV"), T("FAIL"), T("Renaming output file to delta file"), tmpfile);
+        }
+        else
+        {
+            checkpoint_log_written(outfn);
+        }
+    }
+    else
+    {
+        log_perror(T("SAV"), T("FAIL"), T("Opening"), tmpfile);
+    }
+}
+
+// Apply the deltas which follow the full dump just loaded.
+//
+static void checkpoint_load_deltas(void)
+{
+    if (mudstate.checkpoint_base <= 0)
+    {
+        return;
+    }
+
+    UTF8 fn[SIZEOF_PATHNAME+32];
+    FILE *f;
+    for (;;)
+    {
+        int iDelta = mudstate.checkpoint_delta + 1;
+        checkpoint_delta_name(fn, sizeof(fn), iDelta);
+        if (!mux_fopen(&f, fn, T("rb")))
+        {
+            break;
+        }
+        DebugTotalFiles++;
+        setvbuf(f, nullptr, _IOFBF, 16384);
+
+        STARTLOG(LOG_STARTUP, "INI", "LOAD");
+        log_text(T("Loading: "));
+        log_text(fn);
+        ENDLOG;
+
+        dbref nLoaded = db_read_delta(f, mudstate.checkpoint_base, iDelta);
+        if (fclose(f) == 0)
+        {
+            DebugTotalFiles--;
+        }
+
+        if (nLoaded < 0)
+        {
+            STARTLOG(LOG_STARTUP, "INI", "LOAD");
+            log_text(T("Ignoring stale or damaged delta: "));
+            log_text(fn);
+            ENDLOG;
+            break;
+        }
+    }
+}
+
 void dump_database_internal(int dump_type)
 {
     UTF8 tmpfile[SIZEOF_PATHNAME+32];
@@ -1432,7 +2668,17 @@ void dump_database_internal(int dump_type)
         {
             DebugTotalFiles++;
             setvbuf(f, nullptr, _IOFBF, 16384);
-            db_write(f, F_MUX, dp->fType);
+
+            // A restart database starts a new chain of incremental dumps.
+            // The others are not part of any chain.
+            //
+            int iBase = 0;
+            if (DUMP_I_RESTART == dump_type)
+            {
+                checkpoint_plan(false);
+                iBase = checkpoint_stamp();
+            }
+            db_write_checkpoint(f, F_MUX, dp->fType, iBase, 0);
             if (fclose(f) == 0)
             {
                 DebugTotalFiles--;
@@ -1440,8 +2686,15 @@ void dump_database_internal(int dump_type)
 
             if (dp->bUseTemporary)
             {
+                snapshot_remove(outfn);
                 ReplaceFile(tmpfile, outfn);
             }
+
+            if (DUMP_I_RESTART == dump_type)
+            {
+                checkpoint_remove_deltas();
+                snapshot_write(outfn);
+            }
         }
         else
         {
@@ -1470,9 +2723,13 @@ void dump_database_internal(int dump_type)
         return;
     }
 
-    // Nuke our predecessor
+    // Either write a delta or write a full dump and nuke our predecessor.
     //
-    if (mudconf.compress_db)
+    if (0 < mudstate.checkpoint_delta)
+    {
+        dump_delta();
+    }
+    else if (mudconf.compress_db)
     {
         mux_sprintf(prevfile, sizeof(prevfile), T("%s.prev.gz"), mudconf.outdb);
         mux_sprintf(tmpfile, sizeof(tmpfile), T("%s.#%d#.gz"), mudconf.outdb, mudstate.epoch - 1);
@@ -1485,16 +2742,23 @@ void dump_database_internal(int dump_type)
         {
             DebugTotalFiles++;
             setvbuf(f, nullptr, _IOFBF, 16384);
-            db_write(f, F_MUX, OUTPUT_VERSION | OUTPUT_FLAGS);
+            db_write_checkpoint(f, F_MUX, OUTPUT_VERSION | OUTPUT_FLAGS, checkpoint_stamp(), 0);
             if (pclose(f) != -1)
             {
                 DebugTotalFiles--;
             }
+            snapshot_remove(outfn);
             ReplaceFile(outfn, prevfile);
             if (ReplaceFile(tmpfile, outfn) < 0)
             {
                 log_perror(T("SAV"), T("FAIL"), T("Renaming output file to DB file"), tmpfile);
             }
+            else
+            {
+                checkpoint_remove_deltas();
+                checkpoint_log_written(outfn);
+                snapshot_write(outfn);
+            }
         }
         else
         {
@@ -1512,16 +2776,23 @@ void dump_database_internal(int dump_type)
         {
             DebugTotalFiles++;
             setvbuf(f, nullptr, _IOFBF, 16384);
-            db_write(f, F_MUX, OUTPUT_VERSION | OUTPUT_FLAGS);
+            db_write_checkpoint(f, F_MUX, OUTPUT_VERSION | OUTPUT_FLAGS, checkpoint_stamp(), 0);
             if (fclose(f) == 0)
             {
                 DebugTotalFiles--;
             }
+            snapshot_remove(mudconf.outdb);
             ReplaceFile(mudconf.outdb, prevfile);
             if (ReplaceFile(tmpfile, mudconf.outdb) < 0)
             {
                 log_perror(T("SAV"), T("FAIL"), T("Renaming output file to DB file"), tmpfile);
             }
+            else
+            {
+                checkpoint_remove_deltas();
+                checkpoint_log_written(mudconf.outdb);
+                snapshot_write(mudconf.outdb);
+            }
         }
         else
         {
@@ -1595,9 +2866,14 @@ static void dump_database(void)
 #endif // MEMORY_BASED
 
     pcache_sync();
+    checkpoint_plan(false);
+    UTF8 target[SIZEOF_PATHNAME+32];
+    checkpoint_target(target, sizeof(target));
+    journal_checkpoint_begin(target);
 
     dump_database_internal(DUMP_I_NORMAL);
     SYNC;
+    journal_checkpoint_end();
 
     STARTLOG(LOG_DBSAVES, "DMP", "DONE")
     log_text(T("Dump complete: "));
@@ -1696,6 +2972,13 @@ void fork_and_dump(int key)
 
     pcache_sync();
     SYNC;
+    if (key & DUMP_STRUCT)
+    {
+        checkpoint_plan(true);
+        UTF8 target[SIZEOF_PATHNAME+32];
+        checkpoint_target(target, sizeof(target));
+        journal_checkpoint_begin(target);
+    }
 
 #if defined(HAVE_WORKING_FORK)
     mudstate.write_protect = true;
@@ -1775,6 +3058,13 @@ void fork_and_dump(int key)
 #endif // HAVE_WORKING_FORK
     }
 
+    if (key & DUMP_STRUCT)
+    {
+        // The dump has everything changed up to this point.
+        //
+        db_clear_checkpoint();
+    }
+
 #if defined(HAVE_WORKING_FORK)
     mudstate.write_protect = false;
     if (!bChildExists)
@@ -1820,22 +3110,28 @@ static int load_game(int ccPageFile)
     int db_format, db_version, db_flags;
 
     bool compressed = false;
+    bool snapshot = false;
 
     if (mudconf.compress_db)
     {
         mux_sprintf(infile, sizeof(infile), T("%s.gz"), mudconf.indb);
         if (stat((char *)infile, &statbuf) == 0)
         {
-            f = popen((char *)tprintf(T(" %s < %s"), mudconf.uncompress, infile), POPEN_READ_OP);
-            if (f != nullptr)
+            snapshot = snapshot_load(infile, &db_format, &db_version, &db_flags);
+            if (!snapshot)
             {
-                DebugTotalFiles++;
-                compressed = true;
+                f = popen((char *)tprintf(T(" %s < %s"), mudconf.uncompress, infile), POPEN_READ_OP);
+                if (f != nullptr)
+                {
+                    DebugTotalFiles++;
+                    compressed = true;
+                }
             }
         }
     }
 
-    if (!compressed)
+    if (  !compressed
+       && !snapshot)
     {
         mux_strncpy(infile, mudconf.indb, sizeof(infile)-1);
         if (stat((char *)infile, &statbuf) != 0)
@@ -1846,23 +3142,54 @@ static int load_game(int ccPageFile)
             return LOAD_GAME_NO_INPUT_DB;
         }
 
-        if (!mux_fopen(&f, infile, T("rb")))
+        snapshot = snapshot_load(infile, &db_format, &db_version, &db_flags);
+        if (!snapshot)
         {
-            return LOAD_GAME_CANNOT_OPEN;
+            if (!mux_fopen(&f, infile, T("rb")))
+            {
+                return LOAD_GAME_CANNOT_OPEN;
+            }
+            DebugTotalFiles++;
+            setvbuf(f, nullptr, _IOFBF, 16384);
         }
-        DebugTotalFiles++;
-        setvbuf(f, nullptr, _IOFBF, 16384);
     }
 
-    // Ok, read it in.
+    // Ok, read it in.  A snapshot has already been loaded in its place.
     //
-    STARTLOG(LOG_STARTUP, "INI", "LOAD")
-    log_text(T("Loading: "));
-    log_text(infile);
-    ENDLOG
-    if (db_read(f, &db_format, &db_version, &db_flags) < 0)
+    if (!snapshot)
     {
-        // Everything is not ok.
+        STARTLOG(LOG_STARTUP, "INI", "LOAD")
+        log_text(T("Loading: "));
+        log_text(infile);
+        ENDLOG
+        if (db_read(f, &db_format, &db_version, &db_flags) < 0)
+        {
+            // Everything is not ok.
+            //
+            if (compressed)
+            {
+                if (pclose(f) != -1)
+                {
+                    DebugTotalFiles--;
+                }
+            }
+            else
+            {
+                if (fclose(f) == 0)
+                {
+                    DebugTotalFiles--;
+                }
+            }
+            f = 0;
+
+            STARTLOG(LOG_ALWAYS, "INI", "FATAL")
+            log_text(T("Error loading "));
+            log_text(infile);
+            ENDLOG
+            return LOAD_GAME_LOADING_PROBLEM;
+        }
+
+        // Everything is ok.
         //
         if (compressed)
         {
@@ -1879,31 +3206,20 @@ static int load_game(int ccPageFile)
             }
         }
         f = 0;
-
-        STARTLOG(LOG_ALWAYS, "INI", "FATAL")
-        log_text(T("Error loading "));
-        log_text(infile);
-        ENDLOG
-        return LOAD_GAME_LOADING_PROBLEM;
     }
 
-    // Everything is ok.
+    // Bring the checkpoint up to date with the deltas written since, and
+    // then with anything journaled since.  Replayed changes are in neither,
+    // so collection for the next delta starts first.
     //
-    if (compressed)
-    {
-        if (pclose(f) != -1)
-        {
-            DebugTotalFiles--;
-        }
-    }
-    else
+    checkpoint_load_deltas();
+    if (0 < mudconf.dump_deltas)
     {
-        if (fclose(f) == 0)
-        {
-            DebugTotalFiles--;
-        }
+        db_dirty_mask |= DB_DIRTY_CHECKPOINT;
+        db_vattrs_dirty = false;
     }
-    f = 0;
+    journal_replay();
+    load_player_names();
 
 #ifndef MEMORY_BASED
     if (db_flags & V_DATABASE)
@@ -1968,6 +3284,30 @@ static int load_game(int ccPageFile)
  *
  */
 
+static bool list_check1
+(
+    dbref thing,
+    dbref player,
+    UTF8  type,
+    UTF8  *str,
+    UTF8  *raw_str,
+    bool check_parent
+)
+{
+#ifdef REALITY_LVLS
+    if ((thing != player)
+       && (!(No_Command(thing)))
+       && IsReal(thing, player))
+#else
+    if (  thing != player
+       && !No_Command(thing))
+#endif // REALITY_LVLS
+    {
+        return atr_match(thing, player, type, str, raw_str, check_parent);
+    }
+    return false;
+}
+
 bool list_check
 (
     dbref thing,
@@ -1983,17 +3323,7 @@ bool list_check
     int limit = mudstate.db_top;
     while (NOTHING != thing)
     {
-#ifdef REALITY_LVLS
-        if ((thing != player)
-           && (!(No_Command(thing)))
-           && IsReal(thing, player))
-#else
-        if (  thing != player
-           && !No_Command(thing))
-#endif // REALITY_LVLS
-        {
-            bMatch |= atr_match(thing, player, type, str, raw_str, check_parent);
-        }
+        bMatch |= list_check1(thing, player, type, str, raw_str, check_parent);
 
         // Non-authoritative test of circular reference.
         //
@@ -2009,6 +3339,108 @@ bool list_check
     return bMatch;
 }
 
+/*
+ * Match $-commands on the contents of a room, but only on the objects the
+ * room's command index says could match.  They are tried in the same order
+ * as list_check() would try them.
+ */
+
+bool list_check_index
+(
+    dbref room,
+    dbref player,
+    UTF8  *str,
+    UTF8  *raw_str,
+    bool check_parent
+)
+{
+    CMD_INDEX *pci = cmdindex_load(room, check_parent);
+
+    UTF8 word[CMD_WORD_MAX+1];
+    UTF8 raw_word[CMD_WORD_MAX+1];
+    size_t nWord = cmd_first_word(str, word);
+    size_t nRawWord = cmd_first_word(raw_str, raw_word);
+
+    const CMD_INDEX_WORD *pw = cmdindex_find(room, word, nWord);
+    const CMD_INDEX_WORD *prw = nullptr;
+    if (  nRawWord != nWord
+       || memcmp(raw_word, word, nWord) != 0)
+    {
+        prw = cmdindex_find(room, raw_word, nRawWord);
+    }
+
+    // Merge the candidate positions.  They are copied out first because
+    // evaluating a lock may change the room and drop its index.
+    //
+    int n1 = (nullptr == pw)  ? 0 : pw->nPos;
+    int n2 = (nullptr == prw) ? 0 : prw->nPos;
+    int n3 = pci->nFallback;
+    if (0 == n1 + n2 + n3)
+    {
+        return false;
+    }
+
+    dbref *aCandidates = (dbref *)MEMALLOC((n1 + n2 + n3) * sizeof(dbref));
+    ISOUTOFMEMORY(aCandidates);
+    int nCandidates = 0;
+    int i1 = 0, i2 = 0, i3 = 0;
+    int last = -1;
+    while (  i1 < n1
+          || i2 < n2
+          || i3 < n3)
+    {
+        int pos = INT_MAX;
+        if (i1 < n1 && pw->aPos[i1] < pos)
+        {
+            pos = pw->aPos[i1];
+        }
+        if (i2 < n2 && prw->aPos[i2] < pos)
+        {
+            pos = prw->aPos[i2];
+        }
+        if (i3 < n3 && pci->aFallback[i3] < pos)
+        {
+            pos = pci->aFallback[i3];
+        }
+
+        if (i1 < n1 && pw->aPos[i1] == pos)
+        {
+            i1++;
+        }
+        if (i2 < n2 && prw->aPos[i2] == pos)
+        {
+            i2++;
+        }
+        if (i3 < n3 && pci->aFallback[i3] == pos)
+        {
+            i3++;
+        }
+
+        if (pos != last)
+        {
+            aCandidates[nCandidates++] = pci->aObjects[pos];
+            last = pos;
+        }
+    }
+
+    bool bMatch = false;
+    for (int i = 0; i < nCandidates; i++)
+    {
+        dbref thing = aCandidates[i];
+        if (Good_obj(thing))
+        {
+            bMatch |= list_check1(thing, player, AMATCH_CMD, str, raw_str, check_parent);
+        }
+
+        if (alarm_clock.alarmed)
+        {
+            break;
+        }
+    }
+    MEMFREE(aCandidates);
+    return bMatch;
+}
+
 bool Hearer(dbref thing)
 {
     if (  mudstate.inpipe
@@ -2748,6 +4180,11 @@ int DCL_CDECL main(int argc, char *argv[])
     Log.SetBasename(pErrorBasename);
     Log.StartLogging();
 
+    // The slow command log is only opened once something is written to it.
+    //
+    SlowLog.SetBasename(pErrorBasename);
+    SlowLog.SetPrefix(T("slow"));
+
     STARTLOG(LOG_ALWAYS, "INI", "LOAD");
     if (MUX_SUCCEEDED(mr))
     {
@@ -2971,6 +4408,7 @@ int DCL_CDECL main(int argc, char *argv[])
             return 2;
         }
     }
+    journal_open();
     set_signals();
     Guest.StartUp();
 
@@ -2978,6 +4416,12 @@ int DCL_CDECL main(int argc, char *argv[])
     //
     do_dbck(NOTHING, NOTHING, NOTHING, 0, 0);
 
+    // Build the object indexes and the contents and exits back links once.
+    // From here on, they are kept up to date as objects change.
+    //
+    db_link_lists();
+    db_index_rebuild();
+
     // Reset all the hash stats
     //
     hashreset(&mudstate.command_htab);
@@ -3064,6 +4508,7 @@ int DCL_CDECL main(int argc, char *argv[])
     final_stubslave();
 #endif // STUB_SLAVE
     final_modules();
+    journal_close();
     CLOSE;
 
 #if defined(HAVE_WORKING_FORK)
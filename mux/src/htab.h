@@ -43,6 +43,8 @@ struct bque
     int     nargs;                  // How many args I have
     UTF8    *text;                  // buffer for comm, env, and scr text
     UTF8    *comm;                  // command
+    dbref   src_thing;              // $-command which queued this, or NOTHING
+    int     src_atr;
     UTF8    *env[NUM_ENV_VARS];     // environment vars
     reg_ref *scr[MAX_GLOBAL_REGS];  // temp vars
 #if defined(STUB_SLAVE)
@@ -50,6 +52,35 @@ struct bque
     int     iRow;                   // Current Row
 #endif // STUB_SLAVE
     bool    IsTimed;                // Is there a waittime time on this entry?
+
+    // Queue index.
+    //
+    struct task_record *pTask;      // scheduled task which runs this entry
+    int     iKind;                  // QUE_WAIT, QUE_SEMAPHORE, QUE_SQL, or QUE_NONE
+    dbref   owner;                  // owner whose list holds this entry
+    BQUE    *pExecutorNext;         // entries with the same executor
+    BQUE    *pExecutorPrev;
+    BQUE    *pOwnerNext;            // entries with the same owner
+    BQUE    *pOwnerPrev;
+    struct semaphore_waiters *pWaiters; // semaphore wait list holding this entry
+    BQUE    *pSemaphoreNext;
+    BQUE    *pSemaphorePrev;
+};
+
+// Queue entries blocked on one attribute of a semaphore object. Untimed
+// entries are kept in the order they were queued, followed by timed entries
+// in the order they time out. This is the order in which @notify releases
+// them.
+//
+typedef struct semaphore_waiters SEMWAIT;
+struct semaphore_waiters
+{
+    int     attr;
+    BQUE    *pUntimedHead;
+    BQUE    *pUntimedTail;
+    BQUE    *pTimedHead;
+    BQUE    *pTimedTail;
+    SEMWAIT *pNext;                 // next attribute of the same object
 };
 
 class CBitField
@@ -204,6 +204,9 @@ struct descriptor_data
   int width;
   int height;
   int quota;
+  CLinearTimeAbsolute quota_time;       // quota includes timeslices up to here
+  struct task_record *idle_task;        // next Task_IdleCheck
+  struct task_record *keepalive_task;   // next Task_KeepAlive, if any
   PROG *program_data;
   struct descriptor_data *hashnext;
   struct descriptor_data *next;
@@ -282,7 +285,6 @@ extern int fetch_height(dbref target);
 extern int fetch_width(dbref target);
 extern const UTF8 *time_format_1(int Seconds, size_t maxWidth);
 extern const UTF8 *time_format_2(int Seconds);
-extern void update_quotas(CLinearTimeAbsolute& tLast, const CLinearTimeAbsolute& tCurrent);
 extern void raw_notify(dbref, const UTF8 *);
 extern void raw_notify(dbref player, const mux_string &sMsg);
 extern void raw_notify_newline(dbref);
@@ -297,8 +299,13 @@ extern void save_command(DESC *, CBLK *);
 extern void announce_disconnect(dbref, DESC *, const UTF8 *);
 extern int boot_by_port(SOCKET port, bool bGod, const UTF8 *message);
 extern void find_oldest(dbref target, DESC *dOldest[2]);
-extern void check_idle(void);
+extern void desc_recheck_idle(DESC *d);
+extern void desc_recheck_idle_all(void);
+extern void desc_start_keepalive(DESC *d);
+extern void desc_stop_timers(DESC *d);
 void Task_ProcessCommand(void *arg_voidptr, int arg_iInteger);
+void Task_IdleCheck(void *arg_voidptr, int arg_iInteger);
+void Task_KeepAlive(void *arg_voidptr, int arg_iInteger);
 extern dbref  find_connected_name(dbref, UTF8 *);
 extern void do_command(DESC *, UTF8 *);
 extern void desc_addhash(DESC *);
@@ -0,0 +1,861 @@
+/*! \file journal.cpp
+ * \brief Write-ahead journal of database mutations.
+ *
+ * $Id$
+ *
+ * Between checkpoints, every attribute write, attribute clear, object header
+ * change, and user-defined attribute name change is appended to the journal.
+ * Records are buffered and written with a single write() and fsync() every
+ * journal_commit_period (group commit).  On startup, the journal is replayed
+ * on top of the checkpoint that was just loaded, so a crash loses at most
+ * one commit period of changes instead of everything since the last dump.
+ *
+ * When a checkpoint begins, the current journal is retired to <journal>.prev
+ * and a new one is started.  The retired journal is removed once the
+ * checkpoint is known to be on disk.  Until then, both are replayed in order.
+ * Every record carries a complete value, so replaying a journal over a
+ * checkpoint which already contains some of its changes is harmless.
+ */
+
+#include "copyright.h"
+#include "autoconf.h"
+#include "config.h"
+#include "externs.h"
+
+#include <sys/stat.h>
+
+#include "attrs.h"
+#include "journal.h"
+#include "vattr.h"
+
+// Every journal file starts with this signature.  Records follow, each one
+// a JOURNAL_RECORD header and a payload whose first byte is the record type.
+// The CRC covers the payload.  A record which is short or fails its CRC marks
+// the end of the usable journal (it was being written when the game died).
+//
+#define JOURNAL_SIGNATURE       "MUXJRNL1"
+#define JOURNAL_SIGNATURE_SIZE  8
+
+#define JOURNAL_ATTR_SET    1   // dbref, attribute, value
+#define JOURNAL_ATTR_CLR    2   // dbref, attribute
+#define JOURNAL_OBJECT      3   // JOURNAL_OBJECT_RECORD
+#define JOURNAL_ATTR_NAME   4   // attribute, flags, name
+#define JOURNAL_ATTR_DELETE 5   // attribute
+
+// Attribute values are at most LBUF_SIZE-1 bytes, and attribute names are
+// much shorter than that, so no valid payload is larger than this.
+//
+#define JOURNAL_MAX_PAYLOAD (LBUF_SIZE + 64)
+
+// When this much is buffered, write it out without waiting for the next
+// commit.  The fsync() still waits for the commit.
+//
+#define JOURNAL_HIGHWATER   65536
+
+typedef struct
+{
+    UINT32 nPayload;
+    UINT32 nCRC;
+} JOURNAL_RECORD;
+
+typedef struct
+{
+    dbref   thing;
+    dbref   location;
+    dbref   contents;
+    dbref   exits;
+    dbref   next;
+    dbref   link;
+    dbref   parent;
+    dbref   owner;
+    dbref   zone;
+    FLAGSET fs;
+    POWER   powers;
+    POWER   powers2;
+} JOURNAL_OBJECT_RECORD;
+
+UINT64 journal_records  = 0;
+UINT64 journal_bytes    = 0;
+UINT64 journal_commits  = 0;
+UINT64 journal_replayed = 0;
+
+static bool   bJournalActive   = false;
+static bool   bJournalReplayed = false;
+static bool   bPrevPending     = false;
+static bool   bCheckpointWait  = false;
+static time_t tCheckpoint      = 0;
+static UTF8   szCheckpoint[SIZEOF_PATHNAME+32];
+static bool   bUnsynced        = false;
+static int    fdJournal        = MUX_OPEN_INVALID_HANDLE_VALUE;
+
+static UTF8  *pBuffer      = nullptr;
+static size_t nBuffer      = 0;
+static size_t nBufferAlloc = 0;
+
+static dbref *aDirty       = nullptr;
+static int    nDirty       = 0;
+static int    nDirtyAlloc  = 0;
+
+static void journal_prev_name(UTF8 *buff, size_t nBuff)
+{
+    mux_sprintf(buff, nBuff, T("%s.prev"), mudconf.journal_db);
+}
+
+static bool journal_file_exists(const UTF8 *pFilename)
+{
+    struct stat statbuf;
+    return (stat((const char *)pFilename, &statbuf) == 0);
+}
+
+static bool journal_write_all(int fd, const void *p, size_t n)
+{
+    const char *pc = (const char *)p;
+    while (0 < n)
+    {
+        int cc = mux_write(fd, pc, (unsigned int)n);
+        if (cc <= 0)
+        {
+            if (  cc < 0
+               && EINTR == errno)
+            {
+                continue;
+            }
+            return false;
+        }
+        pc += cc;
+        n  -= cc;
+    }
+    return true;
+}
+
+static void journal_sync(int fd)
+{
+#if defined(WINDOWS_FILES)
+    _commit(fd);
+#elif defined(UNIX_FILES)
+    fsync(fd);
+#endif // UNIX_FILES
+}
+
+static bool journal_create(const UTF8 *pFilename, int *pfd)
+{
+    if (!mux_open(pfd, pFilename, O_WRONLY|O_CREAT|O_TRUNC|O_BINARY))
+    {
+        return false;
+    }
+    DebugTotalFiles++;
+    if (!journal_write_all(*pfd, JOURNAL_SIGNATURE, JOURNAL_SIGNATURE_SIZE))
+    {
+        if (mux_close(*pfd) == 0)
+        {
+            DebugTotalFiles--;
+        }
+        *pfd = MUX_OPEN_INVALID_HANDLE_VALUE;
+        return false;
+    }
+    return true;
+}
+
+// Something went wrong with the journal itself.  A journal which is missing
+// records cannot be replayed safely, so both files are discarded and the game
+// falls back to relying on checkpoints alone.
+//
+static void journal_fail(const UTF8 *pReason)
+{
+    log_perror(T("JNL"), T("FAIL"), pReason, mudconf.journal_db);
+
+    if (MUX_OPEN_INVALID_HANDLE_VALUE != fdJournal)
+    {
+        if (mux_close(fdJournal) == 0)
+        {
+            DebugTotalFiles--;
+        }
+        fdJournal = MUX_OPEN_INVALID_HANDLE_VALUE;
+    }
+
+    UTF8 prevfile[SIZEOF_PATHNAME+8];
+    journal_prev_name(prevfile, sizeof(prevfile));
+    RemoveFile(prevfile);
+    RemoveFile(mudconf.journal_db);
+
+    bJournalActive = false;
+    bPrevPending = false;
+    bCheckpointWait = false;
+    db_dirty_mask &= ~DB_DIRTY_JOURNAL;
+    nBuffer = 0;
+    nDirty = 0;
+
+    STARTLOG(LOG_ALWAYS, "JNL", "FAIL");
+    log_text(T("Journaling disabled until the next restart."));
+    ENDLOG;
+}
+
+static void journal_flush(void)
+{
+    if (0 == nBuffer)
+    {
+        return;
+    }
+
+    if (!journal_write_all(fdJournal, pBuffer, nBuffer))
+    {
+        journal_fail(T("Writing"));
+        return;
+    }
+    journal_bytes += nBuffer;
+    nBuffer = 0;
+    bUnsynced = true;
+}
+
+static void journal_append
+(
+    int iType,
+    const void *p1, size_t n1,
+    const void *p2, size_t n2
+)
+{
+    size_t nPayload = 1 + n1 + n2;
+    size_t nNeeded = nBuffer + sizeof(JOURNAL_RECORD) + nPayload;
+    if (nBufferAlloc < nNeeded)
+    {
+        size_t nNew = GrowFiftyPercent(static_cast<int>(nNeeded), JOURNAL_HIGHWATER, INT_MAX);
+        UTF8 *pNew = (UTF8 *)MEMALLOC(nNew);
+        ISOUTOFMEMORY(pNew);
+        if (pBuffer)
+        {
+            memcpy(pNew, pBuffer, nBuffer);
+            MEMFREE(pBuffer);
+        }
+        pBuffer = pNew;
+        nBufferAlloc = nNew;
+    }
+
+    UTF8 *pPayload = pBuffer + nBuffer + sizeof(JOURNAL_RECORD);
+    UTF8 *p = pPayload;
+    *p++ = static_cast<UTF8>(iType);
+    if (0 < n1)
+    {
+        memcpy(p, p1, n1);
+        p += n1;
+    }
+    if (0 < n2)
+    {
+        memcpy(p, p2, n2);
+    }
+
+    JOURNAL_RECORD jr;
+    jr.nPayload = static_cast<UINT32>(nPayload);
+    jr.nCRC = CRC32_ProcessBuffer(0, pPayload, nPayload);
+    memcpy(pBuffer + nBuffer, &jr, sizeof(jr));
+    nBuffer = nNeeded;
+    journal_records++;
+
+    if (JOURNAL_HIGHWATER <= nBuffer)
+    {
+        journal_flush();
+    }
+}
+
+void journal_attr_set(dbref thing, int atr, const UTF8 *szValue, size_t nValue)
+{
+    if (  !bJournalActive
+       || A_LIST == atr)
+    {
+        return;
+    }
+
+    if (LBUF_SIZE-1 < nValue)
+    {
+        nValue = LBUF_SIZE-1;
+    }
+
+    int key[2] = { thing, atr };
+    journal_append(JOURNAL_ATTR_SET, key, sizeof(key), szValue, nValue);
+}
+
+void journal_attr_clr(dbref thing, int atr)
+{
+    if (  !bJournalActive
+       || A_LIST == atr)
+    {
+        return;
+    }
+
+    int key[2] = { thing, atr };
+    journal_append(JOURNAL_ATTR_CLR, key, sizeof(key), nullptr, 0);
+}
+
+void journal_attr_name(ATTR *va)
+{
+    if (  !bJournalActive
+       || nullptr == va)
+    {
+        return;
+    }
+
+    int key[2] = { va->number, va->flags };
+    journal_append(JOURNAL_ATTR_NAME, key, sizeof(key), va->name,
+        strlen((const char *)va->name));
+}
+
+void journal_attr_delete(int anum)
+{
+    if (!bJournalActive)
+    {
+        return;
+    }
+    journal_append(JOURNAL_ATTR_DELETE, &anum, sizeof(anum), nullptr, 0);
+}
+
+// Object headers are not journaled as each field changes.  Instead, the
+// object is remembered here, and its whole header is journaled once at the
+// next commit.
+//
+void journal_header_dirty(dbref thing)
+{
+    if (!bJournalActive)
+    {
+        db[thing].dirty &= ~DB_DIRTY_JOURNAL;
+        return;
+    }
+
+    if (nDirtyAlloc <= nDirty)
+    {
+        int nNew = GrowFiftyPercent(nDirtyAlloc, 1024, INT_MAX);
+        dbref *aNew = (dbref *)MEMALLOC(nNew * sizeof(dbref));
+        ISOUTOFMEMORY(aNew);
+        if (aDirty)
+        {
+            memcpy(aNew, aDirty, nDirty * sizeof(dbref));
+            MEMFREE(aDirty);
+        }
+        aDirty = aNew;
+        nDirtyAlloc = nNew;
+    }
+    aDirty[nDirty++] = thing;
+}
+
+static void journal_dirty_headers(void)
+{
+    for (int i = 0; i < nDirty; i++)
+    {
+        dbref thing = aDirty[i];
+        if (  thing < 0
+           || mudstate.db_top <= thing
+           || 0 == (db[thing].dirty & DB_DIRTY_JOURNAL))
+        {
+            continue;
+        }
+        db[thing].dirty &= ~DB_DIRTY_JOURNAL;
+
+        JOURNAL_OBJECT_RECORD jo;
+        jo.thing    = thing;
+        jo.location = db[thing].location;
+        jo.contents = db[thing].contents;
+        jo.exits    = db[thing].exits;
+        jo.next     = db[thing].next;
+        jo.link     = db[thing].link;
+        jo.parent   = db[thing].parent;
+        jo.owner    = db[thing].owner;
+        jo.zone     = db[thing].zone;
+        jo.fs       = db[thing].fs;
+        jo.powers   = db[thing].powers;
+        jo.powers2  = db[thing].powers2;
+        journal_append(JOURNAL_OBJECT, &jo, sizeof(jo), nullptr, 0);
+    }
+    nDirty = 0;
+}
+
+// Has the checkpoint started by journal_checkpoint_begin() reached the disk?
+//
+static bool journal_checkpoint_written(void)
+{
+    struct stat statbuf;
+    return (  stat((char *)szCheckpoint, &statbuf) == 0
+           && tCheckpoint <= statbuf.st_mtime);
+}
+
+// Group commit.  Journal the headers of every object changed since the last
+// commit, write everything buffered, and make it durable.
+//
+void journal_commit(void)
+{
+    if (!bJournalActive)
+    {
+        return;
+    }
+
+    journal_dirty_headers();
+    journal_flush();
+    if (  bJournalActive
+       && bUnsynced)
+    {
+        journal_sync(fdJournal);
+        bUnsynced = false;
+        journal_commits++;
+    }
+
+    if (  bCheckpointWait
+#if defined(HAVE_WORKING_FORK)
+       && !mudstate.dumping
+#endif // HAVE_WORKING_FORK
+       )
+    {
+        bCheckpointWait = false;
+        if (journal_checkpoint_written())
+        {
+            journal_checkpoint_end();
+        }
+        else
+        {
+            STARTLOG(LOG_PROBLEMS, "JNL", "CHKPT");
+            log_text(T("Checkpoint did not complete. Keeping previous journal."));
+            ENDLOG;
+        }
+    }
+}
+
+// Append the records of the current journal to the retired one.  This only
+// happens when a checkpoint begins before the previous one was confirmed.
+//
+static bool journal_append_to_prev(const UTF8 *pPrevFile)
+{
+    int fdIn, fdOut;
+    if (!mux_open(&fdIn, mudconf.journal_db, O_RDONLY|O_BINARY))
+    {
+        return false;
+    }
+    DebugTotalFiles++;
+
+    bool bSuccess = false;
+    if (mux_open(&fdOut, pPrevFile, O_WRONLY|O_APPEND|O_BINARY))
+    {
+        DebugTotalFiles++;
+        bSuccess = true;
+        char buf[16384];
+        mux_lseek(fdIn, JOURNAL_SIGNATURE_SIZE, SEEK_SET);
+        int cc;
+        while (0 < (cc = mux_read(fdIn, buf, sizeof(buf))))
+        {
+            if (!journal_write_all(fdOut, buf, cc))
+            {
+                bSuccess = false;
+                break;
+            }
+        }
+        if (cc < 0)
+        {
+            bSuccess = false;
+        }
+        journal_sync(fdOut);
+        if (mux_close(fdOut) == 0)
+        {
+            DebugTotalFiles--;
+        }
+    }
+    if (mux_close(fdIn) == 0)
+    {
+        DebugTotalFiles--;
+    }
+    return bSuccess;
+}
+
+// A checkpoint is about to capture the database into szFile.  Everything
+// journaled so far is retired, and a new journal is started for the changes
+// which follow.
+//
+void journal_checkpoint_begin(const UTF8 *szFile)
+{
+    if (!bJournalActive)
+    {
+        return;
+    }
+
+    journal_commit();
+    if (!bJournalActive)
+    {
+        return;
+    }
+
+    if (mux_close(fdJournal) == 0)
+    {
+        DebugTotalFiles--;
+    }
+    fdJournal = MUX_OPEN_INVALID_HANDLE_VALUE;
+
+    UTF8 prevfile[SIZEOF_PATHNAME+8];
+    journal_prev_name(prevfile, sizeof(prevfile));
+    if (bPrevPending)
+    {
+        if (!journal_append_to_prev(prevfile))
+        {
+            journal_fail(T("Appending to"));
+            return;
+        }
+        RemoveFile(mudconf.journal_db);
+    }
+    else if (ReplaceFile(mudconf.journal_db, prevfile) < 0)
+    {
+        journal_fail(T("Retiring"));
+        return;
+    }
+
+    if (!journal_create(mudconf.journal_db, &fdJournal))
+    {
+        journal_fail(T("Creating"));
+        return;
+    }
+    bPrevPending = true;
+    bCheckpointWait = true;
+    tCheckpoint = time(nullptr);
+    mux_strncpy(szCheckpoint, szFile, sizeof(szCheckpoint)-1);
+}
+
+// The checkpoint is safely on disk.  The retired journal is no longer needed.
+//
+void journal_checkpoint_end(void)
+{
+    bCheckpointWait = false;
+    if (bPrevPending)
+    {
+        UTF8 prevfile[SIZEOF_PATHNAME+8];
+        journal_prev_name(prevfile, sizeof(prevfile));
+        RemoveFile(prevfile);
+        bPrevPending = false;
+    }
+}
+
+// Apply one journal record to the database.
+//
+static void journal_apply(const UTF8 *pPayload, size_t nPayload)
+{
+    int iType = pPayload[0];
+    pPayload++;
+    nPayload--;
+
+    int key[2];
+    switch (iType)
+    {
+    case JOURNAL_ATTR_SET:
+    case JOURNAL_ATTR_CLR:
+        if (nPayload < sizeof(key))
+        {
+            return;
+        }
+        memcpy(key, pPayload, sizeof(key));
+        if (  key[0] < 0
+           || key[1] <= 0)
+        {
+            return;
+        }
+        if (mudstate.db_top <= key[0])
+        {
+            db_grow(key[0] + 1);
+        }
+
+        if (JOURNAL_ATTR_SET == iType)
+        {
+            // The payload buffer always has room for a terminating '\0'.
+            //
+            UTF8 *pValue = (UTF8 *)pPayload + sizeof(key);
+            size_t nValue = nPayload - sizeof(key);
+            pValue[nValue] = '\0';
+            if (A_NAME == key[1])
+            {
+                s_Name(key[0], pValue);
+            }
+            else if (A_MONIKER == key[1])
+            {
+                s_Moniker(key[0], pValue);
+            }
+            else
+            {
+                atr_add_raw_LEN(key[0], key[1], pValue, nValue);
+            }
+        }
+        else if (A_NAME == key[1])
+        {
+            s_Name(key[0], nullptr);
+        }
+        else if (A_MONIKER == key[1])
+        {
+            s_Moniker(key[0], nullptr);
+        }
+        else
+        {
+            atr_clr(key[0], key[1]);
+        }
+        break;
+
+    case JOURNAL_OBJECT:
+        {
+            JOURNAL_OBJECT_RECORD jo;
+            if (nPayload != sizeof(jo))
+            {
+                return;
+            }
+            memcpy(&jo, pPayload, sizeof(jo));
+            if (jo.thing < 0)
+            {
+                return;
+            }
+            if (mudstate.db_top <= jo.thing)
+            {
+                db_grow(jo.thing + 1);
+            }
+            s_Location(jo.thing, jo.location);
+            s_Contents(jo.thing, jo.contents);
+            s_Exits(jo.thing, jo.exits);
+            s_Next(jo.thing, jo.next);
+            s_Link(jo.thing, jo.link);
+            s_Parent(jo.thing, jo.parent);
+            s_Owner(jo.thing, jo.owner);
+            s_Zone(jo.thing, jo.zone);
+            db[jo.thing].fs = jo.fs;
+            s_Powers(jo.thing, jo.powers);
+            s_Powers2(jo.thing, jo.powers2);
+        }
+        break;
+
+    case JOURNAL_ATTR_NAME:
+        {
+            if (nPayload <= sizeof(key))
+            {
+                return;
+            }
+            memcpy(key, pPayload, sizeof(key));
+            UTF8 *pName = (UTF8 *)pPayload + sizeof(key);
+            size_t nName = nPayload - sizeof(key);
+            pName[nName] = '\0';
+            if (key[0] < A_USER_START)
+            {
+                return;
+            }
+
+            vattr_redefine_LEN(pName, nName, key[0], key[1]);
+        }
+        break;
+
+    case JOURNAL_ATTR_DELETE:
+        {
+            int anum;
+            if (nPayload != sizeof(anum))
+            {
+                return;
+            }
+            memcpy(&anum, pPayload, sizeof(anum));
+            if (  A_USER_START <= anum
+               && anum <= anum_alc_top)
+            {
+                ATTR *va = (ATTR *)anum_get(anum);
+                if (nullptr != va)
+                {
+                    vattr_delete_LEN((UTF8 *)va->name, strlen((char *)va->name));
+                }
+            }
+        }
+        break;
+    }
+}
+
+// Replay one journal file, copying every valid record to fdOut.
+//
+static void journal_replay_file(const UTF8 *pFilename, int fdOut, UTF8 *pPayload)
+{
+    FILE *f;
+    if (!mux_fopen(&f, pFilename, T("rb")))
+    {
+        return;
+    }
+    DebugTotalFiles++;
+    setvbuf(f, nullptr, _IOFBF, 65536);
+
+    STARTLOG(LOG_STARTUP, "INI", "LOAD");
+    log_text(T("Replaying journal: "));
+    log_text(pFilename);
+    ENDLOG;
+
+    UINT64 nRecords = 0;
+    bool bClean = false;
+    char sig[JOURNAL_SIGNATURE_SIZE];
+    if (  fread(sig, 1, sizeof(sig), f) == sizeof(sig)
+       && memcmp(sig, JOURNAL_SIGNATURE, sizeof(sig)) == 0)
+    {
+        for (;;)
+        {
+            JOURNAL_RECORD jr;
+            size_t cc = fread(&jr, 1, sizeof(jr), f);
+            if (0 == cc)
+            {
+                bClean = true;
+                break;
+            }
+            if (  sizeof(jr) != cc
+               || 0 == jr.nPayload
+               || JOURNAL_MAX_PAYLOAD < jr.nPayload
+               || fread(pPayload, 1, jr.nPayload, f) != jr.nPayload
+               || CRC32_ProcessBuffer(0, pPayload, jr.nPayload) != jr.nCRC)
+            {
+                break;
+            }
+
+            if (  MUX_OPEN_INVALID_HANDLE_VALUE != fdOut
+               && (  !journal_write_all(fdOut, &jr, sizeof(jr))
+                  || !journal_write_all(fdOut, pPayload, jr.nPayload)))
+            {
+                log_perror(T("INI"), T("FAIL"), T("Writing"), mudconf.journal_db);
+                fdOut = MUX_OPEN_INVALID_HANDLE_VALUE;
+            }
+            journal_apply(pPayload, jr.nPayload);
+            nRecords++;
+        }
+    }
+
+    if (fclose(f) == 0)
+    {
+        DebugTotalFiles--;
+    }
+
+    journal_replayed += nRecords;
+    STARTLOG(LOG_STARTUP, "INI", "LOAD");
+    log_printf(T("Replayed %llu journal records from %s%s"), nRecords, pFilename,
+        bClean ? T(".") : T(" (torn record at end discarded)."));
+    ENDLOG;
+}
+
+// Called from load_game() after the checkpoint is read.  Both journals are
+// replayed, and their valid records are consolidated into <journal>.prev
+// which stays until the next checkpoint is confirmed.
+//
+bool journal_replay(void)
+{
+    bJournalReplayed = true;
+
+    UTF8 prevfile[SIZEOF_PATHNAME+8];
+    journal_prev_name(prevfile, sizeof(prevfile));
+    bool bPrev = journal_file_exists(prevfile);
+    bool bCurrent = journal_file_exists(mudconf.journal_db);
+    if (  !bPrev
+       && !bCurrent)
+    {
+        return true;
+    }
+
+    if (!mudconf.journal)
+    {
+        // A journal that stopped being kept can only be older than the
+        // checkpoint, so replaying it would undo newer changes.
+        //
+        STARTLOG(LOG_STARTUP, "INI", "LOAD");
+        log_text(T("Journaling is disabled. Removing stale journal: "));
+        log_text(mudconf.journal_db);
+        ENDLOG;
+        RemoveFile(prevfile);
+        RemoveFile(mudconf.journal_db);
+        return true;
+    }
+
+    UTF8 tmpfile[SIZEOF_PATHNAME+32];
+    mux_sprintf(tmpfile, sizeof(tmpfile), T("%s.#%d#"), mudconf.journal_db, mudstate.epoch);
+    int fdOut;
+    if (!journal_create(tmpfile, &fdOut))
+    {
+        log_perror(T("INI"), T("FAIL"), T("Creating"), tmpfile);
+        fdOut = MUX_OPEN_INVALID_HANDLE_VALUE;
+    }
+
+    UTF8 *pPayload = (UTF8 *)MEMALLOC(JOURNAL_MAX_PAYLOAD + 1);
+    ISOUTOFMEMORY(pPayload);
+    UINT64 nBefore = journal_replayed;
+    if (bPrev)
+    {
+        journal_replay_file(prevfile, fdOut, pPayload);
+    }
+    if (bCurrent)
+    {
+        journal_replay_file(mudconf.journal_db, fdOut, pPayload);
+    }
+    MEMFREE(pPayload);
+
+    if (MUX_OPEN_INVALID_HANDLE_VALUE != fdOut)
+    {
+        journal_sync(fdOut);
+        if (mux_close(fdOut) == 0)
+        {
+            DebugTotalFiles--;
+        }
+        if (  nBefore != journal_replayed
+           && ReplaceFile(tmpfile, prevfile) == 0)
+        {
+            RemoveFile(mudconf.journal_db);
+        }
+        else
+        {
+            RemoveFile(tmpfile);
+        }
+    }
+    return true;
+}
+
+// Called once the database is loaded (or created).  Starts a new journal.
+//
+void journal_open(void)
+{
+    if (  !mudconf.journal
+       || mudstate.bStandAlone
+       || bJournalActive)
+    {
+        return;
+    }
+
+    UTF8 prevfile[SIZEOF_PATHNAME+8];
+    journal_prev_name(prevfile, sizeof(prevfile));
+    if (!bJournalReplayed)
+    {
+        // The database was not loaded from a checkpoint, so any journal
+        // lying around belongs to some other database.
+        //
+        RemoveFile(prevfile);
+        RemoveFile(mudconf.journal_db);
+    }
+
+    if (!journal_create(mudconf.journal_db, &fdJournal))
+    {
+        log_perror(T("JNL"), T("FAIL"), T("Creating"), mudconf.journal_db);
+        return;
+    }
+    bPrevPending = journal_file_exists(prevfile);
+    bCheckpointWait = false;
+    bJournalActive = true;
+    db_dirty_mask |= DB_DIRTY_JOURNAL;
+
+    STARTLOG(LOG_STARTUP, "INI", "LOAD");
+    log_text(T("Journaling to: "));
+    log_text(mudconf.journal_db);
+    ENDLOG;
+}
+
+// Commit whatever is outstanding and stop journaling.  The files are left for
+// the next startup.
+//
+void journal_close(void)
+{
+    if (!bJournalActive)
+    {
+        return;
+    }
+
+    journal_commit();
+    if (!bJournalActive)
+    {
+        return;
+    }
+
+    if (mux_close(fdJournal) == 0)
+    {
+        DebugTotalFiles--;
+    }
+    fdJournal = MUX_OPEN_INVALID_HANDLE_VALUE;
+    bJournalActive = false;
+    db_dirty_mask &= ~DB_DIRTY_JOURNAL;
+}
@@ -0,0 +1,29 @@
+/*! \file journal.h
+ * \brief Write-ahead journal of database mutations.
+ *
+ * $Id$
+ *
+ */
+
+#ifndef _JOURNAL_H
+#define _JOURNAL_H
+
+extern bool journal_replay(void);
+extern void journal_open(void);
+extern void journal_close(void);
+extern void journal_commit(void);
+extern void journal_checkpoint_begin(const UTF8 *szFile);
+extern void journal_checkpoint_end(void);
+
+extern void journal_attr_set(dbref thing, int atr, const UTF8 *szValue, size_t nValue);
+extern void journal_attr_clr(dbref thing, int atr);
+extern void journal_attr_name(ATTR *va);
+extern void journal_attr_delete(int anum);
+extern void journal_header_dirty(dbref thing);
+
+extern UINT64 journal_records;
+extern UINT64 journal_bytes;
+extern UINT64 journal_commits;
+extern UINT64 journal_replayed;
+
+#endif // !_JOURNAL_H
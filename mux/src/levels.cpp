@@ -19,62 +19,64 @@
 #include "levels.h"
 #include "mathutil.h"
 
-RLEVEL RxLevel(dbref thing)
+RLEVEL default_rxlevel(dbref thing)
 {
-    const UTF8 *buff = atr_get_raw(thing, A_RLEVEL);
-    if (  nullptr == buff
-       || strlen((char *)buff) != 17)
+    switch (Typeof(thing))
     {
-        switch (Typeof(thing))
-        {
-        case TYPE_ROOM:
-            return(mudconf.def_room_rx);
+    case TYPE_ROOM:
+        return(mudconf.def_room_rx);
 
-        case TYPE_PLAYER:
-            return(mudconf.def_player_rx);
+    case TYPE_PLAYER:
+        return(mudconf.def_player_rx);
 
-        case TYPE_EXIT:
-            return(mudconf.def_exit_rx);
+    case TYPE_EXIT:
+        return(mudconf.def_exit_rx);
 
-        default:
-            return(mudconf.def_thing_rx);
-        }
+    default:
+        return(mudconf.def_thing_rx);
     }
+}
 
-    int i;
-    RLEVEL rx = 0;
-    for (i = 0; mux_isxdigit(buff[i]); i++)
+RLEVEL default_txlevel(dbref thing)
+{
+    switch (Typeof(thing))
     {
-        rx = 16 * rx + mux_hex2dec(buff[i]);
+    case TYPE_ROOM:
+        return(mudconf.def_room_tx);
+
+    case TYPE_PLAYER:
+        return(mudconf.def_player_tx);
+
+    case TYPE_EXIT:
+        return(mudconf.def_exit_tx);
+
+    default:
+        return(mudconf.def_thing_tx);
     }
-    return rx;
 }
 
-RLEVEL TxLevel(dbref thing)
+// rlevel_changed: Decode a new Rlevel attribute value ('RRRRRRRR TTTTTTTT'
+// in hex) into the object header.  Anything else, including no value at
+// all, leaves the object at the defaults for its type.
+//
+void rlevel_changed(dbref thing, const UTF8 *buff)
 {
-    const UTF8 *buff = atr_get_raw(thing, A_RLEVEL);
     if (  nullptr == buff
        || strlen((char *)buff) != 17)
     {
-        switch (Typeof(thing))
-        {
-        case TYPE_ROOM:
-            return(mudconf.def_room_tx);
-
-        case TYPE_PLAYER:
-            return(mudconf.def_player_tx);
-
-        case TYPE_EXIT:
-            return(mudconf.def_exit_tx);
+        db[thing].iRLevel = 0;
+        return;
+    }
 
-        default:
-            return(mudconf.def_thing_tx);
-        }
+    int i;
+    RLEVEL rx = 0;
+    for (i = 0; mux_isxdigit(buff[i]); i++)
+    {
+        rx = 16 * rx + mux_hex2dec(buff[i]);
     }
 
     // Skip the first field.
     //
-    int i;
     for (i = 0; buff[i] && !mux_isspace(buff[i]); i++)
     {
         ; // Nothing.
@@ -94,7 +96,18 @@ RLEVEL TxLevel(dbref thing)
             tx = 16 * tx + mux_hex2dec(buff[i]);
         }
     }
-    return tx;
+
+    db[thing].rxlevel = rx;
+    db[thing].txlevel = tx;
+    db[thing].iRLevel = 1;
+}
+
+// rlevel_load: Decode the Rlevel attribute of an object whose levels are not
+// known yet.
+//
+void rlevel_load(dbref thing)
+{
+    rlevel_changed(thing, atr_get_raw(thing, A_RLEVEL));
 }
 
 void notify_except_rlevel
@@ -106,23 +119,37 @@ void notify_except_rlevel
     int xflags
 )
 {
+    if (  nullptr == msg
+       || '\0' == msg[0])
+    {
+        return;
+    }
+
+    // Parse the message once for everyone in the room.
+    //
+    mux_string *sMsg = new mux_string(msg);
+
     if (  loc != exception
        && IsReal(loc, player))
     {
-        notify_check(loc, player, msg,
+        notify_check(loc, player, *sMsg,
             (MSG_ME_ALL | MSG_F_UP | MSG_S_INSIDE | MSG_NBR_EXITS_A| xflags));
     }
 
-    dbref first;
-    DOLIST(first, Contents(loc))
+    HEAR_LIST *phl = hearlist_acquire(loc, MSG_ME | MSG_F_DOWN | MSG_S_OUTSIDE | xflags);
+    for (int i = 0; i < phl->nHearers; i++)
     {
+        dbref first = phl->aHearers[i];
         if (  first != exception
            && IsReal(first, player))
         {
-            notify_check(first, player, msg,
+            notify_check(first, player, *sMsg,
                 (MSG_ME | MSG_F_DOWN | MSG_S_OUTSIDE | xflags));
         }
     }
+    hearlist_release(phl);
+
+    delete sMsg;
 }
 
 void notify_except2_rlevel
@@ -134,25 +161,39 @@ void notify_except2_rlevel
     const UTF8 *msg
 )
 {
+    if (  nullptr == msg
+       || '\0' == msg[0])
+    {
+        return;
+    }
+
+    // Parse the message once for everyone in the room.
+    //
+    mux_string *sMsg = new mux_string(msg);
+
     if (  loc != exc1
        && loc != exc2
        && IsReal(loc, player))
     {
-        notify_check(loc, player, msg,
+        notify_check(loc, player, *sMsg,
             (MSG_ME_ALL | MSG_F_UP | MSG_S_INSIDE | MSG_NBR_EXITS_A));
     }
 
-    dbref first;
-    DOLIST(first, Contents(loc))
+    HEAR_LIST *phl = hearlist_acquire(loc, MSG_ME | MSG_F_DOWN | MSG_S_OUTSIDE);
+    for (int i = 0; i < phl->nHearers; i++)
     {
+        dbref first = phl->aHearers[i];
         if (  first != exc1
            && first != exc2
            && IsReal(first, player))
         {
-            notify_check(first, player, msg,
+            notify_check(first, player, *sMsg,
                 (MSG_ME | MSG_F_DOWN | MSG_S_OUTSIDE));
         }
     }
+    hearlist_release(phl);
+
+    delete sMsg;
 }
 
 void notify_except2_rlevel2
@@ -164,26 +205,40 @@ void notify_except2_rlevel2
     const UTF8 *msg
 )
 {
+    if (  nullptr == msg
+       || '\0' == msg[0])
+    {
+        return;
+    }
+
+    // Parse the message once for everyone in the room.
+    //
+    mux_string *sMsg = new mux_string(msg);
+
     if (  loc != exc1
        && loc != exc2
        && IsReal(loc, player))
     {
-        notify_check(loc, player, msg,
+        notify_check(loc, player, *sMsg,
             (MSG_ME_ALL | MSG_F_UP | MSG_S_INSIDE | MSG_NBR_EXITS_A));
     }
 
-    dbref first;
-    DOLIST(first, Contents(loc))
+    HEAR_LIST *phl = hearlist_acquire(loc, MSG_ME | MSG_F_DOWN | MSG_S_OUTSIDE);
+    for (int i = 0; i < phl->nHearers; i++)
     {
+        dbref first = phl->aHearers[i];
         if (  first != exc1
            && first != exc2
            && IsReal(first, player)
            && IsReal(first, exc2))
         {
-            notify_check(first, player, msg,
+            notify_check(first, player, *sMsg,
                 (MSG_ME | MSG_F_DOWN | MSG_S_OUTSIDE));
         }
     }
+    hearlist_release(phl);
+
+    delete sMsg;
 }
 
 /*
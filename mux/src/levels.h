@@ -13,10 +13,35 @@
 #include "htab.h"
 #include "db.h"
 
+RLEVEL   default_rxlevel(dbref);
+RLEVEL   default_txlevel(dbref);
+void     rlevel_changed(dbref, const UTF8 *);
+void     rlevel_load(dbref);
+
+// The levels in the Rlevel attribute are kept decoded in the object header.
+// Objects start out unknown (for example, after a load that does not read
+// attributes) and are decoded from Rlevel on first use.
+//
+inline RLEVEL RxLevel(dbref thing)
+{
+    if (db[thing].iRLevel < 0)
+    {
+        rlevel_load(thing);
+    }
+    return 0 < db[thing].iRLevel ? db[thing].rxlevel : default_rxlevel(thing);
+}
+
+inline RLEVEL TxLevel(dbref thing)
+{
+    if (db[thing].iRLevel < 0)
+    {
+        rlevel_load(thing);
+    }
+    return 0 < db[thing].iRLevel ? db[thing].txlevel : default_txlevel(thing);
+}
+
 #define IsReal(R, T) ((R) == (T) || (RxLevel(R) & TxLevel(T)))
 
-RLEVEL   RxLevel(dbref);
-RLEVEL   TxLevel(dbref);
 void     notify_except_rlevel(dbref, dbref, dbref, const UTF8 *, int);
 void     notify_except2_rlevel(dbref, dbref, dbref, dbref, const UTF8 *);
 void     notify_except2_rlevel2(dbref, dbref, dbref, dbref, const UTF8 *);
@@ -365,6 +365,8 @@ void do_log
 }
 
 CLogFile Log;
+CLogFile SlowLog;
+
 void CLogFile::WriteInteger(int iNumber)
 {
     UTF8 aTempBuffer[I32BUF_SIZE];
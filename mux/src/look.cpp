@@ -2067,6 +2067,90 @@ void do_inventory(dbref executor, dbref caller, dbref enactor, int eval, int key
     do_score(executor, caller, executor, 0, 0);
 }
 
+// entrance_candidates: Collect, in dbref order and without duplicates, the
+// objects which may lead to thing: exits to it, rooms which drop to it,
+// players and things whose home it is, its children, and objects which
+// forward to it.  The caller frees the list with MEMFREE.
+//
+// Forwardlist targets are not indexed, so the cached forwardlists are
+// walked once.  The cost is the number of entrances plus the number of
+// objects with a forwardlist.
+//
+static int entrance_candidates(dbref thing, dbref **paList)
+{
+    static const int aIndexes[] = { DBI_DEST, DBI_HOME, DBI_PARENT };
+    const int nIndexes = sizeof(aIndexes)/sizeof(aIndexes[0]);
+    dbref *aFound[nIndexes];
+    int nFound[nIndexes];
+
+    int nMax = 0;
+    int i;
+    for (i = 0; i < nIndexes; i++)
+    {
+        nFound[i] = db_index_gather(aIndexes[i], thing, &aFound[i]);
+        nMax += nFound[i];
+    }
+
+    // Forwardlists are only kept for the objects which have one.
+    //
+    nMax += static_cast<int>(mudstate.fwdlist_htab.GetEntryCount());
+
+    dbref *aList = nullptr;
+    int nList = 0;
+    if (0 < nMax)
+    {
+        aList = (dbref *)MEMALLOC(nMax * sizeof(dbref));
+        ISOUTOFMEMORY(aList);
+        for (i = 0; i < nIndexes; i++)
+        {
+            for (int j = 0; j < nFound[i]; j++)
+            {
+                aList[nList++] = aFound[i][j];
+            }
+        }
+
+        int nKey;
+        UTF8 *pKey;
+        FWDLIST *fp;
+        for (fp = (FWDLIST *)hash_firstkey(&mudstate.fwdlist_htab, &nKey, &pKey);
+             nullptr != fp;
+             fp = (FWDLIST *)hash_nextkey(&mudstate.fwdlist_htab, &nKey, &pKey))
+        {
+            for (int j = 0; j < fp->count; j++)
+            {
+                if (  fp->data[j] == thing
+                   && nList < nMax)
+                {
+                    memcpy(&aList[nList++], pKey, sizeof(dbref));
+                    break;
+                }
+            }
+        }
+        qsort(aList, nList, sizeof(dbref), db_index_compare);
+
+        int nUnique = 0;
+        for (i = 0; i < nList; i++)
+        {
+            if (  0 == nUnique
+               || aList[nUnique-1] != aList[i])
+            {
+                aList[nUnique++] = aList[i];
+            }
+        }
+        nList = nUnique;
+    }
+
+    for (i = 0; i < nIndexes; i++)
+    {
+        if (nullptr != aFound[i])
+        {
+            MEMFREE(aFound[i]);
+        }
+    }
+    *paList = aList;
+    return nList;
+}
+
 void do_entrances(dbref executor, dbref caller, dbref enactor, int eval, int key, UTF8 *name, const UTF8 *cargs[], int ncargs)
 {
     UNUSED_PARAMETER(caller);
@@ -2118,8 +2202,18 @@ void do_entrances(dbref executor, dbref caller, dbref enactor, int eval, int key
     message = alloc_lbuf("do_entrances");
     control_thing = Examinable(executor, thing);
     count = 0;
-    for (i = low_bound; i <= high_bound; i++)
+
+    dbref *aCandidates;
+    int nCandidates = entrance_candidates(thing, &aCandidates);
+    for (int k = 0; k < nCandidates; k++)
     {
+        i = aCandidates[k];
+        if (  i < low_bound
+           || high_bound < i)
+        {
+            continue;
+        }
+
         if (control_thing || Examinable(executor, i))
         {
             switch (Typeof(i))
@@ -2187,6 +2281,10 @@ void do_entrances(dbref executor, dbref caller, dbref enactor, int eval, int key
             }
         }
     }
+    if (nullptr != aCandidates)
+    {
+        MEMFREE(aCandidates);
+    }
     free_lbuf(message);
     notify(executor, tprintf(T("%d entrance%s found."), count,
         (count == 1) ? "" : "s"));
@@ -400,6 +400,366 @@ void match_neighbor(void)
     }
 }
 
+/* ---------------------------------------------------------------------------
+ * Room exit indexes.
+ *
+ * Each location whose exits are matched by name keeps an index from the
+ * aliases of its exits, with ASCII letters folded to lower case, to their
+ * positions in the exit list.  This avoids walking every exit and splitting
+ * its alias list on every movement command.  Matching exits are still
+ * promoted in list order, so precedence and the random choice between equal
+ * matches do not change.
+ *
+ * The index is dropped when an exit is added to or removed from the
+ * location, or when one of its exits is renamed.
+ */
+
+#define EXIT_ALIAS_MAX  MBUF_SIZE
+
+typedef struct exit_alias
+{
+    size_t nKey;
+    UTF8  *key;             // Location followed by the folded alias.
+    int    nPos;
+    int   *aPos;            // Positions in aExits, in ascending order.
+} EXIT_ALIAS;
+
+typedef struct exit_index
+{
+    dbref  loc;
+    int    nRef;
+    bool   bStale;
+    bool   bFallback;       // An alias was too long to index.
+    int    nExits;
+    dbref *aExits;          // Exits of the location in order.
+    int    nAliases;
+    EXIT_ALIAS *aAliases;
+} EXIT_INDEX;
+
+typedef struct exit_index_entry
+{
+    int    pos;
+    size_t nAlias;
+    UTF8  *alias;           // Folded alias.
+} EXIT_INDEX_ENTRY;
+
+static int exitindex_compare(const void *a, const void *b)
+{
+    const EXIT_INDEX_ENTRY *pa = (const EXIT_INDEX_ENTRY *)a;
+    const EXIT_INDEX_ENTRY *pb = (const EXIT_INDEX_ENTRY *)b;
+    size_t n = (pa->nAlias < pb->nAlias) ? pa->nAlias : pb->nAlias;
+    int cmp = memcmp(pa->alias, pb->alias, n);
+    if (0 != cmp)
+    {
+        return cmp;
+    }
+    if (pa->nAlias != pb->nAlias)
+    {
+        return (pa->nAlias < pb->nAlias) ? -1 : 1;
+    }
+    return pa->pos - pb->pos;
+}
+
+static void exitindex_release(EXIT_INDEX *pei)
+{
+    pei->nRef--;
+    if (  pei->bStale
+       && 0 == pei->nRef)
+    {
+        for (int i = 0; i < pei->nAliases; i++)
+        {
+            MEMFREE(pei->aAliases[i].key);
+            MEMFREE(pei->aAliases[i].aPos);
+        }
+        if (nullptr != pei->aAliases)
+        {
+            MEMFREE(pei->aAliases);
+        }
+        if (nullptr != pei->aExits)
+        {
+            MEMFREE(pei->aExits);
+        }
+        delete pei;
+    }
+}
+
+static void exitindex_remove(EXIT_INDEX *pei)
+{
+    mudstate.bfExitIndex.Clear(pei->loc);
+    hashdeleteLEN(&pei->loc, sizeof(pei->loc), &mudstate.exit_index_htab);
+    for (int i = 0; i < pei->nAliases; i++)
+    {
+        hashdeleteLEN(pei->aAliases[i].key, pei->aAliases[i].nKey,
+            &mudstate.exit_alias_htab);
+    }
+    pei->bStale = true;
+    pei->nRef++;
+    exitindex_release(pei);
+}
+
+void exitindex_drop(dbref loc)
+{
+    if (  !Good_dbref(loc)
+       || !mudstate.bfExitIndex.IsSet(loc))
+    {
+        return;
+    }
+
+    EXIT_INDEX *pei = (EXIT_INDEX *)hashfindLEN(&loc, sizeof(loc), &mudstate.exit_index_htab);
+    if (nullptr != pei)
+    {
+        exitindex_remove(pei);
+    }
+    else
+    {
+        mudstate.bfExitIndex.Clear(loc);
+    }
+}
+
+void exitindex_drop_all(void)
+{
+    EXIT_INDEX *pei;
+    while (nullptr != (pei = (EXIT_INDEX *)hash_firstentry(&mudstate.exit_index_htab)))
+    {
+        exitindex_remove(pei);
+    }
+}
+
+// The name or source of exit may be about to change.
+//
+void exitindex_touch(dbref exit)
+{
+    if (  Good_obj(exit)
+       && isExit(exit))
+    {
+        exitindex_drop(Exits(exit));
+    }
+}
+
+// Split an exit name into aliases the same way matches_exit_from_list()
+// does.  Leading white space is skipped after each delimiter, and trailing
+// white space is not part of an alias.
+//
+static int exitindex_split
+(
+    EXIT_INDEX *pei,
+    int pos,
+    const UTF8 *pName,
+    EXIT_INDEX_ENTRY *aEntries,
+    int nEntries,
+    int nMaxEntries
+)
+{
+    const UTF8 *p = pName;
+    while ('\0' != *p)
+    {
+        const UTF8 *q = p;
+        while (  '\0' != *q
+              && EXIT_DELIMITER != *q)
+        {
+            q++;
+        }
+
+        const UTF8 *r = q;
+        while (  p < r
+              && mux_isspace(r[-1]))
+        {
+            r--;
+        }
+
+        size_t nAlias = r - p;
+        if (EXIT_ALIAS_MAX <= nAlias)
+        {
+            pei->bFallback = true;
+        }
+        else if (nEntries < nMaxEntries)
+        {
+            EXIT_INDEX_ENTRY *pe = &aEntries[nEntries++];
+            pe->pos = pos;
+            pe->nAlias = nAlias;
+            pe->alias = (UTF8 *)MEMALLOC(nAlias + 1);
+            ISOUTOFMEMORY(pe->alias);
+            for (size_t i = 0; i < nAlias; i++)
+            {
+                pe->alias[i] = mux_tolower_ascii(p[i]);
+            }
+            pe->alias[nAlias] = '\0';
+        }
+
+        p = q;
+        if (EXIT_DELIMITER == *p)
+        {
+            p++;
+        }
+        while (mux_isspace(*p))
+        {
+            p++;
+        }
+    }
+    return nEntries;
+}
+
+static EXIT_INDEX *exitindex_load(dbref loc)
+{
+    EXIT_INDEX *pei;
+    if (mudstate.bfExitIndex.IsSet(loc))
+    {
+        pei = (EXIT_INDEX *)hashfindLEN(&loc, sizeof(loc), &mudstate.exit_index_htab);
+        if (nullptr != pei)
+        {
+            return pei;
+        }
+        mudstate.bfExitIndex.Clear(loc);
+    }
+
+    pei = new EXIT_INDEX;
+    pei->loc       = loc;
+    pei->nRef      = 0;
+    pei->bStale    = false;
+    pei->bFallback = false;
+    pei->nExits    = 0;
+    pei->aExits    = nullptr;
+    pei->nAliases  = 0;
+    pei->aAliases  = nullptr;
+
+    int nExits = 0;
+    int limit = mudstate.db_top;
+    dbref exit;
+    for (exit = Exits(loc); NOTHING != exit; exit = Next(exit))
+    {
+        nExits++;
+        if (  exit == Next(exit)
+           || --limit < 0)
+        {
+            break;
+        }
+    }
+
+    int nEntries = 0;
+    EXIT_INDEX_ENTRY *aEntries = nullptr;
+    if (0 < nExits)
+    {
+        pei->aExits = (dbref *)MEMALLOC(nExits * sizeof(dbref));
+        ISOUTOFMEMORY(pei->aExits);
+
+        // First pass to size the entries.
+        //
+        int nMaxEntries = 0;
+        exit = Exits(loc);
+        for (int pos = 0; pos < nExits; pos++, exit = Next(exit))
+        {
+            pei->aExits[pos] = exit;
+            nMaxEntries++;
+            for (const UTF8 *p = PureName(exit); '\0' != *p; p++)
+            {
+                if (EXIT_DELIMITER == *p)
+                {
+                    nMaxEntries++;
+                }
+            }
+        }
+        pei->nExits = nExits;
+
+        aEntries = (EXIT_INDEX_ENTRY *)MEMALLOC(nMaxEntries * sizeof(EXIT_INDEX_ENTRY));
+        ISOUTOFMEMORY(aEntries);
+        for (int pos = 0; pos < nExits; pos++)
+        {
+            nEntries = exitindex_split(pei, pos, PureName(pei->aExits[pos]),
+                aEntries, nEntries, nMaxEntries);
+        }
+    }
+
+    // Group the entries by alias.
+    //
+    if (0 < nEntries)
+    {
+        qsort(aEntries, nEntries, sizeof(EXIT_INDEX_ENTRY), exitindex_compare);
+
+        pei->aAliases = (EXIT_ALIAS *)MEMALLOC(nEntries * sizeof(EXIT_ALIAS));
+        ISOUTOFMEMORY(pei->aAliases);
+
+        int i = 0;
+        while (i < nEntries)
+        {
+            int j = i + 1;
+            while (  j < nEntries
+                  && aEntries[i].nAlias == aEntries[j].nAlias
+                  && 0 == memcmp(aEntries[i].alias, aEntries[j].alias, aEntries[i].nAlias))
+            {
+                j++;
+            }
+
+            EXIT_ALIAS *pea = &pei->aAliases[pei->nAliases++];
+            pea->nKey = sizeof(loc) + aEntries[i].nAlias;
+            pea->key = (UTF8 *)MEMALLOC(pea->nKey);
+            ISOUTOFMEMORY(pea->key);
+            memcpy(pea->key, &loc, sizeof(loc));
+            memcpy(pea->key + sizeof(loc), aEntries[i].alias, aEntries[i].nAlias);
+            pea->nPos = 0;
+            pea->aPos = (int *)MEMALLOC((j - i) * sizeof(int));
+            ISOUTOFMEMORY(pea->aPos);
+            for (int k = i; k < j; k++)
+            {
+                if (  0 == pea->nPos
+                   || pea->aPos[pea->nPos - 1] != aEntries[k].pos)
+                {
+                    pea->aPos[pea->nPos++] = aEntries[k].pos;
+                }
+            }
+            hashaddLEN(pea->key, pea->nKey, pea, &mudstate.exit_alias_htab);
+            i = j;
+        }
+    }
+
+    for (int i = 0; i < nEntries; i++)
+    {
+        MEMFREE(aEntries[i].alias);
+    }
+    if (nullptr != aEntries)
+    {
+        MEMFREE(aEntries);
+    }
+
+    hashaddLEN(&loc, sizeof(loc), pei, &mudstate.exit_index_htab);
+    mudstate.bfExitIndex.Set(loc);
+    return pei;
+}
+
+// Promote the exits of an indexed location which have md.string as an
+// alias.
+//
+static bool exitindex_match(EXIT_INDEX *pei, size_t nString, int local)
+{
+    if (EXIT_ALIAS_MAX <= nString)
+    {
+        return false;
+    }
+
+    UTF8 key[sizeof(dbref) + EXIT_ALIAS_MAX];
+    memcpy(key, &pei->loc, sizeof(pei->loc));
+    for (size_t i = 0; i < nString; i++)
+    {
+        key[sizeof(pei->loc) + i] = mux_tolower_ascii(md.string[i]);
+    }
+
+    EXIT_ALIAS *pea = (EXIT_ALIAS *)hashfindLEN(key, sizeof(pei->loc) + nString,
+        &mudstate.exit_alias_htab);
+    if (nullptr == pea)
+    {
+        return false;
+    }
+
+    // Promoting a match may evaluate a lock which changes the exits.
+    //
+    pei->nRef++;
+    for (int i = 0; i < pea->nPos; i++)
+    {
+        promote_match(pei->aExits[pea->aPos[i]], CON_COMPLETE | local);
+    }
+    exitindex_release(pei);
+    return true;
+}
+
 static bool match_exit_internal(dbref loc, dbref baseloc, int local)
 {
     if (  !Good_obj(loc)
@@ -408,6 +768,22 @@ static bool match_exit_internal(dbref loc, dbref baseloc, int local)
         return true;
     }
 
+    // A dbref is matched against the exits themselves, and a string which
+    // still ends in white space cannot be trimmed the way aliases are, so
+    // both take the long way.
+    //
+    size_t nString = strlen((char *)md.string);
+    if (  NOTHING == md.absolute_form
+       && (  0 == nString
+          || !mux_isspace(md.string[nString - 1])))
+    {
+        EXIT_INDEX *pei = exitindex_load(loc);
+        if (!pei->bFallback)
+        {
+            return exitindex_match(pei, nString, local);
+        }
+    }
+
     dbref exit;
     bool result = false;
     int key;
@@ -59,6 +59,9 @@ extern dbref match_thing(dbref player, const UTF8 *name);
 extern dbref match_thing_quiet(dbref player, const UTF8 *name);
 extern dbref match_thing_quiet(dbref player, const UTF8 *name, size_t n);
 extern void safe_match_result(dbref it, UTF8 *buff, UTF8 **bufc);
+extern void exitindex_drop(dbref loc);
+extern void exitindex_drop_all(void);
+extern void exitindex_touch(dbref exit);
 
 #define MAT_NO_EXITS        1   /* Don't check for exits */
 #define MAT_EXIT_PARENTS    2   /* Check for exits in parents */
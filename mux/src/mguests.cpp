@@ -166,6 +166,7 @@ const UTF8 *CGuests::Create(DESC *d)
             // Copy flags from guest prototype.
             //
             db[guest_player].fs = db[mudconf.guest_char].fs;
+            db_dirty(guest_player);
 
             // Strip flags, enforce PLAYER type.
             //
@@ -334,6 +335,7 @@ dbref CGuests::MakeGuestChar(void)
     FLAGSET f = db[mudconf.guest_char].fs;
     f.word[FLAG_WORD1] |= TYPE_PLAYER;
     db[player].fs = f;
+    db_dirty(player);
 
     // Strip flags.
     //
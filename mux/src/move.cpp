@@ -203,6 +203,8 @@ void move_object(dbref thing, dbref dest)
     if (src != NOTHING)
     {
         s_Contents(src, remove_first(Contents(src), thing));
+        cmdindex_drop(src);
+        hearlist_drop(src);
     }
 
     // Special check for HOME
@@ -211,6 +213,8 @@ void move_object(dbref thing, dbref dest)
     {
         dest = Home(thing);
     }
+    cmdindex_drop(dest);
+    hearlist_drop(dest);
 
     // Add to destination location
     //
@@ -246,6 +250,8 @@ static void move_the_exit(dbref thing, dbref dest)
     s_Exits(exitloc, remove_first(Exits(exitloc), thing));
     s_Exits(dest, insert_first(Exits(dest), thing));
     s_Exits(thing, dest);
+    exitindex_drop(exitloc);
+    exitindex_drop(dest);
 }
 
 /* ---------------------------------------------------------------------------
@@ -307,6 +313,8 @@ static void process_sticky_dropto(dbref loc, dbref player)
     //
     dbref next;
     s_Contents(loc, reverse_list(Contents(loc)));
+    cmdindex_drop(loc);
+    hearlist_drop(loc);
     SAFE_DOLIST(thing, next, Contents(loc))
     {
         send_dropto(thing, player);
@@ -870,6 +878,8 @@ void do_get(dbref executor, dbref caller, dbref enactor, int eval, int key, UTF8
         s_Exits(thingloc, remove_first(Exits(thingloc), thing));
         s_Exits(executor, insert_first(Exits(executor), thing));
         s_Exits(thing, executor);
+        exitindex_drop(thingloc);
+        exitindex_drop(executor);
         if (!Quiet(executor))
         {
             notify(executor, T("Exit taken."));
@@ -985,6 +995,8 @@ void do_drop(dbref executor, dbref caller, dbref enactor, int eval, int key, UTF
         s_Exits(exitloc, remove_first(Exits(exitloc), thing));
         s_Exits(loc, insert_first(Exits(loc), thing));
         s_Exits(thing, loc);
+        exitindex_drop(exitloc);
+        exitindex_drop(loc);
 
         if (!Quiet(executor))
         {
@@ -41,6 +41,7 @@ struct confdata
     bool    compress_db;        // should we use compress.
     bool    dark_sleepers;      /* Are sleeping players 'dark'? */
     bool    destroy_going_now;  // Does GOING act like DESTROY_OK?
+    bool    dump_snapshot;      // Write and load binary snapshots of the db.
     bool    eval_comtitle;      /* Should Comtitles Evaluate? */
     bool    ex_flags;           /* true = show flags on examine */
     bool    exam_public;        /* Does EXAM show public attrs by default? */
@@ -51,6 +52,7 @@ struct confdata
     bool    have_zones;         // Should zones be active?
     bool    idle_wiz_dark;      /* Do idling wizards get set dark? */
     bool    indent_desc;        // Newlines before and after descs?
+    bool    journal;            // Keep a write-ahead journal between dumps.
     bool    match_mine;         /* Should you check yourself for $-commands? */
     bool    match_mine_pl;      /* Should players check selves for $-cmds? */
     bool    name_spaces;        // allow player names to have spaces.
@@ -106,13 +108,14 @@ struct confdata
     int     createmax;          /* max cost of @create command */
     int     createmin;          /* default (and minimum) cost of @create cmd */
     int     digcost;            /* cost of @dig command */
+    int     dump_deltas;        /* incremental dumps between full dumps */
     int     dump_interval;      /* interval between ckp dumps in seconds */
     int     dump_offset;        /* when to take first checkpoint dump */
     int     events_daily_hour;  /* At what hour should @daily be executed? */
     int     exit_quota;         /* quota needed to make an exit */
     int     func_invk_lim;      /* Max funcs invoked by a command */
     int     func_nest_lim;      /* Max nesting of functions */
-    int     idle_interval;      /* when to check for idle users */
+    int     idle_interval;      /* obsolete: sessions watch their own timeouts */
     int     idle_timeout;       /* Boot off players idle this long in secs */
     int     init_size;          // initial db size.
     int     keepalive_interval; /* when to send keep alive */
@@ -166,6 +169,8 @@ struct confdata
     int     player_quota;       /* quota needed to make a robot player */
     int     pcreate_per_hour;   // Maximum allowed players created per hour */
     int     queue_chunk;        /* # cmds to run from queue when idle */
+    int     queue_wizard_weight; // Queue share of a Wizard-owned object
+    int     queue_cpu_limit;    // Default CPU budget of one queue entry in milliseconds
     int     queuemax;           /* max commands a player may have in queue */
     int     references_per_hour;/* Maximum allowed @reference adds per hour per object */
     int     retry_limit;        /* close conn after this many bad logins */
@@ -247,6 +252,7 @@ struct confdata
     UTF8    *game_pag;          /* use this game CHashFile PAG file if we need one */
     UTF8    *guest_file;        /* display if guest connects */
     UTF8    *indb;              /* database file name */
+    UTF8    *journal_db;        // write-ahead journal file name
     UTF8    *log_dir;           /* directory for logging from the cmd line */
     UTF8    *mail_db;           /* name of the @mail database */
     UTF8    *motd_file;         /* display this file on login */
@@ -262,7 +268,9 @@ struct confdata
     unsigned char    markdata[8];  /* Masks for marking/unmarking */
     CLinearTimeDelta rpt_cmdsecs;  /* Reporting Threshhold for time taken by command */
     CLinearTimeDelta max_cmdsecs;  /* Upper Limit for real time taken by command */
+    CLinearTimeDelta slow_cmdsecs; // Threshold for the slow command log.
     CLinearTimeDelta cache_tick_period; // Minor cycle for cache maintenance.
+    CLinearTimeDelta journal_commit_period; // How often is the journal made durable?
     CLinearTimeDelta timeslice;         // How often do we bump people's cmd quotas?
 
     FLAGSET exit_flags;         /* Flags exits start with */
@@ -453,6 +461,10 @@ struct statedata
 
     dbref   curr_enactor;       /* Who initiated the current command */
     dbref   curr_executor;      /* Who is running the current command */
+    dbref   que_src_thing;      // Object of the $-command being queued
+    int     que_src_atr;        // Attribute of the $-command being queued
+    dbref   run_src_thing;      // Object of the $-command being run
+    int     run_src_atr;        // Attribute of the $-command being run
     dbref   freelist;           /* Head of object freelist */
     dbref   mod_al_id;          /* Where did mod_alist come from? */
     dbref   poutobj;            /* Object doing the piping */
@@ -460,6 +472,8 @@ struct statedata
     int     attr_next;          /* Next attr to alloc when freelist is empty */
     int     db_size;            /* Allocated size of db structure */
     int     db_top;             /* Number of items in the db */
+    int     checkpoint_base;    // Generation of the last full dump.
+    int     checkpoint_delta;   // Incremental dumps written on top of it.
     int     epoch;              /* Generation number for dumps */
     int     events_flag;        /* Flags for check_events */
     int     func_invk_ctr;      /* Functions invoked so far by this command */
@@ -526,8 +540,6 @@ struct statedata
     CLinearTimeAbsolute cpu_count_from; /* When did we last reset CPU counters? */
     CLinearTimeAbsolute dump_counter;   /* Countdown to next db dump */
     CLinearTimeAbsolute events_counter; /* Countdown to next events check */
-    CLinearTimeAbsolute idle_counter;   /* Countdown to next idle check */
-    CLinearTimeAbsolute keepalive_counter; /* Countdown to next keep alive cycle */
     CLinearTimeAbsolute start_time;     /* When was MUX started */
     CLinearTimeAbsolute restart_time;   /* When was MUX restarted */
     CLinearTimeAbsolute tThrottleExpired; // How much time is left in this hour of throttling.
@@ -545,6 +557,14 @@ struct statedata
     CHashTable logout_cmd_htab; /* Logged-out commands hashtable (WHO, etc) */
     CHashTable mail_htab;       /* Mail players hashtable */
     CHashTable parent_htab;     /* Parent $-command exclusion */
+    CHashTable cmd_word_htab;   // Literal first words of cached $-commands and ^-listens
+    CHashTable cmd_index_htab;  // Room command indexes
+    CHashTable lock_htab;       // Compiled locks
+    CHashTable hear_list_htab;  // Hearer lists
+    CHashTable exit_index_htab; // Room exit indexes
+    CHashTable exit_alias_htab; // Exit aliases of indexed rooms
+    CHashTable name_index_htab; // Objects by the prefixes of their names
+    CHashTable latency_htab;    // Command latency histograms
     CHashTable player_htab;     /* Player name->number hashtable */
     CHashTable powers_htab;     /* Powers hashtable */
     CHashTable reference_htab;  /* @reference hashtable */
@@ -556,6 +576,12 @@ struct statedata
     CBitField bfNoCommands;     // Cache knowledge that there are no $-Commands.
     CBitField bfCommands;       // Cache knowledge that there are $-Commands.
     CBitField bfListens;        // Cache knowledge that there are ^-Commands.
+    CBitField bfCmdIndex;       // Rooms with a command index.
+    CBitField bfAttrResolve;    // Objects on a cached attribute inheritance chain.
+    CBitField bfLockCache;      // Objects with a compiled lock.
+    CBitField bfHearList;       // Locations with a hearer list.
+    CBitField bfExitIndex;      // Locations with an exit index.
+    CBitField bfLatency;        // Objects with attribute latency histograms.
 
     CBitField bfReport;         // Used for LROOMS.
     CBitField bfTraverse;       // Used for LROOMS.
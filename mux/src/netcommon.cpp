@@ -98,39 +98,42 @@ void make_port_ulist(dbref player, UTF8 *buff, UTF8 **bufc)
 }
 
 /* ---------------------------------------------------------------------------
- * update_quotas: Update timeslice quotas
+ * update_quota: Credit the timeslices which have passed since the
+ * descriptor's quota was last brought up to date.
  */
 
-void update_quotas(CLinearTimeAbsolute& ltaLast, const CLinearTimeAbsolute& ltaCurrent)
+static void update_quota(DESC *d, const CLinearTimeAbsolute& ltaCurrent)
 {
-    if (ltaCurrent < ltaLast)
+    if (ltaCurrent < d->quota_time)
     {
-        ltaLast = ltaCurrent;
+        d->quota_time = ltaCurrent;
         return;
     }
 
-    CLinearTimeDelta ltdDiff = ltaCurrent - ltaLast;
+    CLinearTimeDelta ltdDiff = ltaCurrent - d->quota_time;
     if (ltdDiff < mudconf.timeslice)
     {
         return;
     }
 
+    // A descriptor may have been quiet for a long time, so the credit is
+    // figured in 64 bits.
+    //
     int nSlices = ltdDiff / mudconf.timeslice;
-    int nExtraQuota = mudconf.cmd_quota_incr * nSlices;
+    INT64 nExtraQuota = static_cast<INT64>(mudconf.cmd_quota_incr) * nSlices;
 
     if (nExtraQuota > 0)
     {
-        DESC *d;
-        DESC_ITER_ALL(d)
+        if (mudconf.cmd_quota_max - d->quota < nExtraQuota)
         {
-            d->quota += nExtraQuota;
-            if (d->quota > mudconf.cmd_quota_max)
-            {
-                d->quota = mudconf.cmd_quota_max;
-            }
+            d->quota = mudconf.cmd_quota_max;
+        }
+        else
+        {
+            d->quota += static_cast<int>(nExtraQuota);
         }
     }
-    ltaLast += mudconf.timeslice * nSlices;
+    d->quota_time += mudconf.timeslice * nSlices;
 }
 
 /* raw_notify_html() -- raw_notify() without the newline */
@@ -772,6 +775,10 @@ void welcome_user(DESC *d)
     {
         fcache_dump(d, FC_CONN);
     }
+
+    // Watch for the login timeout.
+    //
+    desc_recheck_idle(d);
 }
 
 void save_command(DESC *d, CBLK *command)
@@ -945,9 +952,12 @@ static void announce_connect(dbref player, DESC *d)
             d->timeout = mudconf.idle_timeout;
         }
     }
+    desc_recheck_idle(d);
+    desc_start_keepalive(d);
 
     dbref loc = Location(player);
     s_Connected(player);
+    hearlist_touch(player);
 
     if (d->flags & DS_PUEBLOCLIENT)
     {
@@ -1016,6 +1026,7 @@ static void announce_connect(dbref player, DESC *d)
     if (Guest(player))
     {
         db[player].fs.word[FLAG_WORD1] &= ~DARK;
+        db_dirty(player);
     }
 
     const UTF8 *pRoomAnnounceFmt;
@@ -1231,6 +1242,7 @@ void announce_disconnect(dbref player, DESC *d, const UTF8 *reason)
         raw_broadcast(MONITOR, T("GAME: %s has disconnected. <%s>"), Moniker(player), reason);
 
         c_Connected(player);
+        hearlist_touch(player);
 
         if (mudconf.have_comsys)
         {
@@ -1334,11 +1346,13 @@ void announce_disconnect(dbref player, DESC *d, const UTF8 *reason)
         {
             d->flags &= ~DS_AUTODARK;
             db[player].fs.word[FLAG_WORD1] &= ~DARK;
+            db_dirty(player);
         }
 
         if (Guest(player))
         {
             db[player].fs.word[FLAG_WORD1] |= DARK;
+            db_dirty(player);
             halt_que(NOTHING, player);
         }
     }
@@ -1453,6 +1467,7 @@ void desc_reload(dbref player)
             }
         }
         free_lbuf(buf);
+        desc_recheck_idle(d);
     }
 }
 
@@ -1583,80 +1598,218 @@ int fetch_connect(dbref target)
 // The AUTODARK state is also cleared when the last idle session is
 // disconnected from the server (session shutdown or @shutdown).
 //
-void check_idle(void)
+// Each descriptor has its own idle check task, scheduled for when the
+// descriptor could first reach its timeout. Input does not move the task.
+// Instead, a check which finds that the descriptor has been active since
+// puts the task back for the new deadline. A descriptor without a timeout
+// has no task until something which might give it one changes.
+//
+static void schedule_idle_check(DESC *d, const CLinearTimeAbsolute& ltaWhen)
 {
-    DESC *d, *dnext;
+    if (nullptr != d->idle_task)
+    {
+        scheduler.RemoveTask(d->idle_task);
+    }
+    d->idle_task = scheduler.DeferTask(ltaWhen, PRIORITY_SYSTEM, Task_IdleCheck, d, 0);
+}
 
+// Check the descriptor again as soon as possible. Its deadline may have
+// moved closer.
+//
+void desc_recheck_idle(DESC *d)
+{
     CLinearTimeAbsolute ltaNow;
     ltaNow.GetUTC();
+    schedule_idle_check(d, ltaNow);
+}
 
-    DESC_SAFEITER_ALL(d, dnext)
+void desc_recheck_idle_all(void)
+{
+    DESC *d;
+    DESC_ITER_ALL(d)
     {
-        if (d->flags & DS_AUTODARK)
+        desc_recheck_idle(d);
+    }
+}
+
+// Returns true if the descriptor should be checked again at ltaNext, and
+// false if it was shut down or has no timeout.
+//
+static bool check_idle(DESC *d, const CLinearTimeAbsolute& ltaNow, CLinearTimeAbsolute& ltaNext)
+{
+    CLinearTimeDelta ltdTimeout;
+    CLinearTimeAbsolute ltaDeadline;
+    if (d->flags & DS_CONNECTED)
+    {
+        if (mudconf.idle_timeout <= 0)
         {
-            continue;
+            // Idle timeout checking on connected players is effectively disabled.
+            // PennMUSH uses idle_timeout == 0. Rhost uses idel_timeout == -1.
+            // We will be disabled for either setting.
+            //
+            return false;
         }
-        if (d->flags & DS_CONNECTED)
+
+        if (Can_Idle(d->player))
         {
-            if (mudconf.idle_timeout <= 0)
-            {
-                // Idle timeout checking on connected players is effectively disabled.
-                // PennMUSH uses idle_timeout == 0. Rhost uses idel_timeout == -1.
-                // We will be disabled for either setting.
-                //
-                continue;
-            }
+            ltdTimeout.SetSeconds(mudconf.idle_timeout);
+        }
+        else
+        {
+            ltdTimeout.SetSeconds(d->timeout);
+        }
+        ltaDeadline = d->last_time + ltdTimeout;
+    }
+    else if (0 < mudconf.conn_timeout)
+    {
+        ltdTimeout.SetSeconds(mudconf.conn_timeout);
+        ltaDeadline = d->connected_at + ltdTimeout;
+    }
+    else
+    {
+        return false;
+    }
+
+    // Idle time is compared in whole seconds, so a timeout is only exceeded
+    // a second after it is used up. Rounding up to the next whole second
+    // also lets descriptors which expire close together share a wakeup.
+    //
+    ltaDeadline += time_1s;
+    INT64 t = ltaDeadline.Return100ns();
+    INT64 r = t % FACTOR_100NS_PER_SECOND;
+    if (0 < r)
+    {
+        ltaDeadline.Set100ns(t + FACTOR_100NS_PER_SECOND - r);
+    }
+
+    if (ltaNow < ltaDeadline)
+    {
+        ltaNext = ltaDeadline;
+        return true;
+    }
+
+    if (!(d->flags & DS_CONNECTED))
+    {
+        queue_write(d, T("*** Login Timeout ***\r\n"));
+        shutdownsock(d, R_TIMEOUT);
+        return false;
+    }
+
+    if (!Can_Idle(d->player))
+    {
+        queue_write(d, T("*** Inactivity Timeout ***\r\n"));
+        shutdownsock(d, R_TIMEOUT);
+        return false;
+    }
 
-            CLinearTimeDelta ltdIdle = ltaNow - d->last_time;
-            if (Can_Idle(d->player))
+    // Sessions which may idle are looked at again a timeout from now.
+    //
+    ltaNext = ltaNow + ltdTimeout;
+    if (  !(d->flags & DS_AUTODARK)
+       && mudconf.idle_wiz_dark
+       && (Flags(d->player) & (WIZARD|DARK)) == WIZARD)
+    {
+        // Make sure this Wizard player does not have some other
+        // active session.
+        //
+        DESC *d1;
+        bool bFound = false;
+        DESC_ITER_PLAYER(d->player, d1)
+        {
+            if (d1 != d)
             {
-                if (  mudconf.idle_wiz_dark
-                   && (Flags(d->player) & (WIZARD|DARK)) == WIZARD
-                   && ltdIdle.ReturnSeconds() > mudconf.idle_timeout)
+                CLinearTimeDelta ltd = ltaNow - d1->last_time;
+                if (ltd.ReturnSeconds() <= mudconf.idle_timeout)
                 {
-                    // Make sure this Wizard player does not have some other
-                    // active session.
-                    //
-                    DESC *d1;
-                    bool bFound = false;
-                    DESC_ITER_PLAYER(d->player, d1)
-                    {
-                        if (d1 != d)
-                        {
-                            CLinearTimeDelta ltd = ltaNow - d1->last_time;
-                            if (ltd.ReturnSeconds() <= mudconf.idle_timeout)
-                            {
-                                 bFound = true;
-                                 break;
-                            }
-                        }
-                    }
-                    if (!bFound)
-                    {
-                        db[d->player].fs.word[FLAG_WORD1] |= DARK;
-                        DESC_ITER_PLAYER(d->player, d1)
-                        {
-                            d1->flags |= DS_AUTODARK;
-                        }
-                    }
+                     bFound = true;
+                     break;
                 }
             }
-            else if (ltdIdle.ReturnSeconds() > d->timeout)
-            {
-                queue_write(d, T("*** Inactivity Timeout ***\r\n"));
-                shutdownsock(d, R_TIMEOUT);
-            }
         }
-        else if (0 < mudconf.conn_timeout)
+        if (!bFound)
         {
-            CLinearTimeDelta ltdIdle = ltaNow - d->connected_at;
-            if (ltdIdle.ReturnSeconds() > mudconf.conn_timeout)
+            db[d->player].fs.word[FLAG_WORD1] |= DARK;
+            db_dirty(d->player);
+            DESC_ITER_PLAYER(d->player, d1)
             {
-                queue_write(d, T("*** Login Timeout ***\r\n"));
-                shutdownsock(d, R_TIMEOUT);
+                d1->flags |= DS_AUTODARK;
             }
         }
     }
+    return true;
+}
+
+void Task_IdleCheck(void *arg_voidptr, int arg_iInteger)
+{
+    UNUSED_PARAMETER(arg_iInteger);
+
+    DESC *d = (DESC *)arg_voidptr;
+    d->idle_task = nullptr;
+
+    if (mudconf.control_flags & CF_IDLECHECK)
+    {
+        CLinearTimeAbsolute ltaNow, ltaNext;
+        ltaNow.GetUTC();
+
+        const UTF8 *cmdsave = mudstate.debug_cmd;
+        mudstate.debug_cmd = T("< idlecheck >");
+        bool bAgain = check_idle(d, ltaNow, ltaNext);
+        mudstate.debug_cmd = cmdsave;
+        if (bAgain)
+        {
+            schedule_idle_check(d, ltaNext);
+        }
+    }
+}
+
+// Connected descriptors of players who want keepalives have a keepalive
+// task. It lapses when the player no longer wants them.
+//
+void desc_start_keepalive(DESC *d)
+{
+    if (  nullptr == d->keepalive_task
+       && (d->flags & DS_CONNECTED)
+       && KeepAlive(d->player))
+    {
+        CLinearTimeAbsolute ltaNow;
+        ltaNow.GetUTC();
+        CLinearTimeDelta ltd;
+        ltd.SetSeconds(mudconf.keepalive_interval);
+        d->keepalive_task = scheduler.DeferTask(ltaNow + ltd, PRIORITY_SYSTEM,
+            Task_KeepAlive, d, 0);
+    }
+}
+
+void Task_KeepAlive(void *arg_voidptr, int arg_iInteger)
+{
+    UNUSED_PARAMETER(arg_iInteger);
+
+    DESC *d = (DESC *)arg_voidptr;
+    d->keepalive_task = nullptr;
+    if (  (d->flags & DS_CONNECTED)
+       && KeepAlive(d->player))
+    {
+        // Send a Telnet NOP code - creates traffic to keep NAT routers
+        // happy.
+        //
+        const UTF8 aNOP[2] = { NVT_IAC, NVT_NOP };
+        queue_write_LEN(d, aNOP, sizeof(aNOP));
+        desc_start_keepalive(d);
+    }
+}
+
+void desc_stop_timers(DESC *d)
+{
+    if (nullptr != d->idle_task)
+    {
+        scheduler.RemoveTask(d->idle_task);
+        d->idle_task = nullptr;
+    }
+    if (nullptr != d->keepalive_task)
+    {
+        scheduler.RemoveTask(d->keepalive_task);
+        d->keepalive_task = nullptr;
+    }
 }
 
 void check_events(void)
@@ -2437,6 +2590,7 @@ static bool check_connect(DESC *d, UTF8 *msg)
                   || God(player)))
             {
                 db[player].fs.word[FLAG_WORD1] |= DARK;
+                db_dirty(player);
             }
 
             // Make sure we don't have a guest from an unwanted host.
@@ -2924,6 +3078,9 @@ void Task_ProcessCommand(void *arg_voidptr, int arg_iInteger)
         CBLK *t = d->input_head;
         if (t)
         {
+            CLinearTimeAbsolute ltaNow;
+            ltaNow.GetUTC();
+            update_quota(d, ltaNow);
             if (d->quota > 0)
             {
                 d->quota--;
@@ -2939,7 +3096,7 @@ void Task_ProcessCommand(void *arg_voidptr, int arg_iInteger)
                     d->input_tail = nullptr;
                 }
                 d->input_size -= strlen((char *)t->cmd);
-                d->last_time.GetUTC();
+                d->last_time = ltaNow;
                 if (d->program_data != nullptr)
                 {
                     handle_prog(d, t->cmd);
@@ -2952,12 +3109,9 @@ void Task_ProcessCommand(void *arg_voidptr, int arg_iInteger)
             }
             else
             {
-                // Don't bother looking for more quota until at least this much time has past.
+                // No more quota until the next timeslice is credited.
                 //
-                CLinearTimeAbsolute lsaWhen;
-                lsaWhen.GetUTC();
-
-                scheduler.DeferTask(lsaWhen + mudconf.timeslice, PRIORITY_SYSTEM, Task_ProcessCommand, d, 0);
+                scheduler.DeferTask(d->quota_time + mudconf.timeslice, PRIORITY_SYSTEM, Task_ProcessCommand, d, 0);
             }
         }
     }
@@ -483,6 +483,7 @@ dbref create_obj(dbref player, int objtype, const UTF8 *name, int cost)
     s_Contents(obj, NOTHING);
     s_Exits(obj, NOTHING);
     s_Next(obj, NOTHING);
+    s_Prev(obj, NOTHING);
     s_Link(obj, NOTHING);
 
     if (Good_obj(target_parent))
@@ -504,6 +505,7 @@ dbref create_obj(dbref player, int objtype, const UTF8 *name, int cost)
     }
     f.word[FLAG_WORD1] |= objtype;
     db[obj].fs = f;
+    db_dirty(obj);
     s_Owner(obj, (self_owned ? obj : owner));
     s_Pennies(obj, value);
     Unmark(obj);
@@ -511,6 +513,11 @@ dbref create_obj(dbref player, int objtype, const UTF8 *name, int cost)
     s_Name(obj, buff);
     free_lbuf(buff); buff = nullptr;
     db[obj].cpu_time_used.Set100ns(0);
+    db[obj].queue_cpu_time.Set100ns(0);
+    db[obj].cpu_max = -1;
+#ifdef REALITY_LVLS
+    db[obj].iRLevel = -1;
+#endif // REALITY_LVLS
 
     db[obj].tThrottleExpired.Set100ns(0);
     s_ThAttrib(obj, 0);
@@ -570,10 +577,14 @@ static void destroy_bad_obj(dbref obj)
     s_Flags(obj, FLAG_WORD3, 0);
     s_Powers(obj, 0);
     s_Powers2(obj, 0);
+    hearlist_touch(obj);
+    hearlist_drop(obj);
+    exitindex_drop(obj);
     s_Location(obj, NOTHING);
     s_Contents(obj, NOTHING);
     s_Exits(obj, NOTHING);
     s_Next(obj, NOTHING);
+    s_Prev(obj, NOTHING);
     s_Link(obj, NOTHING);
     s_Owner(obj, GOD);
     s_Pennies(obj, 0);
@@ -690,10 +701,14 @@ void destroy_obj(dbref obj)
     s_Flags(obj, FLAG_WORD3, 0);
     s_Powers(obj, 0);
     s_Powers2(obj, 0);
+    hearlist_touch(obj);
+    hearlist_drop(obj);
+    exitindex_drop(obj);
     s_Location(obj, NOTHING);
     s_Contents(obj, NOTHING);
     s_Exits(obj, NOTHING);
     s_Next(obj, NOTHING);
+    s_Prev(obj, NOTHING);
     s_Link(obj, NOTHING);
     s_Owner(obj, GOD);
     s_Pennies(obj, 0);
@@ -827,6 +842,7 @@ void destroy_exit(dbref exit)
 {
     dbref loc = Exits(exit);
     s_Exits(loc, remove_first(Exits(loc), exit));
+    exitindex_drop(loc);
     destroy_obj(exit);
 }
 
@@ -887,6 +903,7 @@ static void purge_going(void)
                 log_text(T("GOING object doesn\xE2\x80\x99t remember its destroyer. GOING reset."));
                 ENDLOG;
                 db[i].fs.word[FLAG_WORD1] &= ~GOING;
+                db_dirty(i);
             }
             else
             {
@@ -1877,10 +1894,31 @@ void do_dbck(dbref executor, dbref caller, dbref enactor, int eval, int key)
     UNUSED_PARAMETER(eval);
 
     check_type = key;
+    cmdindex_drop_all();
+    hearlist_drop_all();
+    exitindex_drop_all();
     check_dead_refs();
     check_exit_chains();
     check_contents_chains();
     check_floating();
+
+    // The indexes and the contents and exits back links are kept up to date
+    // as objects change, so they are only verified here.  Damage is logged,
+    // and only then are they rebuilt.
+    //
+    int nDamaged = db_index_check();
+    if (0 < nDamaged)
+    {
+        db_link_lists();
+        db_index_rebuild();
+    }
+    if (  (check_type & DBCK_INDEX)
+       && !mudstate.bStandAlone
+       && Good_obj(executor))
+    {
+        notify(executor, tprintf(T("%d damaged index%s found."), nDamaged,
+            (1 == nDamaged) ? T("") : T("es")));
+    }
     if (  !mudstate.bStandAlone
        && executor != NOTHING)
     {
@@ -19,6 +19,7 @@
 #include "attrs.h"
 #include "command.h"
 #include "interface.h"
+#include "journal.h"
 #include "mathutil.h"
 #include "powers.h"
 #ifdef REALITY_LVLS
@@ -47,31 +48,60 @@ void DCL_CDECL safe_tprintf_str(UTF8 *str, UTF8 **bp, __in_z const UTF8 *fmt,...
 
 /* ---------------------------------------------------------------------------
  * insert_first, remove_first: Insert or remove objects from lists.
+ *
+ * Contents and exits lists are linked both ways, so an object can be
+ * unlinked without walking the list to find the one before it.
  */
 
 dbref insert_first(dbref head, dbref thing)
 {
     s_Next(thing, head);
+    s_Prev(thing, NOTHING);
+    if (Good_dbref(head))
+    {
+        s_Prev(head, thing);
+    }
     return thing;
 }
 
 dbref remove_first(dbref head, dbref thing)
 {
+    dbref next = Next(thing);
     if (head == thing)
     {
-        return Next(thing);
+        if (Good_dbref(next))
+        {
+            s_Prev(next, NOTHING);
+        }
+        s_Prev(thing, NOTHING);
+        return next;
     }
 
-    dbref prev;
-
-    DOLIST(prev, head)
+    dbref prev = Prev(thing);
+    if (  !Good_dbref(prev)
+       || Next(prev) != thing)
     {
-        if (Next(prev) == thing)
+        // The back link is missing, so look for it the long way.
+        //
+        DOLIST(prev, head)
+        {
+            if (Next(prev) == thing)
+            {
+                break;
+            }
+        }
+        if (NOTHING == prev)
         {
-            s_Next(prev, Next(thing));
             return head;
         }
     }
+
+    s_Next(prev, next);
+    if (Good_dbref(next))
+    {
+        s_Prev(next, prev);
+    }
+    s_Prev(thing, NOTHING);
     return head;
 }
 
@@ -88,17 +118,30 @@ dbref reverse_list(dbref list)
     {
         rest = Next(list);
         s_Next(list, newlist);
+        if (NOTHING != newlist)
+        {
+            s_Prev(newlist, list);
+        }
         newlist = list;
         list = rest;
     }
+    if (NOTHING != newlist)
+    {
+        s_Prev(newlist, NOTHING);
+    }
     return newlist;
 }
 
 /* ---------------------------------------------------------------------------
  * member - indicate if thing is in list
+ *
+ * Apart from the head, an object is in a list when the object before it
+ * links to it, and the list is the one its location (or for an exit, its
+ * source) holds.  Where the back link disagrees with the forward links, as
+ * it may while @dbck is repairing them, the list is walked instead.
  */
 
-bool member(dbref thing, dbref list)
+static bool member_walk(dbref thing, dbref list)
 {
     DOLIST(list, list)
     {
@@ -110,6 +153,62 @@ bool member(dbref thing, dbref list)
     return false;
 }
 
+// The list which thing's location (or for an exit, its source) holds.
+//
+static dbref member_head(dbref thing)
+{
+    dbref loc = isExit(thing) ? Exits(thing) : Location(thing);
+    if (!Good_obj(loc))
+    {
+        return NOTHING;
+    }
+    return isExit(thing) ? Exits(loc) : Contents(loc);
+}
+
+static bool member_linked(dbref thing, dbref list, bool *pbMember)
+{
+    if (thing == list)
+    {
+        *pbMember = true;
+        return true;
+    }
+
+    dbref prev = Prev(thing);
+    if (NOTHING == prev)
+    {
+        // thing heads a list, so it is only in list if it heads that one.
+        //
+        *pbMember = false;
+        return member_head(thing) == thing;
+    }
+    else if (  Good_dbref(prev)
+            && Next(prev) == thing)
+    {
+        *pbMember = (member_head(thing) == list);
+        return true;
+    }
+    return false;
+}
+
+bool member(dbref thing, dbref list)
+{
+    if (  NOTHING == list
+       || !Good_dbref(thing))
+    {
+        return false;
+    }
+
+    bool bMember;
+    if (!member_linked(thing, list, &bMember))
+    {
+        return member_walk(thing, list);
+    }
+#ifdef SELFCHECK
+    mux_assert(bMember == member_walk(thing, list));
+#endif // SELFCHECK
+    return bMember;
+}
+
 bool could_doit(dbref player, dbref thing, int locknum)
 {
     if (thing == HOME)
@@ -129,12 +228,7 @@ bool could_doit(dbref player, dbref thing, int locknum)
         return true;
     }
 
-    dbref aowner;
-    int   aflags;
-    UTF8 *key = atr_get("could_doit.134", thing, locknum, &aowner, &aflags);
-    bool doit = eval_boolexp_atr(player, thing, thing, key);
-    free_lbuf(key);
-    return doit;
+    return eval_boolexp_lock(player, player, thing, thing, locknum);
 }
 
 bool can_see(dbref player, dbref thing, bool can_see_loc)
@@ -1631,6 +1725,7 @@ void do_restart(dbref executor, dbref caller, dbref enactor, int eval, int key)
     al_store();
 #endif
     pcache_sync();
+    journal_close();
     dump_database_internal(DUMP_I_RESTART);
     SYNC;
     CLOSE;
@@ -1648,6 +1743,7 @@ void do_restart(dbref executor, dbref caller, dbref enactor, int eval, int key)
 #endif // HAVE_WORKING_FORK
 
     Log.StopLogging();
+    SlowLog.StopLogging();
 
 #ifdef GAME_DOOFERMUX
     execl("bin/netmux", mudconf.mud_name, "-c", mudconf.config_file, "-p",
@@ -27,13 +27,11 @@ static int count_quota(dbref player)
     }
     int q = 0 - mudconf.player_quota;
 
-    dbref i;
-    DO_WHOLE_DB(i)
+    dbref *aOwned;
+    int nOwned = db_index_gather(DBI_OWNER, player, &aOwned);
+    for (int k = 0; k < nOwned; k++)
     {
-        if (Owner(i) != player)
-        {
-            continue;
-        }
+        dbref i = aOwned[k];
         if (Going(i) && (!isRoom(i)))
         {
             continue;
@@ -61,6 +59,10 @@ static int count_quota(dbref player)
             break;
         }
     }
+    if (nullptr != aOwned)
+    {
+        MEMFREE(aOwned);
+    }
     return q;
 }
 
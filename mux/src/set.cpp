@@ -143,7 +143,7 @@ void do_chzone
 
     // Everything is okay, do the change.
     //
-    db[thing].zone = zone;
+    s_Zone(thing, zone);
     if (!isPlayer(thing))
     {
         // If the object is a player, resetting these flags is rather
@@ -814,6 +814,8 @@ void SetClearFlags
             db[thing].fs.word[j] |= aSetFlags[j];
         }
     }
+    db_dirty(thing);
+    hearlist_touch(thing);
 }
 
 /*
@@ -0,0 +1,819 @@
+/*! \file snapshot.cpp
+ * \brief Binary database snapshots for fast startup.
+ *
+ * $Id$
+ *
+ * A snapshot holds the same objects as the flatfile it is written beside
+ * (<flatfile>.snap), but in a form which is mapped into memory and copied
+ * into db[] without any parsing: a table of user-defined attribute names,
+ * fixed-width object records, and a section of length-prefixed attribute
+ * values which the object records index into.
+ *
+ * Every section is covered by a checksum, and the header records the size
+ * and modification time of the flatfile.  A snapshot which is damaged, which
+ * was written by a different build, or which no longer matches its flatfile
+ * is ignored, and the flatfile is read instead.  The flatfile remains the
+ * interchange format.  A snapshot is only ever a faster way to load it.
+ */
+
+#include "copyright.h"
+#include "autoconf.h"
+#include "config.h"
+#include "externs.h"
+
+#include <sys/stat.h>
+#if defined(HAVE_SYS_MMAN_H) && defined(HAVE_MMAP)
+#include <sys/mman.h>
+#endif // HAVE_SYS_MMAN_H && HAVE_MMAP
+
+#include "attrs.h"
+#include "mathutil.h"
+#include "snapshot.h"
+#include "vattr.h"
+
+#define SNAPSHOT_SIGNATURE      "MUXSNAP1"
+#define SNAPSHOT_SIGNATURE_SIZE 8
+#define SNAPSHOT_VERSION        1
+
+// Snapshots are not portable between machines.  A snapshot written with a
+// different byte order is simply ignored.
+//
+#define SNAPSHOT_BYTE_ORDER     0x01020304
+
+typedef struct
+{
+    UINT64 nOffset;
+    UINT64 nSize;
+    UINT64 nSum;
+    UINT32 nCount;
+    UINT32 nReserved;
+} SNAPSHOT_SECTION;
+
+typedef struct
+{
+    char   aSignature[SNAPSHOT_SIGNATURE_SIZE];
+    UINT32 nVersion;
+    UINT32 nByteOrder;
+    UINT32 nHeaderSize;
+    UINT32 nObjectSize;
+    INT64  nSourceSize;
+    INT64  tSourceModified;
+    INT32  iFlags;
+    INT32  nSize;
+    INT32  iAttrNext;
+    INT32  nRecordPlayers;
+    INT32  iCheckpointBase;
+    INT32  iReserved;
+    SNAPSHOT_SECTION Names;     // SNAPSHOT_NAME entries.
+    SNAPSHOT_SECTION Objects;   // SNAPSHOT_OBJECT records, one per dbref.
+    SNAPSHOT_SECTION Values;    // SNAPSHOT_VALUE entries.
+    UINT32 nHeaderCRC;          // CRC of the header with this field zero.
+    UINT32 nPadding;
+} SNAPSHOT_HEADER;
+
+// Each entry is followed by the name and a terminating '\0'.
+//
+typedef struct
+{
+    INT32  iAttr;
+    INT32  iFlags;
+    UINT32 nName;
+} SNAPSHOT_NAME;
+
+// The values of an object are contiguous, starting nValues bytes into the
+// value section.  Objects which are absent from the flatfile (garbage) have
+// bPresent clear and are left as db_grow() initializes them.
+//
+typedef struct
+{
+    UINT64 nValues;
+    INT32  location;
+    INT32  zone;
+    INT32  contents;
+    INT32  exits;
+    INT32  link;
+    INT32  next;
+    INT32  owner;
+    INT32  parent;
+    INT32  pennies;
+    UINT32 nAttrs;
+    UINT32 aFlags[3];
+    INT32  powers;
+    INT32  powers2;
+    INT32  bPresent;
+} SNAPSHOT_OBJECT;
+
+// Each entry is followed by the value and a terminating '\0'.  Entries are
+// not aligned.  Unless the name is kept as an attribute (V_ATRNAME), A_NAME
+// carries the bare name rather than a raw attribute.
+//
+typedef struct
+{
+    INT32  iAttr;
+    UINT32 nValue;
+} SNAPSHOT_VALUE;
+
+// CRC32 a byte at a time takes longer than reading a large snapshot, so
+// sections are summed 64 bits at a time instead (FNV-1a over words, with a
+// final mix).  Sections are written a piece at a time, so a partial word is
+// carried between calls.
+//
+#define SNAPSHOT_SUM_BASIS  UINT64_C(0xCBF29CE484222325)
+#define SNAPSHOT_SUM_PRIME  UINT64_C(0x00000100000001B3)
+
+typedef struct
+{
+    UINT64 nHash;
+    UINT8  aPartial[8];
+    size_t nPartial;
+} SNAPSHOT_SUM;
+
+static void snapshot_sum_init(SNAPSHOT_SUM *pss)
+{
+    pss->nHash = SNAPSHOT_SUM_BASIS;
+    pss->nPartial = 0;
+}
+
+static void snapshot_sum_add(SNAPSHOT_SUM *pss, const void *p, size_t n)
+{
+    const UINT8 *pb = (const UINT8 *)p;
+    UINT64 nHash = pss->nHash;
+    UINT64 w;
+
+    if (0 < pss->nPartial)
+    {
+        while (  0 < n
+              && pss->nPartial < sizeof(w))
+        {
+            pss->aPartial[pss->nPartial++] = *pb++;
+            n--;
+        }
+        if (pss->nPartial < sizeof(w))
+        {
+            return;
+        }
+        memcpy(&w, pss->aPartial, sizeof(w));
+        nHash = (nHash ^ w) * SNAPSHOT_SUM_PRIME;
+        pss->nPartial = 0;
+    }
+
+    while (sizeof(w) <= n)
+    {
+        memcpy(&w, pb, sizeof(w));
+        nHash = (nHash ^ w) * SNAPSHOT_SUM_PRIME;
+        pb += sizeof(w);
+        n  -= sizeof(w);
+    }
+    pss->nHash = nHash;
+
+    memcpy(pss->aPartial, pb, n);
+    pss->nPartial = n;
+}
+
+static UINT64 snapshot_sum_final(SNAPSHOT_SUM *pss)
+{
+    UINT64 nHash = pss->nHash;
+    if (0 < pss->nPartial)
+    {
+        UINT64 w = 0;
+        memcpy(&w, pss->aPartial, pss->nPartial);
+        nHash = (nHash ^ w) * SNAPSHOT_SUM_PRIME;
+        nHash = (nHash ^ pss->nPartial) * SNAPSHOT_SUM_PRIME;
+    }
+    nHash ^= nHash >> 32;
+    return nHash;
+}
+
+static UINT64 snapshot_sum(const void *p, size_t n)
+{
+    SNAPSHOT_SUM ss;
+    snapshot_sum_init(&ss);
+    snapshot_sum_add(&ss, p, n);
+    return snapshot_sum_final(&ss);
+}
+
+static void snapshot_name(UTF8 *pName, size_t nName, const UTF8 *pSource)
+{
+    mux_sprintf(pName, nName, T("%s.snap"), pSource);
+}
+
+void snapshot_remove(const UTF8 *pSource)
+{
+    UTF8 fn[SIZEOF_PATHNAME+40];
+    snapshot_name(fn, sizeof(fn), pSource);
+    RemoveFile(fn);
+}
+
+// A section being written.
+//
+typedef struct
+{
+    SNAPSHOT_SECTION *pss;
+    SNAPSHOT_SUM      sum;
+} SNAPSHOT_WRITER;
+
+static void snapshot_begin(SNAPSHOT_WRITER *psw, SNAPSHOT_SECTION *pss, UINT64 nOffset)
+{
+    psw->pss = pss;
+    pss->nOffset = nOffset;
+    snapshot_sum_init(&psw->sum);
+}
+
+static void snapshot_end(SNAPSHOT_WRITER *psw)
+{
+    psw->pss->nSum = snapshot_sum_final(&psw->sum);
+}
+
+static bool snapshot_put(FILE *f, SNAPSHOT_WRITER *psw, const void *p, size_t n)
+{
+    if (fwrite(p, 1, n, f) != n)
+    {
+        return false;
+    }
+    snapshot_sum_add(&psw->sum, p, n);
+    psw->pss->nSize += n;
+    return true;
+}
+
+static bool snapshot_put_value(FILE *f, SNAPSHOT_WRITER *psw, int iAttr, const UTF8 *pValue)
+{
+    SNAPSHOT_VALUE sv;
+    sv.iAttr = iAttr;
+    sv.nValue = (UINT32)strlen((const char *)pValue);
+    psw->pss->nCount++;
+    return (  snapshot_put(f, psw, &sv, sizeof(sv))
+           && snapshot_put(f, psw, pValue, sv.nValue + 1));
+}
+
+// Sections start on 8-byte boundaries so that object records can be used
+// where they lie.
+//
+static bool snapshot_align(FILE *f, UINT64 *pnOffset)
+{
+    static const char aZero[8] = { 0 };
+    size_t n = (size_t)((8 - (*pnOffset & 7)) & 7);
+    if (  0 < n
+       && fwrite(aZero, 1, n, f) != n)
+    {
+        return false;
+    }
+    *pnOffset += n;
+    return true;
+}
+
+// The attributes of object i as the flatfile would carry them.
+//
+static bool snapshot_put_attrs(FILE *f, SNAPSHOT_WRITER *psw, dbref i, int flags)
+{
+    if (!(flags & V_ATRNAME))
+    {
+        const UTF8 *pName = atr_get_raw(i, A_NAME);
+        if (nullptr != pName)
+        {
+            dbref aowner;
+            int   aflags;
+            pName = atr_decode_flags_owner(pName, &aowner, &aflags);
+        }
+        if (!snapshot_put_value(f, psw, A_NAME, (nullptr == pName) ? T("") : pName))
+        {
+            return false;
+        }
+    }
+
+    if (flags & V_DATABASE)
+    {
+        return true;
+    }
+
+    unsigned char *as;
+    for (int ca = atr_head(i, &as); ca; ca = atr_next(&as))
+    {
+        ATTR *a = atr_num(ca);
+        if (nullptr == a)
+        {
+            continue;
+        }
+
+        int j = a->number;
+        if (  A_LIST == j
+           || A_MONEY == j
+           || (  A_NAME == j
+              && !(flags & V_ATRNAME)))
+        {
+            continue;
+        }
+
+        const UTF8 *p = atr_get_raw(i, j);
+        if (  nullptr != p
+           && !snapshot_put_value(f, psw, j, p))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool snapshot_write_file(FILE *f, const struct stat *pstSource)
+{
+    int flags = OUTPUT_VERSION | OUTPUT_FLAGS;
+
+    SNAPSHOT_HEADER sh;
+    memset(&sh, 0, sizeof(sh));
+    memcpy(sh.aSignature, SNAPSHOT_SIGNATURE, SNAPSHOT_SIGNATURE_SIZE);
+    sh.nVersion        = SNAPSHOT_VERSION;
+    sh.nByteOrder      = SNAPSHOT_BYTE_ORDER;
+    sh.nHeaderSize     = sizeof(SNAPSHOT_HEADER);
+    sh.nObjectSize     = sizeof(SNAPSHOT_OBJECT);
+    sh.nSourceSize     = (INT64)pstSource->st_size;
+    sh.tSourceModified = (INT64)pstSource->st_mtime;
+    sh.iFlags          = flags;
+    sh.nSize           = mudstate.db_top;
+    sh.iAttrNext       = mudstate.attr_next;
+    sh.nRecordPlayers  = mudstate.record_players;
+    sh.iCheckpointBase = mudstate.checkpoint_base;
+
+    // The header is rewritten once the sections are known.
+    //
+    if (fwrite(&sh, 1, sizeof(sh), f) != sizeof(sh))
+    {
+        return false;
+    }
+    UINT64 nOffset = sizeof(sh);
+
+    // User-defined attribute names.
+    //
+    SNAPSHOT_WRITER sw;
+    snapshot_begin(&sw, &sh.Names, nOffset);
+    for (int iAttr = A_USER_START; iAttr <= anum_alc_top; iAttr++)
+    {
+        ATTR *vp = (ATTR *)anum_get(iAttr);
+        if (  nullptr != vp
+           && !(vp->flags & AF_DELETED))
+        {
+            SNAPSHOT_NAME sn;
+            sn.iAttr  = vp->number;
+            sn.iFlags = vp->flags;
+            sn.nName  = (UINT32)strlen((const char *)vp->name);
+            sh.Names.nCount++;
+            if (  !snapshot_put(f, &sw, &sn, sizeof(sn))
+               || !snapshot_put(f, &sw, vp->name, sn.nName + 1))
+            {
+                return false;
+            }
+        }
+    }
+    snapshot_end(&sw);
+    nOffset += sh.Names.nSize;
+
+    // Trailing garbage is not carried, just as in the flatfile.
+    //
+    dbref nObjects = mudstate.db_top;
+    while (  0 < nObjects
+          && isGarbage(nObjects - 1))
+    {
+        nObjects--;
+    }
+
+    SNAPSHOT_OBJECT *aObjects = nullptr;
+    if (0 < nObjects)
+    {
+        aObjects = (SNAPSHOT_OBJECT *)MEMALLOC(nObjects * sizeof(SNAPSHOT_OBJECT));
+        ISOUTOFMEMORY(aObjects);
+        memset(aObjects, 0, nObjects * sizeof(SNAPSHOT_OBJECT));
+    }
+
+    // Values, filling in the object records as we go.
+    //
+    bool bSuccess = snapshot_align(f, &nOffset);
+    snapshot_begin(&sw, &sh.Values, nOffset);
+    for (dbref i = 0; bSuccess && i < nObjects; i++)
+    {
+        if (isGarbage(i))
+        {
+            continue;
+        }
+
+        SNAPSHOT_OBJECT *pso = &aObjects[i];
+        pso->nValues   = sh.Values.nSize;
+        pso->location  = Location(i);
+        pso->zone      = Zone(i);
+        pso->contents  = Contents(i);
+        pso->exits     = Exits(i);
+        pso->link      = Link(i);
+        pso->next      = Next(i);
+        pso->owner     = Owner(i);
+        pso->parent    = Parent(i);
+        pso->aFlags[0] = Flags(i);
+        pso->aFlags[1] = Flags2(i);
+        pso->aFlags[2] = Flags3(i);
+        pso->powers    = Powers(i);
+        pso->powers2   = Powers2(i);
+        pso->bPresent  = 1;
+        if (!(flags & V_ATRMONEY))
+        {
+            const UTF8 *pMoney = atr_get_raw(i, A_MONEY);
+            pso->pennies = (nullptr == pMoney) ? 0 : mux_atol(pMoney);
+        }
+
+        UINT32 nBefore = sh.Values.nCount;
+        bSuccess = snapshot_put_attrs(f, &sw, i, flags);
+        pso->nAttrs = sh.Values.nCount - nBefore;
+    }
+    snapshot_end(&sw);
+    nOffset += sh.Values.nSize;
+
+    // Object records.
+    //
+    if (bSuccess)
+    {
+        bSuccess = snapshot_align(f, &nOffset);
+        snapshot_begin(&sw, &sh.Objects, nOffset);
+        sh.Objects.nCount = nObjects;
+        if (  bSuccess
+           && 0 < nObjects)
+        {
+            bSuccess = snapshot_put(f, &sw, aObjects, nObjects * sizeof(SNAPSHOT_OBJECT));
+        }
+        snapshot_end(&sw);
+    }
+
+    if (nullptr != aObjects)
+    {
+        MEMFREE(aObjects);
+        aObjects = nullptr;
+    }
+
+    if (bSuccess)
+    {
+        sh.nHeaderCRC = CRC32_ProcessBuffer(0, &sh, sizeof(sh));
+        bSuccess = (  fseek(f, 0, SEEK_SET) == 0
+                   && fwrite(&sh, 1, sizeof(sh), f) == sizeof(sh));
+    }
+    return bSuccess;
+}
+
+// Write a snapshot of the current database beside pSource, which must be the
+// flatfile just written from the same state.
+//
+void snapshot_write(const UTF8 *pSource)
+{
+    if (!mudconf.dump_snapshot)
+    {
+        return;
+    }
+
+    struct stat statbuf;
+    if (stat((const char *)pSource, &statbuf) != 0)
+    {
+        return;
+    }
+
+    UTF8 outfn[SIZEOF_PATHNAME+40];
+    UTF8 tmpfile[SIZEOF_PATHNAME+72];
+    snapshot_name(outfn, sizeof(outfn), pSource);
+    mux_sprintf(tmpfile, sizeof(tmpfile), T("%s.#%d#"), outfn, mudstate.epoch);
+
+    FILE *f;
+    if (!mux_fopen(&f, tmpfile, T("wb")))
+    {
+        log_perror(T("DMP"), T("SNAP"), T("Opening"), tmpfile);
+        return;
+    }
+    DebugTotalFiles++;
+    setvbuf(f, nullptr, _IOFBF, 65536);
+
+    bool bSuccess = snapshot_write_file(f, &statbuf);
+    if (0 != ferror(f))
+    {
+        bSuccess = false;
+    }
+    if (fclose(f) == 0)
+    {
+        DebugTotalFiles--;
+    }
+    else
+    {
+        bSuccess = false;
+    }
+
+    if (!bSuccess)
+    {
+        log_perror(T("DMP"), T("SNAP"), T("Writing"), tmpfile);
+        RemoveFile(tmpfile);
+    }
+    else if (ReplaceFile(tmpfile, outfn) < 0)
+    {
+        log_perror(T("DMP"), T("SNAP"), T("Renaming"), tmpfile);
+    }
+    else if (stat((const char *)outfn, &statbuf) == 0)
+    {
+        STARTLOG(LOG_DBSAVES, "DMP", "SNAP");
+        log_printf(T("Wrote %s: %lld bytes."), outfn, (INT64)statbuf.st_size);
+        ENDLOG;
+    }
+}
+
+static bool snapshot_section_valid(const SNAPSHOT_SECTION *pss, size_t nFile)
+{
+    return (  pss->nOffset <= nFile
+           && pss->nSize <= nFile - pss->nOffset);
+}
+
+// Why the snapshot cannot be used, or nullptr if it can.
+//
+static const UTF8 *snapshot_check(const UTF8 *pData, size_t nData, const struct stat *pstSource)
+{
+    if (nData < sizeof(SNAPSHOT_HEADER))
+    {
+        return T("truncated");
+    }
+
+    SNAPSHOT_HEADER sh;
+    memcpy(&sh, pData, sizeof(sh));
+    if (  memcmp(sh.aSignature, SNAPSHOT_SIGNATURE, SNAPSHOT_SIGNATURE_SIZE) != 0
+       || SNAPSHOT_VERSION != sh.nVersion
+       || SNAPSHOT_BYTE_ORDER != sh.nByteOrder
+       || sizeof(SNAPSHOT_HEADER) != sh.nHeaderSize
+       || sizeof(SNAPSHOT_OBJECT) != sh.nObjectSize
+       || (OUTPUT_VERSION | OUTPUT_FLAGS) != sh.iFlags)
+    {
+        return T("written by a different version");
+    }
+
+    UINT32 nHeaderCRC = sh.nHeaderCRC;
+    sh.nHeaderCRC = 0;
+    if (CRC32_ProcessBuffer(0, &sh, sizeof(sh)) != nHeaderCRC)
+    {
+        return T("damaged header");
+    }
+
+    if (  (INT64)pstSource->st_size != sh.nSourceSize
+       || (INT64)pstSource->st_mtime != sh.tSourceModified)
+    {
+        return T("stale");
+    }
+
+    if (  !snapshot_section_valid(&sh.Names, nData)
+       || !snapshot_section_valid(&sh.Objects, nData)
+       || !snapshot_section_valid(&sh.Values, nData)
+       || 0 != (sh.Objects.nOffset & 7)
+       || (UINT64)sh.Objects.nCount * sizeof(SNAPSHOT_OBJECT) != sh.Objects.nSize
+       || (INT64)sh.Objects.nCount > (INT64)sh.nSize)
+    {
+        return T("truncated");
+    }
+
+    if (  snapshot_sum(pData + sh.Names.nOffset, (size_t)sh.Names.nSize) != sh.Names.nSum
+       || snapshot_sum(pData + sh.Objects.nOffset, (size_t)sh.Objects.nSize) != sh.Objects.nSum
+       || snapshot_sum(pData + sh.Values.nOffset, (size_t)sh.Values.nSize) != sh.Values.nSum)
+    {
+        return T("damaged");
+    }
+    return nullptr;
+}
+
+// Copy a checked snapshot into the database.  Returns false if its contents
+// do not hang together, in which case the caller reads the flatfile.
+//
+static bool snapshot_apply(const UTF8 *pData)
+{
+    SNAPSHOT_HEADER sh;
+    memcpy(&sh, pData, sizeof(sh));
+
+    db_free();
+    mudstate.min_size = sh.nSize;
+    mudstate.attr_next = sh.iAttrNext;
+    mudstate.record_players = mudconf.reset_players ? 0 : sh.nRecordPlayers;
+    mudstate.checkpoint_base = sh.iCheckpointBase;
+    mudstate.checkpoint_delta = 0;
+
+    const UTF8 *p = pData + sh.Names.nOffset;
+    const UTF8 *pEnd = p + sh.Names.nSize;
+    for (UINT32 k = 0; k < sh.Names.nCount; k++)
+    {
+        SNAPSHOT_NAME sn;
+        if ((size_t)(pEnd - p) < sizeof(sn))
+        {
+            return false;
+        }
+        memcpy(&sn, p, sizeof(sn));
+        p += sizeof(sn);
+        if ((size_t)(pEnd - p) <= sn.nName)
+        {
+            return false;
+        }
+        vattr_define_LEN(p, sn.nName, sn.iAttr, sn.iFlags);
+        p += sn.nName + 1;
+    }
+
+    dbref nObjects = (dbref)sh.Objects.nCount;
+    if (0 < nObjects)
+    {
+        db_grow(nObjects);
+    }
+
+    const SNAPSHOT_OBJECT *aObjects = (const SNAPSHOT_OBJECT *)(pData + sh.Objects.nOffset);
+    const UTF8 *pValues = pData + sh.Values.nOffset;
+    for (dbref i = 0; i < nObjects; i++)
+    {
+        const SNAPSHOT_OBJECT *pso = &aObjects[i];
+        if (!pso->bPresent)
+        {
+            continue;
+        }
+
+        if (sh.Values.nSize < pso->nValues)
+        {
+            return false;
+        }
+        p = pValues + pso->nValues;
+        pEnd = pValues + sh.Values.nSize;
+        for (UINT32 k = 0; k < pso->nAttrs; k++)
+        {
+            SNAPSHOT_VALUE sv;
+            if ((size_t)(pEnd - p) < sizeof(sv))
+            {
+                return false;
+            }
+            memcpy(&sv, p, sizeof(sv));
+            p += sizeof(sv);
+            if ((size_t)(pEnd - p) <= sv.nValue)
+            {
+                return false;
+            }
+
+            if (  A_NAME == sv.iAttr
+               && !(sh.iFlags & V_ATRNAME))
+            {
+                s_Name(i, p);
+            }
+            else
+            {
+                atr_add_raw_LEN(i, sv.iAttr, p, sv.nValue);
+            }
+            p += sv.nValue + 1;
+        }
+
+        s_Location(i, pso->location);
+        s_Zone(i, pso->zone);
+        s_Contents(i, pso->contents);
+        s_Exits(i, pso->exits);
+        s_Link(i, pso->link);
+        s_Next(i, pso->next);
+        s_Owner(i, pso->owner);
+        s_Parent(i, pso->parent);
+        if (!(sh.iFlags & V_ATRMONEY))
+        {
+            s_PenniesDirect(i, pso->pennies);
+        }
+        s_Flags(i, FLAG_WORD1, pso->aFlags[0]);
+        s_Flags(i, FLAG_WORD2, pso->aFlags[1]);
+        s_Flags(i, FLAG_WORD3, pso->aFlags[2]);
+        s_Powers(i, pso->powers);
+        s_Powers2(i, pso->powers2);
+
+        if (isPlayer(i))
+        {
+            c_Connected(i);
+        }
+    }
+    return true;
+}
+
+// Map the snapshot file into memory, or failing that, read it in.
+//
+static UTF8 *snapshot_map(int fd, size_t nData, bool *pbMapped)
+{
+#if defined(HAVE_SYS_MMAN_H) && defined(HAVE_MMAP)
+    void *pMap = mmap(nullptr, nData, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (MAP_FAILED != pMap)
+    {
+#if defined(MADV_SEQUENTIAL)
+        madvise(pMap, nData, MADV_SEQUENTIAL);
+#endif // MADV_SEQUENTIAL
+        *pbMapped = true;
+        return (UTF8 *)pMap;
+    }
+#endif // HAVE_SYS_MMAN_H && HAVE_MMAP
+
+    *pbMapped = false;
+    UTF8 *pData = (UTF8 *)MEMALLOC(nData);
+    if (nullptr == pData)
+    {
+        return nullptr;
+    }
+
+    size_t nRead = 0;
+    while (nRead < nData)
+    {
+        int cc = mux_read(fd, pData + nRead, (unsigned int)(nData - nRead));
+        if (cc <= 0)
+        {
+            if (  cc < 0
+               && EINTR == errno)
+            {
+                continue;
+            }
+            MEMFREE(pData);
+            return nullptr;
+        }
+        nRead += cc;
+    }
+    return pData;
+}
+
+static void snapshot_unmap(UTF8 *pData, size_t nData, bool bMapped)
+{
+    if (bMapped)
+    {
+#if defined(HAVE_SYS_MMAN_H) && defined(HAVE_MMAP)
+        munmap(pData, nData);
+#endif // HAVE_SYS_MMAN_H && HAVE_MMAP
+    }
+    else
+    {
+        UNUSED_PARAMETER(nData);
+        MEMFREE(pData);
+    }
+}
+
+// Load the snapshot beside pSource instead of pSource itself.  Returns false
+// if there is no usable snapshot, and the flatfile should be read.
+//
+bool snapshot_load(const UTF8 *pSource, int *db_format, int *db_version, int *db_flags)
+{
+    if (!mudconf.dump_snapshot)
+    {
+        return false;
+    }
+
+    struct stat stSource;
+    if (stat((const char *)pSource, &stSource) != 0)
+    {
+        return false;
+    }
+
+    UTF8 fn[SIZEOF_PATHNAME+40];
+    snapshot_name(fn, sizeof(fn), pSource);
+
+    int fd;
+    if (!mux_open(&fd, fn, O_RDONLY|O_BINARY))
+    {
+        return false;
+    }
+    DebugTotalFiles++;
+
+    struct stat statbuf;
+    UTF8 *pData = nullptr;
+    size_t nData = 0;
+    bool bMapped = false;
+    if (  fstat(fd, &statbuf) == 0
+       && 0 < statbuf.st_size)
+    {
+        nData = (size_t)statbuf.st_size;
+        pData = snapshot_map(fd, nData, &bMapped);
+    }
+    if (mux_close(fd) == 0)
+    {
+        DebugTotalFiles--;
+    }
+
+    if (nullptr == pData)
+    {
+        log_perror(T("INI"), T("SNAP"), T("Reading"), fn);
+        return false;
+    }
+
+    STARTLOG(LOG_STARTUP, "INI", "LOAD");
+    log_text(T("Loading: "));
+    log_text(fn);
+    ENDLOG;
+
+    bool bLoaded = false;
+    const UTF8 *pReason = snapshot_check(pData, nData, &stSource);
+    if (nullptr == pReason)
+    {
+        bLoaded = snapshot_apply(pData);
+        if (!bLoaded)
+        {
+            pReason = T("inconsistent");
+        }
+    }
+
+    if (bLoaded)
+    {
+        SNAPSHOT_HEADER sh;
+        memcpy(&sh, pData, sizeof(sh));
+        *db_format  = F_MUX;
+        *db_version = sh.iFlags & V_MASK;
+        *db_flags   = sh.iFlags & ~V_MASK;
+    }
+    else
+    {
+        STARTLOG(LOG_STARTUP, "INI", "LOAD");
+        log_printf(T("Ignoring %s snapshot %s."), pReason, fn);
+        ENDLOG;
+    }
+    snapshot_unmap(pData, nData, bMapped);
+    return bLoaded;
+}
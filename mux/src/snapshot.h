@@ -0,0 +1,15 @@
+/*! \file snapshot.h
+ * \brief Binary database snapshots for fast startup.
+ *
+ * $Id$
+ *
+ */
+
+#ifndef _SNAPSHOT_H
+#define _SNAPSHOT_H
+
+extern void snapshot_write(const UTF8 *pSource);
+extern void snapshot_remove(const UTF8 *pSource);
+extern bool snapshot_load(const UTF8 *pSource, int *db_format, int *db_version, int *db_flags);
+
+#endif // !_SNAPSHOT_H
@@ -13,6 +13,7 @@
 #include <csignal>
 
 #include "command.h"
+#include "journal.h"
 #include "mathutil.h"
 #include "mguests.h"
 
@@ -88,60 +89,6 @@ void dispatch_DatabaseDump(void *pUnused, int iUnused)
     scheduler.DeferTask(mudstate.dump_counter, PRIORITY_SYSTEM, dispatch_DatabaseDump, 0, 0);
 }
 
-// Idle Check Task routine.
-//
-void dispatch_IdleCheck(void *pUnused, int iUnused)
-{
-    UNUSED_PARAMETER(pUnused);
-    UNUSED_PARAMETER(iUnused);
-
-    if (mudconf.control_flags & CF_IDLECHECK)
-    {
-        const UTF8 *cmdsave = mudstate.debug_cmd;
-        mudstate.debug_cmd = T("< idlecheck >");
-        check_idle();
-        mudstate.debug_cmd = cmdsave;
-    }
-
-    // Schedule ourselves again.
-    //
-    CLinearTimeAbsolute ltaNow;
-    ltaNow.GetUTC();
-    CLinearTimeDelta ltd;
-    ltd.SetSeconds(mudconf.idle_interval);
-    mudstate.idle_counter = ltaNow + ltd;
-    scheduler.DeferTask(mudstate.idle_counter, PRIORITY_SYSTEM, dispatch_IdleCheck, 0, 0);
-}
-
-void dispatch_KeepAlive(void *pUnused, int iUnused)
-{
-    UNUSED_PARAMETER(pUnused);
-    UNUSED_PARAMETER(iUnused);
-
-    DESC *d, *dnext;
-    DESC_SAFEITER_ALL(d, dnext)
-    {
-        if (  (d->flags & DS_CONNECTED)
-           && KeepAlive(d->player))
-        {
-            // Send a Telnet NOP code - creates traffic to keep NAT routers
-            // happy.
-            //
-            const UTF8 aNOP[2] = { NVT_IAC, NVT_NOP };
-            queue_write_LEN(d, aNOP, sizeof(aNOP));
-        }
-    }
-
-    // Schedule ourselves again.
-    //
-    CLinearTimeAbsolute ltaNow;
-    ltaNow.GetUTC();
-    CLinearTimeDelta ltd;
-    ltd.SetSeconds(mudconf.keepalive_interval);
-    mudstate.keepalive_counter = ltaNow + ltd;
-    scheduler.DeferTask(mudstate.keepalive_counter, PRIORITY_SYSTEM, dispatch_KeepAlive, 0, 0);
-}
-
 // Check Events Task routine.
 //
 void dispatch_CheckEvents(void *pUnused, int iUnused)
@@ -193,6 +140,33 @@ void dispatch_CacheTick(void *pUnused, int iUnused)
 }
 #endif // !MEMORY_BASED
 
+// Journal Commit Task routine.
+//
+void dispatch_JournalCommit(void *pUnused, int iUnused)
+{
+    UNUSED_PARAMETER(pUnused);
+    UNUSED_PARAMETER(iUnused);
+
+    const UTF8 *cmdsave = mudstate.debug_cmd;
+    mudstate.debug_cmd = T("< journal >");
+
+    CLinearTimeDelta ltd = 0;
+    if (mudconf.journal_commit_period <= ltd)
+    {
+        mudconf.journal_commit_period.SetSeconds(1);
+    }
+
+    journal_commit();
+
+    // Schedule ourselves again.
+    //
+    CLinearTimeAbsolute ltaNextTime;
+    ltaNextTime.GetUTC();
+    ltaNextTime += mudconf.journal_commit_period;
+    scheduler.DeferTask(ltaNextTime, PRIORITY_SYSTEM, dispatch_JournalCommit, 0, 0);
+    mudstate.debug_cmd = cmdsave;
+}
+
 #if 0
 void dispatch_CleanChannels(void *pUnused, int iUnused)
 {
@@ -238,25 +212,12 @@ void init_timer(void)
     scheduler.DeferTask(mudstate.dump_counter, PRIORITY_SYSTEM,
         dispatch_DatabaseDump, 0, 0);
 
-    // Setup re-occuring Idle Check task.
-    //
-    ltd.SetSeconds(mudconf.idle_interval);
-    mudstate.idle_counter   = ltaNow + ltd;
-    scheduler.DeferTask(mudstate.idle_counter, PRIORITY_SYSTEM,
-        dispatch_IdleCheck, 0, 0);
-
     // Setup re-occuring Check Events task.
     //
     mudstate.events_counter = ltaNow + time_15s;
     scheduler.DeferTask(mudstate.events_counter, PRIORITY_SYSTEM,
         dispatch_CheckEvents, 0, 0);
 
-    // Setup re-occuring KeepAlive task.
-    //
-    ltd.SetSeconds(mudconf.keepalive_interval);
-    mudstate.keepalive_counter = ltaNow + ltd;
-    scheduler.DeferTask(mudstate.keepalive_counter, PRIORITY_SYSTEM, dispatch_KeepAlive, 0, 0);
-
 #ifndef MEMORY_BASED
     // Setup re-occuring cache_tick task.
     //
@@ -269,6 +230,14 @@ void init_timer(void)
         dispatch_CacheTick, 0, 0);
 #endif // !MEMORY_BASED
 
+    // Setup re-occuring journal commit task.
+    //
+    if (mudconf.journal)
+    {
+        scheduler.DeferTask(ltaNow+mudconf.journal_commit_period, PRIORITY_SYSTEM,
+            dispatch_JournalCommit, 0, 0);
+    }
+
 #if 0
     // Setup comsys channel scrubbing.
     //
@@ -320,9 +289,9 @@ void do_timewarp(dbref executor, dbref caller, dbref enactor, int eval, int key,
     }
     if (key & TWARP_IDLE)
     {
-        mudstate.idle_counter -= ltd;
-        scheduler.CancelTask(dispatch_IdleCheck, 0, 0);
-        scheduler.DeferTask(mudstate.idle_counter, PRIORITY_SYSTEM, dispatch_IdleCheck, 0, 0);
+        // Idle checks are kept per descriptor, so just check them all.
+        //
+        desc_recheck_idle_all();
     }
     if (key & TWARP_EVENTS)
     {
@@ -375,6 +344,7 @@ bool CTaskHeap::Insert(PTASK_RECORD pTask, SCHCMP *pfCompare)
     pTask->m_iVisitedMark = m_iVisitedMark-1;
 
     m_pHeap[m_nCurrent] = pTask;
+    pTask->m_iHeapIndex = m_nCurrent;
     m_nCurrent++;
     SiftUp(m_nCurrent-1, pfCompare);
     return true;
@@ -469,220 +439,1078 @@ void CTaskHeap::CancelTask(FTASK *fpTask, void *arg_voidptr, int arg_Integer)
     }
 }
 
-static int ComparePriority(PTASK_RECORD pTaskA, PTASK_RECORD pTaskB)
+void CTaskList::Append(PTASK_RECORD pTask)
 {
-    int i = (pTaskA->iPriority) - (pTaskB->iPriority);
-    if (i == 0)
+    pTask->m_pList = this;
+    pTask->m_pNext = nullptr;
+    pTask->m_pPrev = m_pTail;
+    if (nullptr != m_pTail)
     {
-        // Must subtract so that ticket rollover is handled properly.
-        //
-        return  (pTaskA->m_Ticket) - (pTaskB->m_Ticket);
+        m_pTail->m_pNext = pTask;
     }
-    return i;
+    else
+    {
+        m_pHead = pTask;
+    }
+    m_pTail = pTask;
+    m_nTasks++;
 }
 
-static int CompareWhen(PTASK_RECORD pTaskA, PTASK_RECORD pTaskB)
+void CTaskList::Remove(PTASK_RECORD pTask)
 {
-    // Can't simply subtract because comparing involves a truncation cast.
-    //
-    if (pTaskA->ltaWhen < pTaskB->ltaWhen)
+    if (nullptr != pTask->m_pPrev)
     {
-        return -1;
+        pTask->m_pPrev->m_pNext = pTask->m_pNext;
     }
-    else if (pTaskA->ltaWhen > pTaskB->ltaWhen)
+    else
     {
-        return 1;
+        m_pHead = pTask->m_pNext;
+    }
+    if (nullptr != pTask->m_pNext)
+    {
+        pTask->m_pNext->m_pPrev = pTask->m_pPrev;
     }
     else
     {
-        // Must subtract so that ticket rollover is handled properly.
-        //
-        return  (pTaskA->m_Ticket) - (pTaskB->m_Ticket);
+        m_pTail = pTask->m_pPrev;
     }
+    pTask->m_pList = nullptr;
+    pTask->m_pNext = nullptr;
+    pTask->m_pPrev = nullptr;
+    m_nTasks--;
 }
 
-void CScheduler::DeferTask(const CLinearTimeAbsolute& ltaWhen, int iPriority,
-                           FTASK *fpTask, void *arg_voidptr, int arg_Integer)
+// Tasks usually arrive in ticket order, but a task coming off the timer
+// wheel may be older than tasks already in the group.
+//
+void CTaskGroup::Insert(PTASK_RECORD pTask)
 {
-    PTASK_RECORD pTask = new TASK_RECORD;
-    if (!pTask) return;
+    // Must subtract so that ticket rollover is handled properly.
+    //
+    PTASK_RECORD pAfter = m_pTail;
+    while (  nullptr != pAfter
+          && 0 < pAfter->m_Ticket - pTask->m_Ticket)
+    {
+        pAfter = pAfter->m_pPrev;
+    }
 
-    pTask->ltaWhen = ltaWhen;
-    pTask->iPriority = iPriority;
-    pTask->fpTask = fpTask;
-    pTask->arg_voidptr = arg_voidptr;
-    pTask->arg_Integer = arg_Integer;
-    pTask->m_Ticket = m_Ticket++;
+    if (pAfter == m_pTail)
+    {
+        Append(pTask);
+        return;
+    }
 
-    // Must add to the WhenHeap so that network is still serviced.
-    //
-    if (!m_WhenHeap.Insert(pTask, CompareWhen))
+    pTask->m_pList = this;
+    pTask->m_pPrev = pAfter;
+    if (nullptr == pAfter)
     {
-        delete pTask;
+        pTask->m_pNext = m_pHead;
+        m_pHead = pTask;
+    }
+    else
+    {
+        pTask->m_pNext = pAfter->m_pNext;
+        pAfter->m_pNext = pTask;
     }
+    pTask->m_pNext->m_pPrev = pTask;
+    m_nTasks++;
 }
 
-void CScheduler::DeferImmediateTask(int iPriority, FTASK *fpTask, void *arg_voidptr, int arg_Integer)
+CTaskFairQueue::CTaskFairQueue(void)
 {
-    PTASK_RECORD pTask = new TASK_RECORD;
-    if (!pTask) return;
+    for (int i = 0; i < FAIR_HASH_SIZE; i++)
+    {
+        m_aHash[i] = nullptr;
+    }
+    m_pActive = nullptr;
+    m_pPending = nullptr;
+    m_pCurrent = nullptr;
+    m_nTasks = 0;
+}
 
-    //pTask->ltaWhen = ltaWhen;
-    pTask->iPriority = iPriority;
-    pTask->fpTask = fpTask;
-    pTask->arg_voidptr = arg_voidptr;
-    pTask->arg_Integer = arg_Integer;
-    pTask->m_Ticket = m_Ticket++;
+CTaskFairQueue::~CTaskFairQueue(void)
+{
+    for (int i = 0; i < FAIR_HASH_SIZE; i++)
+    {
+        CTaskGroup *pGroup;
+        while (nullptr != (pGroup = m_aHash[i]))
+        {
+            m_aHash[i] = pGroup->m_pHashNext;
 
-    // Must add to the WhenHeap so that network is still serviced.
-    //
-    if (!m_WhenHeap.Insert(pTask, CompareWhen))
+            PTASK_RECORD pTask;
+            while (nullptr != (pTask = pGroup->m_pHead))
+            {
+                pGroup->CTaskList::Remove(pTask);
+                delete pTask;
+            }
+            delete pGroup;
+        }
+    }
+}
+
+CTaskGroup *CTaskFairQueue::Find(int iGroup)
+{
+    CTaskGroup *pGroup = m_aHash[iGroup & (FAIR_HASH_SIZE-1)];
+    while (  nullptr != pGroup
+          && pGroup->m_iGroup != iGroup)
     {
-        delete pTask;
+        pGroup = pGroup->m_pHashNext;
     }
+    return pGroup;
 }
 
-void CScheduler::CancelTask(FTASK *fpTask, void *arg_voidptr, int arg_Integer)
+// Rings are circular. Joining puts the group last, just before *ppRing.
+//
+void CTaskFairQueue::Join(CTaskGroup **ppRing, CTaskGroup *pGroup)
 {
-    m_WhenHeap.CancelTask(fpTask, arg_voidptr, arg_Integer);
-    m_PriorityHeap.CancelTask(fpTask, arg_voidptr, arg_Integer);
+    CTaskGroup *pFirst = *ppRing;
+    if (nullptr == pFirst)
+    {
+        pGroup->m_pRingNext = pGroup;
+        pGroup->m_pRingPrev = pGroup;
+        *ppRing = pGroup;
+    }
+    else
+    {
+        pGroup->m_pRingNext = pFirst;
+        pGroup->m_pRingPrev = pFirst->m_pRingPrev;
+        pFirst->m_pRingPrev->m_pRingNext = pGroup;
+        pFirst->m_pRingPrev = pGroup;
+    }
 }
 
-void CScheduler::ReadyTasks(const CLinearTimeAbsolute& ltaNow)
+void CTaskFairQueue::Leave(CTaskGroup **ppRing, CTaskGroup *pGroup)
 {
-    // Move ready-to-run tasks off the WhenHeap and onto the PriorityHeap.
-    //
-    PTASK_RECORD pTask = m_WhenHeap.PeekAtTopmost();
-    while (  pTask
-          && pTask->ltaWhen < ltaNow)
+    if (pGroup->m_pRingNext == pGroup)
     {
-        pTask = m_WhenHeap.RemoveTopmost(CompareWhen);
-        if (pTask)
+        *ppRing = nullptr;
+    }
+    else
+    {
+        pGroup->m_pRingPrev->m_pRingNext = pGroup->m_pRingNext;
+        pGroup->m_pRingNext->m_pRingPrev = pGroup->m_pRingPrev;
+        if (*ppRing == pGroup)
         {
-            if (  nullptr == pTask->fpTask
-               || !m_PriorityHeap.Insert(pTask, ComparePriority))
-            {
-                delete pTask;
-            }
+            *ppRing = pGroup->m_pRingNext;
         }
-        pTask = m_WhenHeap.PeekAtTopmost();
     }
+    pGroup->m_pRingNext = nullptr;
+    pGroup->m_pRingPrev = nullptr;
 }
 
-int CScheduler::RunTasks(const CLinearTimeAbsolute& ltaNow)
+// Give the turn to the next group on the active ring.
+//
+void CTaskFairQueue::NextTurn(void)
 {
-    ReadyTasks(ltaNow);
-    if (mudconf.active_q_chunk)
+    if (nullptr == m_pCurrent)
     {
-        return RunTasks(mudconf.active_q_chunk);
+        m_pCurrent = m_pActive;
     }
     else
     {
-        return RunAllTasks();
+        m_pCurrent = m_pCurrent->m_pRingNext;
+    }
+
+    if (nullptr != m_pCurrent)
+    {
+        m_pCurrent->m_iDeficit += m_pCurrent->m_iWeight;
     }
 }
 
-int CScheduler::RunTasks(int iCount)
+void CTaskFairQueue::Activate(CTaskGroup *pGroup)
 {
-    int nTasks = 0;
-    while (iCount--)
+    Join(&m_pActive, pGroup);
+    pGroup->m_bActive = true;
+    if (nullptr == m_pCurrent)
     {
-        PTASK_RECORD pTask = m_PriorityHeap.PeekAtTopmost();
-        if (!pTask) break;
+        NextTurn();
+    }
+}
 
-        if (pTask->iPriority > m_minPriority)
+// An idle group does not keep the unused part of its turn.
+//
+void CTaskFairQueue::Deactivate(CTaskGroup *pGroup)
+{
+    bool bCurrent = (pGroup == m_pCurrent);
+    CTaskGroup *pNext = pGroup->m_pRingNext;
+    Leave(&m_pActive, pGroup);
+    pGroup->m_bActive = false;
+    pGroup->m_iDeficit = 0;
+
+    if (bCurrent)
+    {
+        if (nullptr == m_pActive)
         {
-            // This is related to CF_DEQUEUE and also to untimed (SUSPENDED)
-            // semaphore entries that we would like to manage together with
-            // the timed ones.
-            //
-            break;
+            m_pCurrent = nullptr;
         }
-        pTask = m_PriorityHeap.RemoveTopmost(ComparePriority);
-        if (pTask)
+        else
         {
-            if (pTask->fpTask)
-            {
-                pTask->fpTask(pTask->arg_voidptr, pTask->arg_Integer);
-                nTasks++;
-            }
-            delete pTask;
+            m_pCurrent = pNext;
+            m_pCurrent->m_iDeficit += m_pCurrent->m_iWeight;
         }
     }
-    return nTasks;
 }
 
-int CScheduler::RunAllTasks(void)
+void CTaskFairQueue::Append(PTASK_RECORD pTask, bool bReady)
 {
-    int nTotalTasks = 0;
-
-    int nTasks;
-    do
+    CTaskGroup *pGroup = Find(pTask->m_iGroup);
+    if (nullptr != pGroup)
     {
-        nTasks = RunTasks(100);
-        nTotalTasks += nTasks;
-    } while (nTasks);
+        pGroup->Insert(pTask);
+        m_nTasks++;
+        if (  bReady
+           && !pGroup->m_bActive
+           && pGroup->m_pHead == pTask)
+        {
+            Leave(&m_pPending, pGroup);
+            Activate(pGroup);
+        }
+        return;
+    }
 
-    return nTotalTasks;
+    pGroup = new CTaskGroup;
+    ISOUTOFMEMORY(pGroup);
+    pGroup->m_iLevel = LIST_GROUP;
+    pGroup->m_pQueue = this;
+    pGroup->m_iGroup = pTask->m_iGroup;
+    pGroup->m_iWeight = (0 < pTask->m_iWeight) ? pTask->m_iWeight : 1;
+    pGroup->m_iDeficit = 0;
+
+    int iHash = pTask->m_iGroup & (FAIR_HASH_SIZE-1);
+    pGroup->m_pHashNext = m_aHash[iHash];
+    m_aHash[iHash] = pGroup;
+
+    pGroup->CTaskList::Append(pTask);
+    m_nTasks++;
+    if (bReady)
+    {
+        Activate(pGroup);
+    }
+    else
+    {
+        pGroup->m_bActive = false;
+        Join(&m_pPending, pGroup);
+    }
 }
 
-bool CScheduler::WhenNext(CLinearTimeAbsolute  *ltaWhen)
+void CTaskFairQueue::Remove(PTASK_RECORD pTask, int iReadyTicket)
 {
-    // Check the Priority Queue first.
-    //
-    PTASK_RECORD pTask = m_PriorityHeap.PeekAtTopmost();
-    if (pTask)
+    CTaskGroup *pGroup = static_cast<CTaskGroup *>(pTask->m_pList);
+    bool bServed = (  pGroup == m_pCurrent
+                   && pGroup->m_pHead == pTask);
+    pGroup->CTaskList::Remove(pTask);
+    m_nTasks--;
+    if (bServed)
     {
-        if (pTask->iPriority <= m_minPriority)
+        pGroup->m_iDeficit--;
+    }
+
+    PTASK_RECORD pHead = pGroup->m_pHead;
+    if (nullptr == pHead)
+    {
+        if (pGroup->m_bActive)
         {
-            ltaWhen->SetSeconds(0);
-            return true;
+            Deactivate(pGroup);
+        }
+        else
+        {
+            Leave(&m_pPending, pGroup);
+        }
+
+        CTaskGroup **ppGroup = &m_aHash[pGroup->m_iGroup & (FAIR_HASH_SIZE-1)];
+        while (*ppGroup != pGroup)
+        {
+            ppGroup = &(*ppGroup)->m_pHashNext;
         }
+        *ppGroup = pGroup->m_pHashNext;
+        delete pGroup;
+        return;
     }
 
-    // Check the When Queue next.
+    // Must subtract so that ticket rollover is handled properly.
     //
-    pTask = m_WhenHeap.PeekAtTopmost();
-    if (pTask)
+    bool bReady = (pHead->m_Ticket - iReadyTicket) < 0;
+    if (pGroup->m_bActive)
     {
-        *ltaWhen = pTask->ltaWhen;
-        return true;
+        if (!bReady)
+        {
+            Deactivate(pGroup);
+            Join(&m_pPending, pGroup);
+        }
+        else if (  bServed
+                && pGroup->m_iDeficit <= 0)
+        {
+            NextTurn();
+        }
+    }
+    else if (bReady)
+    {
+        Leave(&m_pPending, pGroup);
+        Activate(pGroup);
     }
-    return false;
 }
 
-#define HEAP_LEFT_CHILD(x) (2*(x)+1)
-#define HEAP_RIGHT_CHILD(x) (2*(x)+2)
-#define HEAP_PARENT(x) (((x)-1)/2)
-
-void CTaskHeap::SiftDown(int iSubRoot, SCHCMP *pfCompare)
+// The owner or the weight of a task has changed.  A task which moves to
+// another group keeps its ticket, so it takes its place in ticket order
+// there.
+//
+void CTaskFairQueue::Regroup(PTASK_RECORD pTask, int iGroup, int iWeight, int iReadyTicket)
 {
-    int parent = iSubRoot;
-    int child = HEAP_LEFT_CHILD(parent);
+    if (iWeight < 1)
+    {
+        iWeight = 1;
+    }
 
-    PTASK_RECORD Ref = m_pHeap[parent];
+    CTaskGroup *pGroup = static_cast<CTaskGroup *>(pTask->m_pList);
+    if (pGroup->m_iGroup == iGroup)
+    {
+        pTask->m_iWeight = iWeight;
+        pGroup->m_iWeight = iWeight;
+        return;
+    }
 
-    while (child < m_nCurrent)
+    // Must subtract so that ticket rollover is handled properly.
+    //
+    bool bReady = (pTask->m_Ticket - iReadyTicket) < 0;
+    Remove(pTask, iReadyTicket);
+    pTask->m_iGroup = iGroup;
+    pTask->m_iWeight = iWeight;
+    Append(pTask, bReady);
+}
+
+// Every task has become ready.
+//
+void CTaskFairQueue::MakeReady(void)
+{
+    CTaskGroup *pGroup;
+    while (nullptr != (pGroup = m_pPending))
     {
-        int rightchild = HEAP_RIGHT_CHILD(parent);
-        if (rightchild < m_nCurrent)
+        Leave(&m_pPending, pGroup);
+        Activate(pGroup);
+    }
+}
+
+int CTaskFairQueue::Collect(PTASK_RECORD *aTasks)
+{
+    int nTasks = 0;
+    for (int i = 0; i < FAIR_HASH_SIZE; i++)
+    {
+        for (CTaskGroup *pGroup = m_aHash[i]; nullptr != pGroup; pGroup = pGroup->m_pHashNext)
         {
-            if (pfCompare(m_pHeap[rightchild], m_pHeap[child]) < 0)
+            for (PTASK_RECORD p = pGroup->m_pHead; nullptr != p; p = p->m_pNext)
             {
-                child = rightchild;
+                aTasks[nTasks++] = p;
             }
         }
-        if (pfCompare(Ref, m_pHeap[child]) <= 0)
-            break;
-
-        m_pHeap[parent] = m_pHeap[child];
-        parent = child;
-        child = HEAP_LEFT_CHILD(parent);
     }
-    m_pHeap[parent] = Ref;
+    return nTasks;
 }
 
-void CTaskHeap::SiftUp(int child, SCHCMP *pfCompare)
+void CTaskFairQueue::CancelTask(FTASK *fpTask, void *arg_voidptr, int arg_Integer)
+{
+    for (int i = 0; i < FAIR_HASH_SIZE; i++)
+    {
+        for (CTaskGroup *pGroup = m_aHash[i]; nullptr != pGroup; pGroup = pGroup->m_pHashNext)
+        {
+            for (PTASK_RECORD p = pGroup->m_pHead; nullptr != p; p = p->m_pNext)
+            {
+                if (  p->fpTask == fpTask
+                   && p->arg_voidptr == arg_voidptr
+                   && p->arg_Integer == arg_Integer)
+                {
+                    p->fpTask = nullptr;
+                }
+            }
+        }
+    }
+}
+
+static INT64 WheelTick(const CLinearTimeAbsolute& lta)
+{
+    CLinearTimeAbsolute ltaTick(lta);
+    return ltaTick.Return100ns() >> WHEEL_TICK_SHIFT;
+}
+
+CTaskWheel::CTaskWheel(void)
+{
+    for (int i = 0; i < WHEEL_LISTS; i++)
+    {
+        if (i < WHEEL_ROOT_SIZE)
+        {
+            m_aLists[i].m_iLevel = 0;
+        }
+        else
+        {
+            m_aLists[i].m_iLevel = 1 + (i - WHEEL_ROOT_SIZE)/WHEEL_LEVEL_SIZE;
+        }
+    }
+    for (int iLevel = 0; iLevel < WHEEL_LEVELS; iLevel++)
+    {
+        m_anTasks[iLevel] = 0;
+    }
+    m_nTasks = 0;
+    m_tCurrent = 0;
+}
+
+CTaskWheel::~CTaskWheel(void)
+{
+    for (int i = 0; i < WHEEL_LISTS; i++)
+    {
+        PTASK_RECORD pTask;
+        while (nullptr != (pTask = m_aLists[i].m_pHead))
+        {
+            Remove(pTask);
+            delete pTask;
+        }
+    }
+}
+
+// Choose the slot for a task due at tick tWhen. Tasks which are already due
+// go into the current slot.
+//
+CTaskList *CTaskWheel::Slot(INT64 tWhen)
+{
+    INT64 iDelta = tWhen - m_tCurrent;
+    if (iDelta < WHEEL_ROOT_SIZE)
+    {
+        if (iDelta < 0)
+        {
+            tWhen = m_tCurrent;
+        }
+        return &m_aLists[tWhen & (WHEEL_ROOT_SIZE-1)];
+    }
+
+    int iShift = WHEEL_ROOT_BITS;
+    for (int iLevel = 1; iLevel < WHEEL_LEVELS-1; iLevel++)
+    {
+        if (iDelta < (INT64_C(1) << (iShift + WHEEL_LEVEL_BITS)))
+        {
+            return Level(iLevel, tWhen >> iShift);
+        }
+        iShift += WHEEL_LEVEL_BITS;
+    }
+
+    INT64 iMaxDelta = (INT64_C(1) << (iShift + WHEEL_LEVEL_BITS)) - 1;
+    if (iMaxDelta < iDelta)
+    {
+        tWhen = m_tCurrent + iMaxDelta;
+    }
+    return Level(WHEEL_LEVELS-1, tWhen >> iShift);
+}
+
+void CTaskWheel::Place(PTASK_RECORD pTask)
+{
+    CTaskList *pList = Slot(WheelTick(pTask->ltaWhen));
+    pList->Append(pTask);
+    m_anTasks[pList->m_iLevel]++;
+    m_nTasks++;
+}
+
+void CTaskWheel::Insert(PTASK_RECORD pTask)
+{
+    if (0 == m_nTasks)
+    {
+        // With nothing pending, the wheel can be brought up to date for
+        // free.
+        //
+        CLinearTimeAbsolute ltaNow;
+        ltaNow.GetUTC();
+        INT64 tNow = WheelTick(ltaNow);
+        if (m_tCurrent < tNow)
+        {
+            m_tCurrent = tNow;
+        }
+    }
+    Place(pTask);
+}
+
+void CTaskWheel::Remove(PTASK_RECORD pTask)
+{
+    CTaskList *pList = pTask->m_pList;
+    m_anTasks[pList->m_iLevel]--;
+    m_nTasks--;
+    pList->Remove(pTask);
+}
+
+// Spread the tasks in a slot of a higher level over the levels below it.
+//
+void CTaskWheel::Cascade(CTaskList *pList)
+{
+    PTASK_RECORD pTask;
+    while (nullptr != (pTask = pList->m_pHead))
+    {
+        Remove(pTask);
+        Place(pTask);
+    }
+}
+
+// Move the current tick forward by at least one, but not past tNow.
+//
+void CTaskWheel::Advance(INT64 tNow)
+{
+    if (0 < m_anTasks[0])
+    {
+        m_tCurrent++;
+    }
+    else
+    {
+        // Skip to the next boundary where a slot on a higher level might
+        // need to be cascaded.
+        //
+        int iShift = WHEEL_ROOT_BITS;
+        for (int iLevel = 1; iLevel < WHEEL_LEVELS-1; iLevel++)
+        {
+            if (0 < m_anTasks[iLevel])
+            {
+                break;
+            }
+            iShift += WHEEL_LEVEL_BITS;
+        }
+
+        INT64 tNext = (m_tCurrent | ((INT64_C(1) << iShift) - 1)) + 1;
+        if (tNow < tNext)
+        {
+            m_tCurrent = tNow;
+            return;
+        }
+        m_tCurrent = tNext;
+    }
+
+    if (0 == (m_tCurrent & (WHEEL_ROOT_SIZE-1)))
+    {
+        int iShift = WHEEL_ROOT_BITS;
+        for (int iLevel = 1; iLevel < WHEEL_LEVELS; iLevel++)
+        {
+            INT64 iSlot = (m_tCurrent >> iShift) & (WHEEL_LEVEL_SIZE-1);
+            Cascade(Level(iLevel, iSlot));
+            if (0 != iSlot)
+            {
+                break;
+            }
+            iShift += WHEEL_LEVEL_BITS;
+        }
+    }
+}
+
+// Remove a task which is due before ltaNow, or return nullptr if there are
+// none.
+//
+PTASK_RECORD CTaskWheel::RemoveExpired(const CLinearTimeAbsolute& ltaNow)
+{
+    INT64 tNow = WheelTick(ltaNow);
+    for (;;)
+    {
+        if (0 == m_nTasks)
+        {
+            if (m_tCurrent < tNow)
+            {
+                m_tCurrent = tNow;
+            }
+            return nullptr;
+        }
+
+        CTaskList *pList = &m_aLists[m_tCurrent & (WHEEL_ROOT_SIZE-1)];
+        if (m_tCurrent < tNow)
+        {
+            // Everything in a slot behind the current time is due.
+            //
+            PTASK_RECORD pTask = pList->m_pHead;
+            if (nullptr != pTask)
+            {
+                Remove(pTask);
+                return pTask;
+            }
+            Advance(tNow);
+        }
+        else
+        {
+            // Only some of the tasks in the current slot may be due.
+            //
+            for (PTASK_RECORD pTask = pList->m_pHead; nullptr != pTask; pTask = pTask->m_pNext)
+            {
+                if (pTask->ltaWhen < ltaNow)
+                {
+                    Remove(pTask);
+                    return pTask;
+                }
+            }
+            return nullptr;
+        }
+    }
+}
+
+bool CTaskWheel::WhenNext(CLinearTimeAbsolute *pltaWhen)
+{
+    if (0 == m_nTasks)
+    {
+        return false;
+    }
+
+    bool bFound = false;
+    if (0 < m_anTasks[0])
+    {
+        // The first occupied slot on the first level holds its earliest
+        // tasks.
+        //
+        for (int i = 0; i < WHEEL_ROOT_SIZE; i++)
+        {
+            CTaskList *pList = &m_aLists[(m_tCurrent + i) & (WHEEL_ROOT_SIZE-1)];
+            PTASK_RECORD pTask = pList->m_pHead;
+            if (nullptr != pTask)
+            {
+                *pltaWhen = pTask->ltaWhen;
+                for (pTask = pTask->m_pNext; nullptr != pTask; pTask = pTask->m_pNext)
+                {
+                    if (pTask->ltaWhen < *pltaWhen)
+                    {
+                        *pltaWhen = pTask->ltaWhen;
+                    }
+                }
+                bFound = true;
+                break;
+            }
+        }
+    }
+
+    // A task placed on a higher level before the first level filled up can
+    // be due sooner than anything on the first level, so also wake up at the
+    // start of the earliest occupied slot on a higher level. That slot is
+    // cascaded then, and a better answer is available.
+    //
+    bool  bFoundSlot = false;
+    INT64 tEarliest = 0;
+    int   iShift = WHEEL_ROOT_BITS;
+    for (int iLevel = 1; iLevel < WHEEL_LEVELS; iLevel++)
+    {
+        if (0 < m_anTasks[iLevel])
+        {
+            INT64 tSlot = m_tCurrent >> iShift;
+            for (int i = 1; i <= WHEEL_LEVEL_SIZE; i++)
+            {
+                if (nullptr != Level(iLevel, tSlot + i)->m_pHead)
+                {
+                    INT64 t = (tSlot + i) << iShift;
+                    if (  !bFoundSlot
+                       || t < tEarliest)
+                    {
+                        tEarliest = t;
+                        bFoundSlot = true;
+                    }
+                    break;
+                }
+            }
+        }
+        iShift += WHEEL_LEVEL_BITS;
+    }
+
+    if (bFoundSlot)
+    {
+        CLinearTimeAbsolute ltaSlot;
+        ltaSlot.Set100ns(tEarliest << WHEEL_TICK_SHIFT);
+        if (  !bFound
+           || ltaSlot < *pltaWhen)
+        {
+            *pltaWhen = ltaSlot;
+            bFound = true;
+        }
+    }
+    return bFound;
+}
+
+void CTaskWheel::CancelTask(FTASK *fpTask, void *arg_voidptr, int arg_Integer)
+{
+    for (int i = 0; i < WHEEL_LISTS; i++)
+    {
+        for (PTASK_RECORD p = m_aLists[i].m_pHead; nullptr != p; p = p->m_pNext)
+        {
+            if (  p->fpTask == fpTask
+               && p->arg_voidptr == arg_voidptr
+               && p->arg_Integer == arg_Integer)
+            {
+                p->fpTask = nullptr;
+            }
+        }
+    }
+}
+
+int CTaskWheel::Collect(PTASK_RECORD *aTasks)
+{
+    int nTasks = 0;
+    for (int i = 0; i < WHEEL_LISTS; i++)
+    {
+        for (PTASK_RECORD p = m_aLists[i].m_pHead; nullptr != p; p = p->m_pNext)
+        {
+            aTasks[nTasks++] = p;
+        }
+    }
+    return nTasks;
+}
+
+static int ComparePriority(PTASK_RECORD pTaskA, PTASK_RECORD pTaskB)
+{
+    int i = (pTaskA->iPriority) - (pTaskB->iPriority);
+    if (i == 0)
+    {
+        // Must subtract so that ticket rollover is handled properly.
+        //
+        return  (pTaskA->m_Ticket) - (pTaskB->m_Ticket);
+    }
+    return i;
+}
+
+static int CompareWhen(PTASK_RECORD pTaskA, PTASK_RECORD pTaskB)
+{
+    // Can't simply subtract because comparing involves a truncation cast.
+    //
+    if (pTaskA->ltaWhen < pTaskB->ltaWhen)
+    {
+        return -1;
+    }
+    else if (pTaskA->ltaWhen > pTaskB->ltaWhen)
+    {
+        return 1;
+    }
+    else
+    {
+        // Must subtract so that ticket rollover is handled properly.
+        //
+        return  (pTaskA->m_Ticket) - (pTaskB->m_Ticket);
+    }
+}
+
+static int CompareTaskPriority(const void *pA, const void *pB)
+{
+    return ComparePriority(*(PTASK_RECORD *)pA, *(PTASK_RECORD *)pB);
+}
+
+static int CompareTaskWhen(const void *pA, const void *pB)
+{
+    return CompareWhen(*(PTASK_RECORD *)pA, *(PTASK_RECORD *)pB);
+}
+
+CScheduler::CScheduler(void)
+{
+    m_Ticket = 0;
+    m_ReadyTicket = 0;
+    m_minPriority = PRIORITY_CF_DEQUEUE_ENABLED;
+}
+
+CScheduler::~CScheduler(void)
+{
+    PTASK_RECORD pTask;
+    while (nullptr != (pTask = m_Immediate.m_pHead))
+    {
+        m_Immediate.Remove(pTask);
+        delete pTask;
+    }
+}
+
+CTaskFairQueue *CScheduler::FairQueue(int iPriority)
+{
+    switch (iPriority)
+    {
+    case PRIORITY_PLAYER:
+        return &m_aFair[0];
+
+    case PRIORITY_OBJECT:
+        return &m_aFair[1];
+    }
+    return nullptr;
+}
+
+// An immediate task becomes ready to run at the first ReadyTasks() after it
+// is scheduled.
+//
+bool CScheduler::IsReady(PTASK_RECORD pTask)
+{
+    // Must subtract so that ticket rollover is handled properly.
+    //
+    return (pTask->m_Ticket - m_ReadyTicket) < 0;
+}
+
+// Put a ready task where RunTasks() will find it.
+//
+void CScheduler::Ready(PTASK_RECORD pTask)
+{
+    CTaskFairQueue *pQueue = FairQueue(pTask->iPriority);
+    if (nullptr != pQueue)
+    {
+        pQueue->Append(pTask, true);
+    }
+    else if (!m_PriorityHeap.Insert(pTask, ComparePriority))
+    {
+        delete pTask;
+    }
+}
+
+PTASK_RECORD CScheduler::DeferTask(const CLinearTimeAbsolute& ltaWhen, int iPriority,
+                                   FTASK *fpTask, void *arg_voidptr, int arg_Integer,
+                                   int iGroup, int iWeight)
+{
+    PTASK_RECORD pTask = new TASK_RECORD;
+    if (!pTask) return nullptr;
+
+    pTask->ltaWhen = ltaWhen;
+    pTask->iPriority = iPriority;
+    pTask->fpTask = fpTask;
+    pTask->arg_voidptr = arg_voidptr;
+    pTask->arg_Integer = arg_Integer;
+    pTask->m_Ticket = m_Ticket++;
+    pTask->m_iHeapIndex = -1;
+    pTask->m_iGroup = iGroup;
+    pTask->m_iWeight = iWeight;
+    pTask->m_pList = nullptr;
+
+    // Must add to the timer wheel so that network is still serviced.
+    //
+    m_Wheel.Insert(pTask);
+    return pTask;
+}
+
+PTASK_RECORD CScheduler::DeferImmediateTask(int iPriority, FTASK *fpTask, void *arg_voidptr, int arg_Integer,
+                                            int iGroup, int iWeight)
+{
+    PTASK_RECORD pTask = new TASK_RECORD;
+    if (!pTask) return nullptr;
+
+    //pTask->ltaWhen = ltaWhen;
+    pTask->iPriority = iPriority;
+    pTask->fpTask = fpTask;
+    pTask->arg_voidptr = arg_voidptr;
+    pTask->arg_Integer = arg_Integer;
+    pTask->m_Ticket = m_Ticket++;
+    pTask->m_iHeapIndex = -1;
+    pTask->m_iGroup = iGroup;
+    pTask->m_iWeight = iWeight;
+    pTask->m_pList = nullptr;
+
+    // Must wait for ReadyTasks() so that network is still serviced.
+    //
+    CTaskFairQueue *pQueue = FairQueue(iPriority);
+    if (nullptr != pQueue)
+    {
+        pQueue->Append(pTask, false);
+    }
+    else if (PRIORITY_SYSTEM == iPriority)
+    {
+        m_Immediate.Append(pTask);
+    }
+    else
+    {
+        m_Wheel.Insert(pTask);
+    }
+    return pTask;
+}
+
+void CScheduler::CancelTask(FTASK *fpTask, void *arg_voidptr, int arg_Integer)
+{
+    m_Wheel.CancelTask(fpTask, arg_voidptr, arg_Integer);
+    for (PTASK_RECORD p = m_Immediate.m_pHead; nullptr != p; p = p->m_pNext)
+    {
+        if (  p->fpTask == fpTask
+           && p->arg_voidptr == arg_voidptr
+           && p->arg_Integer == arg_Integer)
+        {
+            p->fpTask = nullptr;
+        }
+    }
+    for (int i = 0; i < NUM_FAIR; i++)
+    {
+        m_aFair[i].CancelTask(fpTask, arg_voidptr, arg_Integer);
+    }
+    m_PriorityHeap.CancelTask(fpTask, arg_voidptr, arg_Integer);
+}
+
+void CScheduler::ReadyTasks(const CLinearTimeAbsolute& ltaNow)
+{
+    // Everything scheduled as immediate so far is ready to run.
+    //
+    m_ReadyTicket = m_Ticket;
+    for (int i = 0; i < NUM_FAIR; i++)
+    {
+        m_aFair[i].MakeReady();
+    }
+
+    // Move ready-to-run tasks off the timer wheel and onto the PriorityHeap
+    // or into their groups.
+    //
+    PTASK_RECORD pTask;
+    while (nullptr != (pTask = m_Wheel.RemoveExpired(ltaNow)))
+    {
+        if (nullptr == pTask->fpTask)
+        {
+            delete pTask;
+        }
+        else
+        {
+            Ready(pTask);
+        }
+    }
+}
+
+int CScheduler::RunTasks(const CLinearTimeAbsolute& ltaNow)
+{
+    ReadyTasks(ltaNow);
+    if (mudconf.active_q_chunk)
+    {
+        return RunTasks(mudconf.active_q_chunk);
+    }
+    else
+    {
+        return RunAllTasks();
+    }
+}
+
+// Find the ready task with the lowest priority and ticket. Within
+// PRIORITY_PLAYER and PRIORITY_OBJECT, the candidate is the task whose group
+// has the turn.
+//
+PTASK_RECORD CScheduler::PeekAtNext(void)
+{
+    PTASK_RECORD pNext = m_PriorityHeap.PeekAtTopmost();
+    PTASK_RECORD pTask = m_Immediate.m_pHead;
+    if (  nullptr != pTask
+       && IsReady(pTask)
+       && (  nullptr == pNext
+          || ComparePriority(pTask, pNext) < 0))
+    {
+        pNext = pTask;
+    }
+    for (int i = 0; i < NUM_FAIR; i++)
+    {
+        pTask = m_aFair[i].PeekAtNext();
+        if (  nullptr != pTask
+           && (  nullptr == pNext
+              || ComparePriority(pTask, pNext) < 0))
+        {
+            pNext = pTask;
+        }
+    }
+    return pNext;
+}
+
+int CScheduler::RunTasks(int iCount)
+{
+    int nTasks = 0;
+    while (iCount--)
+    {
+        PTASK_RECORD pTask = PeekAtNext();
+        if (!pTask) break;
+
+        if (pTask->iPriority > m_minPriority)
+        {
+            // This is related to CF_DEQUEUE and also to untimed (SUSPENDED)
+            // semaphore entries that we would like to manage together with
+            // the timed ones.
+            //
+            break;
+        }
+
+        if (nullptr != pTask->m_pList)
+        {
+            Unlink(pTask);
+        }
+        else
+        {
+            m_PriorityHeap.RemoveTopmost(ComparePriority);
+        }
+
+        if (pTask->fpTask)
+        {
+            pTask->fpTask(pTask->arg_voidptr, pTask->arg_Integer);
+            nTasks++;
+        }
+        delete pTask;
+    }
+    return nTasks;
+}
+
+int CScheduler::RunAllTasks(void)
+{
+    int nTotalTasks = 0;
+
+    int nTasks;
+    do
+    {
+        nTasks = RunTasks(100);
+        nTotalTasks += nTasks;
+    } while (nTasks);
+
+    return nTotalTasks;
+}
+
+bool CScheduler::WhenNext(CLinearTimeAbsolute  *ltaWhen)
+{
+    // Check the ready tasks first.
+    //
+    PTASK_RECORD pTask = PeekAtNext();
+    if (pTask)
+    {
+        if (pTask->iPriority <= m_minPriority)
+        {
+            ltaWhen->SetSeconds(0);
+            return true;
+        }
+    }
+
+    // Immediate tasks which are not ready yet will be at the next
+    // ReadyTasks().
+    //
+    pTask = m_Immediate.m_pTail;
+    if (  nullptr != pTask
+       && !IsReady(pTask))
+    {
+        ltaWhen->SetSeconds(0);
+        return true;
+    }
+    for (int i = 0; i < NUM_FAIR; i++)
+    {
+        if (m_aFair[i].IsPending())
+        {
+            ltaWhen->SetSeconds(0);
+            return true;
+        }
+    }
+
+    // Check the timer wheel next.
+    //
+    return m_Wheel.WhenNext(ltaWhen);
+}
+
+#define HEAP_LEFT_CHILD(x) (2*(x)+1)
+#define HEAP_RIGHT_CHILD(x) (2*(x)+2)
+#define HEAP_PARENT(x) (((x)-1)/2)
+
+void CTaskHeap::SiftDown(int iSubRoot, SCHCMP *pfCompare)
+{
+    int parent = iSubRoot;
+    int child = HEAP_LEFT_CHILD(parent);
+
+    PTASK_RECORD Ref = m_pHeap[parent];
+
+    while (child < m_nCurrent)
+    {
+        int rightchild = HEAP_RIGHT_CHILD(parent);
+        if (rightchild < m_nCurrent)
+        {
+            if (pfCompare(m_pHeap[rightchild], m_pHeap[child]) < 0)
+            {
+                child = rightchild;
+            }
+        }
+        if (pfCompare(Ref, m_pHeap[child]) <= 0)
+            break;
+
+        m_pHeap[parent] = m_pHeap[child];
+        m_pHeap[parent]->m_iHeapIndex = parent;
+        parent = child;
+        child = HEAP_LEFT_CHILD(parent);
+    }
+    m_pHeap[parent] = Ref;
+    Ref->m_iHeapIndex = parent;
+}
+
+void CTaskHeap::SiftUp(int child, SCHCMP *pfCompare)
 {
     while (child)
     {
@@ -694,6 +1522,8 @@ void CTaskHeap::SiftUp(int child, SCHCMP *pfCompare)
         Tmp = m_pHeap[child];
         m_pHeap[child] = m_pHeap[parent];
         m_pHeap[parent] = Tmp;
+        m_pHeap[child]->m_iHeapIndex = child;
+        Tmp->m_iHeapIndex = parent;
 
         child = parent;
     }
@@ -704,11 +1534,16 @@ PTASK_RECORD CTaskHeap::Remove(int iNode, SCHCMP *pfCompare)
     if (iNode < 0 || m_nCurrent <= iNode) return nullptr;
 
     PTASK_RECORD pTask = m_pHeap[iNode];
+    pTask->m_iHeapIndex = -1;
 
     m_nCurrent--;
-    m_pHeap[iNode] = m_pHeap[m_nCurrent];
-    SiftDown(iNode, pfCompare);
-    SiftUp(iNode, pfCompare);
+    if (iNode < m_nCurrent)
+    {
+        m_pHeap[iNode] = m_pHeap[m_nCurrent];
+        m_pHeap[iNode]->m_iHeapIndex = iNode;
+        SiftDown(iNode, pfCompare);
+        SiftUp(iNode, pfCompare);
+    }
 
     return pTask;
 }
@@ -724,18 +1559,335 @@ void CTaskHeap::Update(int iNode, SCHCMP *pfCompare)
     SiftUp(iNode, pfCompare);
 }
 
+void CTaskHeap::RemoveTask(PTASK_RECORD pTask, SCHCMP *pfCompare)
+{
+    Remove(pTask->m_iHeapIndex, pfCompare);
+}
+
+void CTaskHeap::UpdateTask(PTASK_RECORD pTask, SCHCMP *pfCompare)
+{
+    Update(pTask->m_iHeapIndex, pfCompare);
+}
+
+// Take a task from the timer wheel, the immediate FIFO, or its group.
+//
+void CScheduler::Unlink(PTASK_RECORD pTask)
+{
+    CTaskList *pList = pTask->m_pList;
+    if (LIST_GROUP == pList->m_iLevel)
+    {
+        static_cast<CTaskGroup *>(pList)->m_pQueue->Remove(pTask, m_ReadyTicket);
+    }
+    else if (LIST_FIFO == pList->m_iLevel)
+    {
+        pList->Remove(pTask);
+    }
+    else
+    {
+        m_Wheel.Remove(pTask);
+    }
+}
+
+// Put a task from the timer wheel, the immediate FIFO, or a group where it
+// belongs after a traversal has changed its time or priority.
+//
+void CScheduler::Relocate(PTASK_RECORD pTask)
+{
+    bool bImmediate = (pTask->m_pList->m_iLevel < 0);
+    Unlink(pTask);
+    if (  bImmediate
+       && IsReady(pTask))
+    {
+        Ready(pTask);
+    }
+    else
+    {
+        m_Wheel.Insert(pTask);
+    }
+}
+
+// Remove and delete a task which has not run yet, wherever it is.
+//
+void CScheduler::RemoveTask(PTASK_RECORD pTask)
+{
+    if (nullptr != pTask->m_pList)
+    {
+        Unlink(pTask);
+    }
+    else
+    {
+        m_PriorityHeap.RemoveTask(pTask, ComparePriority);
+    }
+    delete pTask;
+}
+
+// Put a task where it belongs after its time or priority has changed.
+//
+void CScheduler::UpdateTask(PTASK_RECORD pTask)
+{
+    if (nullptr != pTask->m_pList)
+    {
+        Relocate(pTask);
+    }
+    else if (nullptr != FairQueue(pTask->iPriority))
+    {
+        m_PriorityHeap.RemoveTask(pTask, ComparePriority);
+        Ready(pTask);
+    }
+    else
+    {
+        m_PriorityHeap.UpdateTask(pTask, ComparePriority);
+    }
+}
+
+// Tasks in a group are moved to the group of their new owner.  Elsewhere,
+// the group and weight are only recorded until the task becomes ready.
+//
+void CScheduler::RegroupTask(PTASK_RECORD pTask, int iGroup, int iWeight)
+{
+    CTaskFairQueue *pQueue = FairQueue(pTask->iPriority);
+    if (  nullptr != pQueue
+       && nullptr != pTask->m_pList
+       && LIST_GROUP == pTask->m_pList->m_iLevel)
+    {
+        pQueue->Regroup(pTask, iGroup, iWeight, m_ReadyTicket);
+    }
+    else
+    {
+        pTask->m_iGroup = iGroup;
+        pTask->m_iWeight = iWeight;
+    }
+}
+
+// Gather tasks for a traversal. Ready tasks are those on the PriorityHeap
+// (if bHeap) and the ready ones in the immediate FIFO and groups (if
+// bReady). Waiting tasks are the rest of the immediate FIFO and groups and
+// the timer wheel. A non-zero iPriority
+// limits the gathering to tasks at that priority.
+//
+int CScheduler::Collect(PTASK_RECORD **paTasks, bool bHeap, bool bReady, bool bWaiting, int iPriority)
+{
+    int nAlloc = 0;
+    if (bHeap)
+    {
+        nAlloc += m_PriorityHeap.Count();
+    }
+    nAlloc += m_Immediate.m_nTasks;
+    for (int i = 0; i < NUM_FAIR; i++)
+    {
+        nAlloc += m_aFair[i].Count();
+    }
+    if (bWaiting)
+    {
+        nAlloc += m_Wheel.Count();
+    }
+
+    *paTasks = nullptr;
+    if (0 == nAlloc)
+    {
+        return 0;
+    }
+    PTASK_RECORD *aTasks = (PTASK_RECORD *)MEMALLOC(nAlloc * sizeof(PTASK_RECORD));
+    ISOUTOFMEMORY(aTasks);
+
+    int nTasks = 0;
+    if (bHeap)
+    {
+        for (int i = 0; i < m_PriorityHeap.Count(); i++)
+        {
+            aTasks[nTasks++] = m_PriorityHeap.GetTask(i);
+        }
+    }
+    for (PTASK_RECORD p = m_Immediate.m_pHead; nullptr != p; p = p->m_pNext)
+    {
+        if (IsReady(p) ? bReady : bWaiting)
+        {
+            aTasks[nTasks++] = p;
+        }
+    }
+    for (int i = 0; i < NUM_FAIR; i++)
+    {
+        int iFirst = nTasks;
+        int nGroup = m_aFair[i].Collect(aTasks + iFirst);
+        for (int j = 0; j < nGroup; j++)
+        {
+            PTASK_RECORD p = aTasks[iFirst + j];
+            if (IsReady(p) ? bReady : bWaiting)
+            {
+                aTasks[nTasks++] = p;
+            }
+        }
+    }
+    if (bWaiting)
+    {
+        nTasks += m_Wheel.Collect(aTasks + nTasks);
+    }
+
+    if (0 != iPriority)
+    {
+        int nKept = 0;
+        for (int i = 0; i < nTasks; i++)
+        {
+            if (iPriority == aTasks[i]->iPriority)
+            {
+                aTasks[nKept++] = aTasks[i];
+            }
+        }
+        nTasks = nKept;
+    }
+    *paTasks = aTasks;
+    return nTasks;
+}
+
+// Tasks on the timer wheel and in the immediate FIFOs are visited from a
+// snapshot, so that tasks which move during the traversal are neither
+// missed nor visited twice.
+//
 void CScheduler::TraverseUnordered(SCHLOOK *pfLook)
 {
-    if (m_WhenHeap.TraverseUnordered(pfLook, CompareWhen))
+    if (!m_PriorityHeap.TraverseUnordered(pfLook, ComparePriority))
+    {
+        return;
+    }
+
+    PTASK_RECORD *aTasks;
+    int nTasks = Collect(&aTasks, false, true, true, 0);
+    for (int i = 0; i < nTasks; i++)
+    {
+        PTASK_RECORD p = aTasks[i];
+        int cmd = pfLook(p);
+        if (IU_DONE == cmd)
+        {
+            break;
+        }
+        else if (IU_REMOVE_TASK == cmd)
+        {
+            Unlink(p);
+            delete p;
+        }
+        else if (IU_UPDATE_TASK == cmd)
+        {
+            Relocate(p);
+        }
+    }
+
+    if (nullptr != aTasks)
     {
-        m_PriorityHeap.TraverseUnordered(pfLook, ComparePriority);
+        MEMFREE(aTasks);
+        aTasks = nullptr;
     }
 }
 
+// Ready tasks are visited in Priority-order, and then waiting tasks are
+// visited in When-order. Tasks cannot be removed during the traversal, but
+// they can be updated.
+//
 void CScheduler::TraverseOrdered(SCHLOOK *pfLook)
 {
-    m_PriorityHeap.TraverseOrdered(pfLook, ComparePriority);
-    m_WhenHeap.TraverseOrdered(pfLook, CompareWhen);
+    TraverseOrdered(pfLook, 0);
+}
+
+// As above, but only tasks at the given priority are visited.
+//
+void CScheduler::TraverseOrdered(SCHLOOK *pfLook, int iPriority)
+{
+    PTASK_RECORD *aTasks;
+    int nTasks = Collect(&aTasks, true, true, false, iPriority);
+    if (1 < nTasks)
+    {
+        qsort(aTasks, nTasks, sizeof(PTASK_RECORD), CompareTaskPriority);
+    }
+
+    bool bDone = false;
+    bool bRemake = false;
+    for (int i = 0; i < nTasks; i++)
+    {
+        PTASK_RECORD p = aTasks[i];
+        int cmd = pfLook(p);
+        if (IU_DONE == cmd)
+        {
+            bDone = true;
+            break;
+        }
+        else if (IU_UPDATE_TASK == cmd)
+        {
+            if (nullptr == p->m_pList)
+            {
+                bRemake = true;
+            }
+            else
+            {
+                Relocate(p);
+            }
+        }
+    }
+
+    if (bRemake)
+    {
+        m_PriorityHeap.Remake(ComparePriority);
+    }
+    if (nullptr != aTasks)
+    {
+        MEMFREE(aTasks);
+        aTasks = nullptr;
+    }
+    if (bDone)
+    {
+        return;
+    }
+
+    nTasks = Collect(&aTasks, false, false, true, iPriority);
+    if (1 < nTasks)
+    {
+        qsort(aTasks, nTasks, sizeof(PTASK_RECORD), CompareTaskWhen);
+    }
+    for (int i = 0; i < nTasks; i++)
+    {
+        PTASK_RECORD p = aTasks[i];
+        int cmd = pfLook(p);
+        if (IU_DONE == cmd)
+        {
+            break;
+        }
+        else if (IU_UPDATE_TASK == cmd)
+        {
+            Relocate(p);
+        }
+    }
+
+    if (nullptr != aTasks)
+    {
+        MEMFREE(aTasks);
+        aTasks = nullptr;
+    }
+}
+
+// Arrange tasks in the order TraverseOrdered() would visit them: ready tasks
+// in Priority-order, and then waiting tasks in When-order.
+//
+void CScheduler::SortTasks(PTASK_RECORD *aTasks, int nTasks)
+{
+    int nReady = 0;
+    for (int i = 0; i < nTasks; i++)
+    {
+        PTASK_RECORD p = aTasks[i];
+        if (  nullptr == p->m_pList
+           || (  p->m_pList->m_iLevel < 0
+              && IsReady(p)))
+        {
+            aTasks[i] = aTasks[nReady];
+            aTasks[nReady++] = p;
+        }
+    }
+
+    if (1 < nReady)
+    {
+        qsort(aTasks, nReady, sizeof(PTASK_RECORD), CompareTaskPriority);
+    }
+    if (1 < nTasks - nReady)
+    {
+        qsort(aTasks + nReady, nTasks - nReady, sizeof(PTASK_RECORD), CompareTaskWhen);
+    }
 }
 
 // The following guarantees that in spite of any changes to the heap
@@ -781,7 +1933,7 @@ int CTaskHeap::TraverseUnordered(SCHLOOK *pfLook, SCHCMP *pfCompare)
             switch (cmd)
             {
             case IU_REMOVE_TASK:
-                Remove(i, pfCompare);
+                delete Remove(i, pfCompare);
                 break;
 
             case IU_DONE:
@@ -825,7 +1977,9 @@ void CTaskHeap::Sort(SCHCMP *pfCompare)
     {
         PTASK_RECORD p = m_pHeap[m_nCurrent];
         m_pHeap[m_nCurrent] = m_pHeap[0];
+        m_pHeap[m_nCurrent]->m_iHeapIndex = m_nCurrent;
         m_pHeap[0] = p;
+        p->m_iHeapIndex = 0;
         SiftDown(0, pfCompare);
     }
     m_nCurrent = s_nCurrent;
@@ -849,6 +2003,5 @@ void CScheduler::SetMinPriority(int arg_minPriority)
 
 void CScheduler::Shrink(void)
 {
-    m_WhenHeap.Shrink();
     m_PriorityHeap.Shrink();
 }
@@ -13,6 +13,7 @@
 #include "attrs.h"
 #include "command.h"
 #include "functions.h"
+#include "journal.h"
 #include "vattr.h"
 
 static UTF8 *store_string(const UTF8 *);
@@ -84,6 +85,8 @@ ATTR *vattr_define_LEN(const UTF8 *pName, size_t nName, int number, int flags)
 
         anum_extend(vp->number);
         anum_set(vp->number, (ATTR *) vp);
+        journal_attr_name(vp);
+        db_vattrs_dirty = true;
     }
     else
     {
@@ -92,6 +95,45 @@ ATTR *vattr_define_LEN(const UTF8 *pName, size_t nName, int number, int flags)
     return vp;
 }
 
+// Like vattr_define_LEN, but the given number and name win.  Whatever
+// currently holds this number or this name gives way.  Used when replaying
+// changes on top of an existing set of attribute names.
+//
+ATTR *vattr_redefine_LEN(UTF8 *pName, size_t nName, int number, int flags)
+{
+    ATTR *vp;
+    if (number <= anum_alc_top)
+    {
+        vp = (ATTR *)anum_get(number);
+        if (  nullptr != vp
+           && strcmp((char *)vp->name, (char *)pName) != 0)
+        {
+            vattr_delete_LEN((UTF8 *)vp->name, strlen((char *)vp->name));
+        }
+    }
+
+    vp = vattr_find_LEN(pName, nName);
+    if (  nullptr != vp
+       && vp->number != number)
+    {
+        vattr_delete_LEN(pName, nName);
+    }
+
+    vp = vattr_define_LEN(pName, nName, number, flags);
+    if (nullptr != vp)
+    {
+        vp->flags = flags;
+        atr_resolve_flush();
+        lockcache_flush();
+    }
+
+    if (mudstate.attr_next <= number)
+    {
+        mudstate.attr_next = number + 1;
+    }
+    return vp;
+}
+
 // There are five data structures which must remain mutually consistent: The
 // attr_name_htab, vattr_name_htab, the anum_table, the A_LIST for every
 // object, and the attribute database.
@@ -410,6 +452,8 @@ static int dbclean_RemoveStaleAttributeNames(void)
             if ((AF_ISUSED & (va->flags)) != AF_ISUSED)
             {
                 anum_set(iAttr, nullptr);
+                journal_attr_delete(iAttr);
+                db_vattrs_dirty = true;
 
                 // Delete from hashtable.
                 //
@@ -497,6 +541,8 @@ static void dbclean_RenumberAttributes(int cVAttributes)
             va->number = iAllocated;
             anum_set(iAllocated, (ATTR *)va);
             anum_set(iAttr, nullptr);
+            journal_attr_name(va);
+            db_vattrs_dirty = true;
             mudstate.attr_next = iAttr;
         }
     }
@@ -651,6 +697,8 @@ void vattr_delete_LEN(UTF8 *pName, size_t nName)
         {
             ATTR *vp = (ATTR *)anum_table[anum];
             anum_set(anum, nullptr);
+            journal_attr_delete(anum);
+            db_vattrs_dirty = true;
             pht->Remove(iDir);
             MEMFREE(vp);
             vp = nullptr;
@@ -682,6 +730,8 @@ ATTR *vattr_rename_LEN(UTF8 *pOldName, size_t nOldName, UTF8 *pNewName, size_t n
             vp->name = store_string(pNewName);
             nHash = HASH_ProcessBuffer(0, pNewName, nNewName);
             pht->Insert(sizeof(int), nHash, &anum);
+            journal_attr_name(vp);
+            db_vattrs_dirty = true;
             return (ATTR *)anum_table[anum];
         }
         iDir = pht->FindNextKey(iDir, nHash);
@@ -112,8 +112,27 @@ void do_find(dbref executor, dbref caller, dbref enactor, int eval, int key, UTF
 
     dbref i, low_bound, high_bound;
     parse_range(&name, &low_bound, &high_bound);
-    for (i = low_bound; i <= high_bound; i++)
+
+    // A name narrows the candidates to one bucket of the name index.
+    //
+    dbref *aCandidates;
+    int nCandidates = name_index_gather(name, &aCandidates);
+    bool bIndexed = (0 <= nCandidates);
+    if (  !bIndexed
+       && low_bound <= high_bound)
+    {
+        nCandidates = high_bound - low_bound + 1;
+    }
+
+    for (int k = 0; k < nCandidates; k++)
     {
+        i = bIndexed ? aCandidates[k] : low_bound + k;
+        if (  i < low_bound
+           || high_bound < i)
+        {
+            continue;
+        }
+
         if (  (Typeof(i) != TYPE_EXIT)
            && Controls(executor, i)
            && (!*name || string_match(PureName(i), name)))
@@ -123,6 +142,10 @@ void do_find(dbref executor, dbref caller, dbref enactor, int eval, int key, UTF
             free_lbuf(buff);
         }
     }
+    if (nullptr != aCandidates)
+    {
+        MEMFREE(aCandidates);
+    }
     notify(executor, T("***End of List***"));
 }
 
@@ -153,45 +176,56 @@ bool get_stats(dbref player, dbref who, STATS *info)
     info->s_players = 0;
     info->s_garbage = 0;
 
-    dbref i;
-    DO_WHOLE_DB(i)
+    // A player's objects come from the owner index.
+    //
+    dbref *aOwned = nullptr;
+    int nOwned = 0;
+    if (NOTHING != who)
+    {
+        nOwned = db_index_gather(DBI_OWNER, who, &aOwned);
+    }
+
+    int nCount = (NOTHING == who) ? mudstate.db_top : nOwned;
+    for (int k = 0; k < nCount; k++)
     {
-        if ((who == NOTHING) || (who == Owner(i)))
+        dbref i = (NOTHING == who) ? k : aOwned[k];
+        info->s_total++;
+        if (Going(i) && (Typeof(i) != TYPE_ROOM))
         {
-            info->s_total++;
-            if (Going(i) && (Typeof(i) != TYPE_ROOM))
-            {
-                info->s_garbage++;
-                continue;
-            }
-            switch (Typeof(i))
-            {
-            case TYPE_ROOM:
+            info->s_garbage++;
+            continue;
+        }
+        switch (Typeof(i))
+        {
+        case TYPE_ROOM:
 
-                info->s_rooms++;
-                break;
+            info->s_rooms++;
+            break;
 
-            case TYPE_EXIT:
+        case TYPE_EXIT:
 
-                info->s_exits++;
-                break;
+            info->s_exits++;
+            break;
 
-            case TYPE_THING:
+        case TYPE_THING:
 
-                info->s_things++;
-                break;
+            info->s_things++;
+            break;
 
-            case TYPE_PLAYER:
+        case TYPE_PLAYER:
 
-                info->s_players++;
-                break;
+            info->s_players++;
+            break;
 
-            default:
+        default:
 
-                info->s_garbage++;
-            }
+            info->s_garbage++;
         }
     }
+    if (nullptr != aOwned)
+    {
+        MEMFREE(aOwned);
+    }
     return true;
 }
 
@@ -288,10 +322,15 @@ int chown_all(dbref from_player, dbref to_player, dbref acting_player, int key)
 
         TranslateFlags_Chown(clearflags.word, setflags.word, &bClearPowers, acting_player, key);
 
-        DO_WHOLE_DB(i)
+        // Work from a copy of the owner index, since @chown moves each
+        // object to another list.
+        //
+        dbref *aOwned;
+        int nOwned = db_index_gather(DBI_OWNER, from_player, &aOwned);
+        for (int k = 0; k < nOwned; k++)
         {
-            if (  Owner(i) == from_player
-               && Owner(i) != i)
+            i = aOwned[k];
+            if (Owner(i) != i)
             {
                 switch (Typeof(i))
                 {
@@ -346,6 +385,10 @@ int chown_all(dbref from_player, dbref to_player, dbref acting_player, int key)
                 count++;
             }
         }
+        if (nullptr != aOwned)
+        {
+            MEMFREE(aOwned);
+        }
         add_quota(from_player, quota_out);
         add_quota(to_player, quota_in);
     }
@@ -785,9 +828,66 @@ void search_perform(dbref executor, dbref caller, dbref enactor, SEARCH *parm)
     UTF8 *buff = alloc_sbuf("search_perform.num");
     int save_invk_ctr = mudstate.func_invk_ctr;
 
+    // A parent, zone, or owner restriction narrows the candidates to one of
+    // the object indexes, and a name narrows them to one bucket of the name
+    // index.  Use whichever is smaller.  Otherwise, walk the whole range.
+    //
+    dbref *aCandidates = nullptr;
+    int nCandidates = -1;
+    if (NOTHING != parm->s_parent)
+    {
+        nCandidates = db_index_gather(DBI_PARENT, parm->s_parent, &aCandidates);
+    }
+    else if (NOTHING != parm->s_zone)
+    {
+        nCandidates = db_index_gather(DBI_ZONE, parm->s_zone, &aCandidates);
+    }
+    else if (ANY_OWNER != parm->s_rst_owner)
+    {
+        nCandidates = db_index_gather(DBI_OWNER, parm->s_rst_owner, &aCandidates);
+    }
+
+    dbref *aNamed;
+    int nNamed = name_index_gather(parm->s_rst_name, &aNamed);
+    if (  0 <= nNamed
+       && (  nCandidates < 0
+          || nNamed < nCandidates))
+    {
+        if (nullptr != aCandidates)
+        {
+            MEMFREE(aCandidates);
+        }
+        aCandidates = aNamed;
+        nCandidates = nNamed;
+    }
+    else if (nullptr != aNamed)
+    {
+        MEMFREE(aNamed);
+    }
+
+    bool bIndexed = (0 <= nCandidates);
+    if (  !bIndexed
+       && parm->low_bound <= parm->high_bound)
+    {
+        nCandidates = parm->high_bound - parm->low_bound + 1;
+    }
+
     dbref thing;
-    for (thing = parm->low_bound; thing <= parm->high_bound; thing++)
+    for (int k = 0; k < nCandidates; k++)
     {
+        if (bIndexed)
+        {
+            thing = aCandidates[k];
+            if (  thing < parm->low_bound
+               || parm->high_bound < thing)
+            {
+                continue;
+            }
+        }
+        else
+        {
+            thing = parm->low_bound + k;
+        }
         mudstate.func_invk_ctr = save_invk_ctr;
 
         // Check for matching type.
@@ -891,6 +991,10 @@ void search_perform(dbref executor, dbref caller, dbref enactor, SEARCH *parm)
         //
         olist_add(thing);
     }
+    if (nullptr != aCandidates)
+    {
+        MEMFREE(aCandidates);
+    }
     free_sbuf(buff);
     mudstate.func_invk_ctr = save_invk_ctr;
 }
@@ -437,6 +437,7 @@ void do_toad
     s_Flags(victim, FLAG_WORD1, TYPE_THING | HALT);
     s_Flags(victim, FLAG_WORD2, 0);
     s_Flags(victim, FLAG_WORD3, 0);
+    hearlist_touch(victim);
     s_Pennies(victim, 1);
 
     // Notify people.
@@ -692,6 +693,9 @@ void do_cut(dbref executor, dbref caller, dbref enactor, int eval, int key, UTF8
     if (Good_obj(object))
     {
         s_Next(object, NOTHING);
+        db_link_lists();
+        hearlist_drop_all();
+        exitindex_drop_all();
         notify_quiet(executor, T("Cut."));
     }
 }
@@ -838,6 +842,10 @@ void do_global(dbref executor, dbref caller, dbref enactor, int eval, int key, U
             scheduler.SetMinPriority(PRIORITY_CF_DEQUEUE_ENABLED);
         }
         mudconf.control_flags |= flagvalue;
+        if (flagvalue == CF_IDLECHECK)
+        {
+            desc_recheck_idle_all();
+        }
         STARTLOG(LOG_CONFIGMODS, "CFG", "GLOBAL");
         log_name(executor);
         log_text(T(" enabled: "));